@@ -4,5 +4,5 @@
 
 USER_OBJS :=
 
-LIBS := -lCUnit
+LIBS := -lCUnit -lpthread -lm
 
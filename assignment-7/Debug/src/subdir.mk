@@ -4,28 +4,67 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../src/bloom_filter.c \
+../src/concurrent_hash_map.c \
+../src/disk_hash_map.c \
+../src/epoch_hash_map.c \
+../src/frozen_hash_map.c \
 ../src/hash_map.c \
 ../src/hash_map_iterator.c \
+../src/hash_map_open.c \
+../src/hash_map_open_iterator.c \
+../src/hash_map_snapshot.c \
 ../src/hash_set.c \
 ../src/hash_set_iterator.c \
 ../src/hash_set_main.c \
-../src/map_entry.c 
+../src/hyper_log_log.c \
+../src/int_hash_map.c \
+../src/lru_cache.c \
+../src/map_entry.c \
+../src/map_key_arena.c \
+../src/sorted_key_view.c 
 
 OBJS += \
+./src/bloom_filter.o \
+./src/concurrent_hash_map.o \
+./src/disk_hash_map.o \
+./src/epoch_hash_map.o \
+./src/frozen_hash_map.o \
 ./src/hash_map.o \
 ./src/hash_map_iterator.o \
+./src/hash_map_open.o \
+./src/hash_map_open_iterator.o \
+./src/hash_map_snapshot.o \
 ./src/hash_set.o \
 ./src/hash_set_iterator.o \
 ./src/hash_set_main.o \
-./src/map_entry.o 
+./src/hyper_log_log.o \
+./src/int_hash_map.o \
+./src/lru_cache.o \
+./src/map_entry.o \
+./src/map_key_arena.o \
+./src/sorted_key_view.o 
 
 C_DEPS += \
+./src/bloom_filter.d \
+./src/concurrent_hash_map.d \
+./src/disk_hash_map.d \
+./src/epoch_hash_map.d \
+./src/frozen_hash_map.d \
 ./src/hash_map.d \
 ./src/hash_map_iterator.d \
+./src/hash_map_open.d \
+./src/hash_map_open_iterator.d \
+./src/hash_map_snapshot.d \
 ./src/hash_set.d \
 ./src/hash_set_iterator.d \
 ./src/hash_set_main.d \
-./src/map_entry.d 
+./src/hyper_log_log.d \
+./src/int_hash_map.d \
+./src/lru_cache.d \
+./src/map_entry.d \
+./src/map_key_arena.d \
+./src/sorted_key_view.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
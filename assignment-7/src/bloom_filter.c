@@ -0,0 +1,81 @@
+/*
+ * bloom_filter.c
+ *
+ * This file provides the implementation of a blocked BloomFilter of
+ * key hash codes.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bloom_filter.h"
+
+/**
+ * Returns the number of blocks for the specified number of keys.
+ *
+ * @param nKeys the expected number of keys
+ * @return the number of blocks, a power of two
+ */
+static size_t blocksForKeys(size_t nKeys) {
+	size_t nBits = nKeys * BLOOM_FILTER_BITS_PER_KEY;
+	size_t nBlocks = 1;
+	while (nBlocks * BLOOM_FILTER_BLOCK_WORDS * 64 < nBits) {
+		nBlocks *= 2;
+	}
+	return nBlocks;
+}
+
+/**
+ * Allocates the cleared blocks of a filter.
+ *
+ * @param filter the BloomFilter
+ * @param nBlocks the number of blocks
+ */
+static void allocBloomFilterBlocks(BloomFilter* filter, size_t nBlocks) {
+	size_t blockSize = BLOOM_FILTER_BLOCK_WORDS * sizeof(uint64_t);
+	filter->blocks = (uint64_t*)aligned_alloc(blockSize, nBlocks * blockSize);
+	memset(filter->blocks, 0, nBlocks * blockSize);
+	filter->nBlocks = nBlocks;
+}
+
+/**
+ * Create new empty BloomFilter sized for the specified number of keys.
+ *
+ * @param nKeys the expected number of keys
+ * @return new BloomFilter
+ */
+BloomFilter* createBloomFilter(size_t nKeys) {
+	BloomFilter* filter = (BloomFilter*)malloc(sizeof(BloomFilter));
+	allocBloomFilterBlocks(filter, blocksForKeys(nKeys));
+	return filter;
+}
+
+/**
+ * Frees a BloomFilter.
+ *
+ * @param filter the BloomFilter to free
+ */
+void deleteBloomFilter(BloomFilter* filter) {
+	free(filter->blocks);
+	free(filter);
+}
+
+/**
+ * Removes all keys from a BloomFilter, and resizes it for the specified
+ * number of keys.
+ *
+ * @param filter the BloomFilter
+ * @param nKeys the expected number of keys
+ */
+void resetBloomFilter(BloomFilter* filter, size_t nKeys) {
+	size_t nBlocks = blocksForKeys(nKeys);
+	if (nBlocks != filter->nBlocks) {
+		free(filter->blocks);
+		allocBloomFilterBlocks(filter, nBlocks);
+	} else {
+		memset(filter->blocks, 0,
+			   nBlocks * BLOOM_FILTER_BLOCK_WORDS * sizeof(uint64_t));
+	}
+}
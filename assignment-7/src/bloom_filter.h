@@ -0,0 +1,120 @@
+/*
+ * bloom_filter.h
+ *
+ * This file provides the structures and function declarations of a
+ * BloomFilter of key hash codes. The filter is blocked: the high bits
+ * of a hash code choose one 64-byte block, and the low bits set or test
+ * one bit in each of the block's 8 words, so a test reads a single cache
+ * line. With BLOOM_FILTER_BITS_PER_KEY bits per key, about 1% of keys
+ * that were never added are reported as possibly present.
+ *
+ * Bits cannot be removed, so a filter over keys that have since been
+ * deleted must be rebuilt to regain its accuracy.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef BLOOM_FILTER_H_
+#define BLOOM_FILTER_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef BLOOM_FILTER_BITS_PER_KEY
+#define BLOOM_FILTER_BITS_PER_KEY 12
+#endif
+
+/** Number of 64-bit words in a block, one cache line */
+#define BLOOM_FILTER_BLOCK_WORDS 8
+
+/**
+ * The filter.
+ */
+typedef struct {
+	uint64_t* blocks;					// the blocks, aligned to a cache line
+	size_t nBlocks;						// number of blocks, a power of two
+} BloomFilter;
+
+/**
+ * Create new empty BloomFilter sized for the specified number of keys.
+ *
+ * @param nKeys the expected number of keys
+ * @return new BloomFilter
+ */
+BloomFilter* createBloomFilter(size_t nKeys);
+
+/**
+ * Frees a BloomFilter.
+ *
+ * @param filter the BloomFilter to free
+ */
+void deleteBloomFilter(BloomFilter* filter);
+
+/**
+ * Removes all keys from a BloomFilter, and resizes it for the specified
+ * number of keys.
+ *
+ * @param filter the BloomFilter
+ * @param nKeys the expected number of keys
+ */
+void resetBloomFilter(BloomFilter* filter, size_t nKeys);
+
+/**
+ * Returns the bit that a hash code sets in a word of its block.
+ *
+ * @param hashCode the hash code
+ * @param word the index of the word in the block
+ * @return the bit mask
+ */
+static inline uint64_t getBloomFilterBit(uint64_t hashCode, int word) {
+	static const uint32_t salts[BLOOM_FILTER_BLOCK_WORDS] = {
+		0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+		0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+	};
+	return (uint64_t)1 << (((uint32_t)hashCode * salts[word]) >> 26);
+}
+
+/**
+ * Returns the block of a BloomFilter for a hash code.
+ *
+ * @param filter the BloomFilter
+ * @param hashCode the hash code
+ * @return the block
+ */
+static inline uint64_t* getBloomFilterBlock(BloomFilter* filter, uint64_t hashCode) {
+	return &filter->blocks[((hashCode >> 32) & (filter->nBlocks-1))
+						   * BLOOM_FILTER_BLOCK_WORDS];
+}
+
+/**
+ * Adds a key hash code to a BloomFilter.
+ *
+ * @param filter the BloomFilter
+ * @param hashCode the hash code
+ */
+static inline void addBloomFilterHashCode(BloomFilter* filter, uint64_t hashCode) {
+	uint64_t* block = getBloomFilterBlock(filter, hashCode);
+	for (int i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++) {
+		block[i] |= getBloomFilterBit(hashCode, i);
+	}
+}
+
+/**
+ * Returns false if a key hash code was never added to a BloomFilter.
+ *
+ * @param filter the BloomFilter
+ * @param hashCode the hash code
+ * @return false if the hash code is not present, true if it may be
+ */
+static inline bool mayContainBloomFilterHashCode(BloomFilter* filter, uint64_t hashCode) {
+	uint64_t* block = getBloomFilterBlock(filter, hashCode);
+	uint64_t missing = 0;
+	for (int i = 0; i < BLOOM_FILTER_BLOCK_WORDS; i++) {
+		missing |= ~block[i] & getBloomFilterBit(hashCode, i);
+	}
+	return missing == 0;
+}
+
+#endif /* BLOOM_FILTER_H_ */
@@ -0,0 +1,233 @@
+/*
+ * concurrent_hash_map.c
+ *
+ * This file provides the implementation of a ConcurrentHashMap, which
+ * is a Map whose entries are partitioned among independently locked
+ * HashMap stripes.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "concurrent_hash_map.h"
+
+#ifndef DEFAULT_STRIPES
+#define DEFAULT_STRIPES 64
+#endif
+
+/**
+ * Get the stripe for a key. The stripe is chosen with a hash seed of
+ * its own, so keys of a stripe are still spread over its table.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key
+ * @return the stripe for the key
+ */
+static ConcurrentHashMapStripe* stripeForKey(ConcurrentHashMap* map, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	return &map->stripes[hashCode & (map->nStripes-1)];
+}
+
+/**
+ * Create new empty ConcurrentHashMap.
+ *
+ * @param nStripes the number of stripes, rounded up to a power of two;
+ *   0 for the default number of stripes
+ * @return new ConcurrentHashMap
+ */
+ConcurrentHashMap* createConcurrentHashMap(size_t nStripes) {
+	ConcurrentHashMap* map = (ConcurrentHashMap*)malloc(sizeof(ConcurrentHashMap));
+	map->nStripes = 1;
+	while (map->nStripes < ((nStripes == 0) ? DEFAULT_STRIPES : nStripes)) {
+		map->nStripes *= 2;
+	}
+	map->seed = createMapEntryKeyHashSeed();
+	map->stripes = (ConcurrentHashMapStripe*)aligned_alloc(
+		sizeof(ConcurrentHashMapStripe), map->nStripes*sizeof(ConcurrentHashMapStripe));
+	for (size_t i = 0; i < map->nStripes; i++) {
+		pthread_rwlock_init(&map->stripes[i].lock, NULL);
+		map->stripes[i].map = createHashMap();
+	}
+	return map;
+}
+
+/**
+ * Frees a ConcurrentHashMap. No other thread may be using the map.
+ *
+ * @param map the ConcurrentHashMap to free
+ */
+void deleteConcurrentHashMap(ConcurrentHashMap* map) {
+	for (size_t i = 0; i < map->nStripes; i++) {
+		deleteHashMap(map->stripes[i].map);
+		map->stripes[i].map = (HashMap*)NULL;
+		pthread_rwlock_destroy(&map->stripes[i].lock);
+	}
+	free(map->stripes);
+	map->stripes = (ConcurrentHashMapStripe*)NULL;
+	free(map);
+}
+
+/**
+ * Removes all of the mappings from this map. Stripes are cleared one
+ * at a time, so entries that other threads put meanwhile may remain.
+ *
+ * @param map the ConcurrentHashMap
+ */
+void clearConcurrentHashMap(ConcurrentHashMap* map) {
+	for (size_t i = 0; i < map->nStripes; i++) {
+		pthread_rwlock_wrlock(&map->stripes[i].lock);
+		clearHashMap(map->stripes[i].map);
+		pthread_rwlock_unlock(&map->stripes[i].lock);
+	}
+}
+
+/**
+ * Returns true if this map contains a mapping for the specified key.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsConcurrentHashMapKey(ConcurrentHashMap* map, MapKey key) {
+	return getConcurrentHashMapValue(map, key) != (MapValue*)NULL;
+}
+
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key. The stripe is read-locked,
+ * so lookups in the same stripe run at the same time.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* getConcurrentHashMapValue(ConcurrentHashMap* map, MapKey key) {
+	ConcurrentHashMapStripe* stripe = stripeForKey(map, key);
+	pthread_rwlock_rdlock(&stripe->lock);
+	MapValue* value = peekHashMapValue(stripe->map, key);
+	pthread_rwlock_unlock(&stripe->lock);
+	return value;
+}
+
+/**
+ * Associates the specified value with the specified key in this map
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value to put
+ * @param value the value for the key
+ * @return the previous value for the key, or NULL for a new entry
+ */
+MapValue* putConcurrentHashMapEntry(
+	ConcurrentHashMap* map, MapKey key, MapValue* value) {
+	ConcurrentHashMapStripe* stripe = stripeForKey(map, key);
+	pthread_rwlock_wrlock(&stripe->lock);
+	MapValue* oldValue = putHashMapEntry(stripe->map, key, value);
+	pthread_rwlock_unlock(&stripe->lock);
+	return oldValue;
+}
+
+/**
+ * Associates the specified value with the specified key in this map
+ * if the key is not already in the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value to put
+ * @param value the value for the key
+ * @return the current value for the key, or NULL for a new entry
+ */
+MapValue* putIfAbsentConcurrentHashMapEntry(
+	ConcurrentHashMap* map, MapKey key, MapValue* value) {
+	ConcurrentHashMapStripe* stripe = stripeForKey(map, key);
+	pthread_rwlock_wrlock(&stripe->lock);
+	MapValue* currentValue = putIfAbsentHashMapEntry(stripe->map, key, value);
+	pthread_rwlock_unlock(&stripe->lock);
+	return currentValue;
+}
+
+/**
+ * Returns the value for the key if it is in the map. Otherwise calls
+ * the callback to compute a value, and adds an entry for the key
+ * unless the callback returns NULL. The stripe of the key is locked
+ * while the callback runs, so no other thread sees the key without
+ * its computed value. The callback must not use the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value
+ * @param callback called with the key and a NULL value
+ * @param callbackData the callback data
+ * @return the current or computed value for the key
+ */
+MapValue* computeIfAbsentConcurrentHashMapEntry(ConcurrentHashMap* map,
+	MapKey key, HashMapComputeCallback callback, HashMapComputeData callbackData) {
+	// most calls find the key, which only needs the read lock
+	MapValue* value = getConcurrentHashMapValue(map, key);
+	if (value != (MapValue*)NULL) {
+		return value;
+	}
+
+	ConcurrentHashMapStripe* stripe = stripeForKey(map, key);
+	pthread_rwlock_wrlock(&stripe->lock);
+	value = computeIfAbsentHashMapEntry(stripe->map, key, callback, callbackData);
+	pthread_rwlock_unlock(&stripe->lock);
+	return value;
+}
+
+/**
+ * Removes the mapping for a key from this map if it is present
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value to remove
+ * @return the value of the entry that was removed
+ */
+MapValue* deleteConcurrentHashMapEntryForKey(ConcurrentHashMap* map, MapKey key) {
+	ConcurrentHashMapStripe* stripe = stripeForKey(map, key);
+	pthread_rwlock_wrlock(&stripe->lock);
+	MapValue* value = deleteHashMapEntryForKey(stripe->map, key);
+	pthread_rwlock_unlock(&stripe->lock);
+	return value;
+}
+
+/**
+ * Calls the callback for each entry in the map until the callback
+ * returns false. The traversal is weakly consistent: each stripe is
+ * read-locked while its entries are visited, so the callback sees a
+ * consistent view of each stripe, but entries that other threads put
+ * or delete in other stripes meanwhile may or may not be visited.
+ * The callback must not use the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all entries were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachConcurrentHashMapEntry(ConcurrentHashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData) {
+	bool result = true;
+	for (size_t i = 0; i < map->nStripes && result; i++) {
+		pthread_rwlock_rdlock(&map->stripes[i].lock);
+		result = forEachHashMapEntry(map->stripes[i].map, callback, callbackData);
+		pthread_rwlock_unlock(&map->stripes[i].lock);
+	}
+	return result;
+}
+
+/**
+ * Returns the number of key-value mappings in this map. The stripes
+ * are counted one at a time, so the result is only exact if no other
+ * thread is modifying the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @return the number of entries in the map
+ */
+size_t getConcurrentHashMapSize(ConcurrentHashMap* map) {
+	size_t size = 0;
+	for (size_t i = 0; i < map->nStripes; i++) {
+		pthread_rwlock_rdlock(&map->stripes[i].lock);
+		size += getHashMapSize(map->stripes[i].map);
+		pthread_rwlock_unlock(&map->stripes[i].lock);
+	}
+	return size;
+}
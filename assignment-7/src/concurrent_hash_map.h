@@ -0,0 +1,158 @@
+/*
+ * concurrent_hash_map.h
+ *
+ * This file provides the structures and function declarations of a
+ * ConcurrentHashMap, which is a Map that can be used by several threads
+ * at once. Its entries are partitioned by key hash among a number of
+ * stripes. Each stripe is a HashMap with its own read-write lock, so
+ * threads using keys in different stripes do not contend, lookups in
+ * the same stripe share its lock, and each stripe resizes on its own.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef CONCURRENT_HASH_MAP_H_
+#define CONCURRENT_HASH_MAP_H_
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "hash_map.h"
+
+/**
+ * A stripe of the map. Stripes are aligned to a cache line so that
+ * threads locking different stripes do not share a line.
+ */
+typedef struct {
+	pthread_rwlock_t lock;				// guards the map of the stripe
+	HashMap* map;						// entries whose keys hash to the stripe
+} __attribute__((aligned(64))) ConcurrentHashMapStripe;
+
+/**
+ * The concurrent map.
+ */
+typedef struct {
+	ConcurrentHashMapStripe* stripes;	// the stripes
+	size_t nStripes;					// number of stripes, a power of two
+	uint64_t seed;						// hash seed for choosing a stripe
+} ConcurrentHashMap;
+
+/**
+ * Create new empty ConcurrentHashMap.
+ *
+ * @param nStripes the number of stripes, rounded up to a power of two;
+ *   0 for the default number of stripes
+ * @return new ConcurrentHashMap
+ */
+ConcurrentHashMap* createConcurrentHashMap(size_t nStripes);
+
+/**
+ * Frees a ConcurrentHashMap. No other thread may be using the map.
+ *
+ * @param map the ConcurrentHashMap to free
+ */
+void deleteConcurrentHashMap(ConcurrentHashMap* map);
+
+/**
+ * Removes all of the mappings from this map. Stripes are cleared one
+ * at a time, so entries that other threads put meanwhile may remain.
+ *
+ * @param map the ConcurrentHashMap
+ */
+void clearConcurrentHashMap(ConcurrentHashMap* map);
+
+/**
+ * Returns true if this map contains a mapping for the specified key.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsConcurrentHashMapKey(ConcurrentHashMap* map, MapKey key);
+
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* getConcurrentHashMapValue(ConcurrentHashMap* map, MapKey key);
+
+/**
+ * Associates the specified value with the specified key in this map
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value to put
+ * @param value the value for the key
+ * @return the previous value for the key, or NULL for a new entry
+ */
+MapValue* putConcurrentHashMapEntry(
+	ConcurrentHashMap* map, MapKey key, MapValue* value);
+
+/**
+ * Associates the specified value with the specified key in this map
+ * if the key is not already in the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value to put
+ * @param value the value for the key
+ * @return the current value for the key, or NULL for a new entry
+ */
+MapValue* putIfAbsentConcurrentHashMapEntry(
+	ConcurrentHashMap* map, MapKey key, MapValue* value);
+
+/**
+ * Returns the value for the key if it is in the map. Otherwise calls
+ * the callback to compute a value, and adds an entry for the key
+ * unless the callback returns NULL. The stripe of the key is locked
+ * while the callback runs, so no other thread sees the key without
+ * its computed value. The callback must not use the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value
+ * @param callback called with the key and a NULL value
+ * @param callbackData the callback data
+ * @return the current or computed value for the key
+ */
+MapValue* computeIfAbsentConcurrentHashMapEntry(ConcurrentHashMap* map,
+	MapKey key, HashMapComputeCallback callback, HashMapComputeData callbackData);
+
+/**
+ * Removes the mapping for a key from this map if it is present
+ *
+ * @param map the ConcurrentHashMap
+ * @param key the key for the value to remove
+ * @return the value of the entry that was removed
+ */
+MapValue* deleteConcurrentHashMapEntryForKey(ConcurrentHashMap* map, MapKey key);
+
+/**
+ * Calls the callback for each entry in the map until the callback
+ * returns false. The traversal is weakly consistent: each stripe is
+ * read-locked while its entries are visited, so the callback sees a
+ * consistent view of each stripe, but entries that other threads put
+ * or delete in other stripes meanwhile may or may not be visited.
+ * The callback must not use the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all entries were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachConcurrentHashMapEntry(ConcurrentHashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData);
+
+/**
+ * Returns the number of key-value mappings in this map. The stripes
+ * are counted one at a time, so the result is only exact if no other
+ * thread is modifying the map.
+ *
+ * @param map the ConcurrentHashMap
+ * @return the number of entries in the map
+ */
+size_t getConcurrentHashMapSize(ConcurrentHashMap* map);
+
+#endif /* CONCURRENT_HASH_MAP_H_ */
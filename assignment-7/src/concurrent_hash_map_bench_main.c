@@ -0,0 +1,203 @@
+/*
+ * concurrent_hash_map_bench_main.c
+ *
+ * This file provides a thread-scaling benchmark of ConcurrentHashMap
+ * and EpochHashMap compared with a HashMap guarded by a single mutex.
+ * From 1 to 64 threads each run a mix of gets and PUT_PERCENT% puts on
+ * a shared map, and the total throughput is reported. It is excluded
+ * from the project build; build it once for each HashMap implementation,
+ * and with -DPUT_PERCENT=0 for a read-only mix:
+ *
+ *   SRCS="src/bloom_filter.c src/concurrent_hash_map.c src/epoch_hash_map.c \
+ *         src/hash_map.c src/hash_map_iterator.c src/hash_map_open.c \
+ *         src/hash_map_open_iterator.c src/map_entry.c src/map_key_arena.c \
+ *         src/sorted_key_view.c"
+ *   gcc -O2 -pthread -o bench_concurrent src/concurrent_hash_map_bench_main.c $SRCS
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "concurrent_hash_map.h"
+#include "epoch_hash_map.h"
+
+/** Number of keys in the shared map */
+#define N_KEYS 100000
+
+/** Number of operations run by each thread */
+#define N_THREAD_OPS 1000000
+
+/** Percentage of operations that are puts */
+#ifndef PUT_PERCENT
+#define PUT_PERCENT 10
+#endif
+
+/** Maximum number of threads */
+#define MAX_THREADS 64
+
+/** Keys of the shared map */
+static char keys[N_KEYS][16];
+
+/** Value for every key */
+static MapValue value = { "value" };
+
+/** The striped map */
+static ConcurrentHashMap* concurrentMap;
+
+/** The lock-free read map */
+static EpochHashMap* epochMap;
+
+/** The single-lock map and its lock */
+static HashMap* lockedMap;
+static pthread_mutex_t mapLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Returns the current time in nanoseconds.
+ *
+ * @return the current monotonic time in nanoseconds
+ */
+static double nanoTime(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Returns the next pseudo-random number of a thread's xorshift sequence.
+ *
+ * @param state the state of the sequence
+ * @return the next number
+ */
+static uint64_t nextRandom(uint64_t* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+/**
+ * Thread that runs gets and puts on the striped map.
+ *
+ * @param data the thread number
+ * @return the number of keys found
+ */
+static void* runConcurrentOps(void* data) {
+	uint64_t state = (uintptr_t)data * 0x9E3779B97F4A7C15ULL + 1;
+	uintptr_t found = 0;
+	for (int i = 0; i < N_THREAD_OPS; i++) {
+		uint64_t r = nextRandom(&state);
+		char* key = keys[(r >> 8) % N_KEYS];
+		if (r % 100 < PUT_PERCENT) {
+			putConcurrentHashMapEntry(concurrentMap, key, &value);
+		} else {
+			found += (getConcurrentHashMapValue(concurrentMap, key) != NULL);
+		}
+	}
+	return (void*)found;
+}
+
+/**
+ * Thread that runs gets and puts on the lock-free read map.
+ *
+ * @param data the thread number
+ * @return the number of keys found
+ */
+static void* runEpochOps(void* data) {
+	EpochHashMapReader* reader = registerEpochHashMapReader(epochMap);
+	uint64_t state = (uintptr_t)data * 0x9E3779B97F4A7C15ULL + 1;
+	uintptr_t found = 0;
+	for (int i = 0; i < N_THREAD_OPS; i++) {
+		uint64_t r = nextRandom(&state);
+		char* key = keys[(r >> 8) % N_KEYS];
+		if (r % 100 < PUT_PERCENT) {
+			putEpochHashMapEntry(epochMap, key, &value);
+		} else {
+			found += (getEpochHashMapValue(reader, key) != NULL);
+		}
+	}
+	unregisterEpochHashMapReader(reader);
+	return (void*)found;
+}
+
+/**
+ * Thread that runs gets and puts on the single-lock map.
+ *
+ * @param data the thread number
+ * @return the number of keys found
+ */
+static void* runLockedOps(void* data) {
+	uint64_t state = (uintptr_t)data * 0x9E3779B97F4A7C15ULL + 1;
+	uintptr_t found = 0;
+	for (int i = 0; i < N_THREAD_OPS; i++) {
+		uint64_t r = nextRandom(&state);
+		char* key = keys[(r >> 8) % N_KEYS];
+		pthread_mutex_lock(&mapLock);
+		if (r % 100 < PUT_PERCENT) {
+			putHashMapEntry(lockedMap, key, &value);
+		} else {
+			found += (getHashMapValue(lockedMap, key) != NULL);
+		}
+		pthread_mutex_unlock(&mapLock);
+	}
+	return (void*)found;
+}
+
+/**
+ * Run a number of threads and return the throughput.
+ *
+ * @param nThreads the number of threads
+ * @param run the thread function
+ * @return the total throughput in millions of operations per second
+ */
+static double runThreads(int nThreads, void* (*run)(void*)) {
+	pthread_t threads[MAX_THREADS];
+	double start = nanoTime();
+	for (int t = 0; t < nThreads; t++) {
+		pthread_create(&threads[t], NULL, run, (void*)(uintptr_t)t);
+	}
+	for (int t = 0; t < nThreads; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	double time = nanoTime() - start;
+	return 1e3 * nThreads * N_THREAD_OPS / time;
+}
+
+/**
+ * Main program to run the benchmark
+ *
+ * @return the exit status of the program
+ */
+int main(void) {
+	concurrentMap = createConcurrentHashMap(0);
+	epochMap = createEpochHashMap();
+	lockedMap = createHashMap();
+	for (int i = 0; i < N_KEYS; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		// half of the keys are present at the start
+		if (i % 2 == 0) {
+			putConcurrentHashMapEntry(concurrentMap, keys[i], &value);
+			putEpochHashMapEntry(epochMap, keys[i], &value);
+			putHashMapEntry(lockedMap, keys[i], &value);
+		}
+	}
+
+	printf("%zu stripes, %d%% get / %d%% put (Mops/s)\n",
+		   concurrentMap->nStripes, 100-PUT_PERCENT, PUT_PERCENT);
+	printf("%10s %10s %10s %10s\n", "threads", "striped", "epoch", "one lock");
+	for (int nThreads = 1; nThreads <= MAX_THREADS; nThreads *= 2) {
+		double striped = runThreads(nThreads, runConcurrentOps);
+		double epoch = runThreads(nThreads, runEpochOps);
+		double locked = runThreads(nThreads, runLockedOps);
+		printf("%10d %10.2f %10.2f %10.2f\n", nThreads, striped, epoch, locked);
+	}
+
+	deleteConcurrentHashMap(concurrentMap);
+	deleteEpochHashMap(epochMap);
+	deleteHashMap(lockedMap);
+	return EXIT_SUCCESS;
+}
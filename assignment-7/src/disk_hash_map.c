@@ -0,0 +1,732 @@
+/*
+ * disk_hash_map.c
+ *
+ * This file provides the implementation of a DiskHashMap, which keeps
+ * its entries in pages of a file with a cache of pages in memory.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "disk_hash_map.h"
+
+#if DISK_HASH_MAP_PAGE_SIZE > 32768 || DISK_HASH_MAP_PAGE_SIZE % 8 != 0
+#error "DISK_HASH_MAP_PAGE_SIZE must be a multiple of 8 no larger than 32768"
+#endif
+
+/** Indicates no page, for the end of a chain or an empty bucket */
+#define NO_PAGE UINT32_MAX
+
+/** Indicates that a page is not in the cache, or no frame */
+#define NO_FRAME UINT32_MAX
+
+/** Fraction of the pages of the buckets that entries fill before a split */
+#define MAX_LOAD_FACTOR 0.75
+
+/**
+ * The header at the start of each page. The header is followed by a
+ * slot for each entry, and the entries are stored from the end of the
+ * page toward the slots.
+ */
+typedef struct {
+	DiskHashMapPage nextPage;			// next page of the chain, or NO_PAGE
+	uint16_t nRecords;					// number of entries in the page
+	uint16_t recordStart;				// offset of the lowest entry
+} DiskHashMapPageHeader;
+
+/**
+ * The slot of an entry in a page. A search compares the tags of the
+ * slots, and reads only the entries whose tag matches.
+ */
+typedef struct {
+	uint16_t offset;					// offset of the entry in the page
+	uint16_t tag;						// high bits of the entry hash code
+} DiskHashMapSlot;
+
+/** Bytes of a page that hold slots and entries */
+#define PAGE_DATA_SIZE (DISK_HASH_MAP_PAGE_SIZE - sizeof(DiskHashMapPageHeader))
+
+/**
+ * The header of an entry in a page, which is followed by the key
+ * string and the value string, and padded to a multiple of 8 bytes.
+ */
+typedef struct {
+	uint64_t hashCode;					// hash code for the entry key
+	uint32_t keyLength;					// length of the key
+	uint32_t valueLength;				// length of the value, or NO_VALUE
+} DiskHashMapRecord;
+
+/** Indicates an entry whose value is NULL */
+#define NO_VALUE UINT32_MAX
+
+/**
+ * Returns the number of page bytes for an entry, not counting its slot.
+ *
+ * @param keyLength the length of the key
+ * @param valueLength the length of the value, or NO_VALUE
+ * @return the number of bytes, a multiple of 8
+ */
+static inline size_t getRecordSize(size_t keyLength, size_t valueLength) {
+	size_t size = sizeof(DiskHashMapRecord) + keyLength + 1;
+	if (valueLength != NO_VALUE) {
+		size += valueLength + 1;
+	}
+	return (size + 7) & ~(size_t)7;
+}
+
+/**
+ * Returns the tag of a hash code. The tag uses the high bits, which
+ * do not choose the bucket.
+ *
+ * @param hashCode the hash code
+ * @return the tag
+ */
+static inline uint16_t getSlotTag(uint64_t hashCode) {
+	return (uint16_t)(hashCode >> 48);
+}
+
+/**
+ * Returns the slots of a page.
+ *
+ * @param data the page
+ * @return the slots
+ */
+static inline DiskHashMapSlot* getPageSlots(char* data) {
+	return (DiskHashMapSlot*)(data + sizeof(DiskHashMapPageHeader));
+}
+
+/**
+ * Returns the entry of a slot of a page.
+ *
+ * @param data the page
+ * @param slot the index of the slot
+ * @return the entry
+ */
+static inline DiskHashMapRecord* getPageRecord(char* data, size_t slot) {
+	return (DiskHashMapRecord*)(data + getPageSlots(data)[slot].offset);
+}
+
+/**
+ * Returns the number of bytes between the slots and the entries of a
+ * page.
+ *
+ * @param header the header of the page
+ * @return the number of free bytes
+ */
+static inline size_t getPageFreeBytes(DiskHashMapPageHeader* header) {
+	return header->recordStart - sizeof(DiskHashMapPageHeader)
+		   - header->nRecords * sizeof(DiskHashMapSlot);
+}
+
+/**
+ * Clears the header of a page that holds no entries.
+ *
+ * @param data the page
+ */
+static inline void clearPage(char* data) {
+	DiskHashMapPageHeader* header = (DiskHashMapPageHeader*)data;
+	header->nextPage = NO_PAGE;
+	header->nRecords = 0;
+	header->recordStart = DISK_HASH_MAP_PAGE_SIZE;
+}
+
+/**
+ * Returns the index of the bucket for a hash code.
+ *
+ * @param map the DiskHashMap
+ * @param hashCode the hash code
+ * @return the bucket index
+ */
+static inline size_t bucketForHash(DiskHashMap* map, uint64_t hashCode) {
+	size_t bucket = hashCode & (map->levelSize-1);
+	if (bucket < map->splitBucket) {
+		// bucket was already split in this round
+		bucket = hashCode & (2*map->levelSize-1);
+	}
+	return bucket;
+}
+
+/**
+ * Removes a frame from the recency list of the cache.
+ *
+ * @param map the DiskHashMap
+ * @param frame the frame
+ */
+static void unlinkFrame(DiskHashMap* map, uint32_t frame) {
+	DiskHashMapFrame* f = &map->frames[frame];
+	if (f->newer == NO_FRAME) {
+		map->newestFrame = f->older;
+	} else {
+		map->frames[f->newer].older = f->older;
+	}
+	if (f->older == NO_FRAME) {
+		map->oldestFrame = f->newer;
+	} else {
+		map->frames[f->older].newer = f->newer;
+	}
+}
+
+/**
+ * Adds a frame to the recency list of the cache as the newest frame.
+ *
+ * @param map the DiskHashMap
+ * @param frame the frame
+ */
+static void linkNewestFrame(DiskHashMap* map, uint32_t frame) {
+	DiskHashMapFrame* f = &map->frames[frame];
+	f->newer = NO_FRAME;
+	f->older = map->newestFrame;
+	if (map->newestFrame == NO_FRAME) {
+		map->oldestFrame = frame;
+	} else {
+		map->frames[map->newestFrame].newer = frame;
+	}
+	map->newestFrame = frame;
+}
+
+/**
+ * Returns the page of a frame.
+ *
+ * @param map the DiskHashMap
+ * @param frame the frame
+ * @return the page data of the frame
+ */
+static inline char* getFrameData(DiskHashMap* map, uint32_t frame) {
+	return map->frameData + (size_t)frame * DISK_HASH_MAP_PAGE_SIZE;
+}
+
+/**
+ * Writes the page of a frame to the file if it was changed.
+ *
+ * @param map the DiskHashMap
+ * @param frame the frame
+ */
+static void writeFrame(DiskHashMap* map, uint32_t frame) {
+	DiskHashMapFrame* f = &map->frames[frame];
+	if (f->isDirty) {
+		off_t offset = (off_t)f->page * DISK_HASH_MAP_PAGE_SIZE;
+		if (pwrite(map->fd, getFrameData(map, frame), DISK_HASH_MAP_PAGE_SIZE, offset)
+			!= DISK_HASH_MAP_PAGE_SIZE) {
+			map->hasFailed = true;
+		}
+		map->pageWrites++;
+		f->isDirty = false;
+	}
+}
+
+/**
+ * Assigns a frame to a page, evicting the least recently used page if
+ * the cache is full. The frame becomes the newest frame.
+ *
+ * @param map the DiskHashMap
+ * @param page the page
+ * @return the frame
+ */
+static uint32_t takeFrame(DiskHashMap* map, DiskHashMapPage page) {
+	uint32_t frame;
+	if (map->framesUsed < map->nFrames) {
+		frame = map->framesUsed++;
+	} else {
+		frame = map->oldestFrame;
+		unlinkFrame(map, frame);
+		writeFrame(map, frame);
+		map->pageFrames[map->frames[frame].page] = NO_FRAME;
+	}
+	map->frames[frame].page = page;
+	map->frames[frame].isDirty = false;
+	map->pageFrames[page] = frame;
+	linkNewestFrame(map, frame);
+	return frame;
+}
+
+/**
+ * Returns a page from the cache, reading it from the file if it is not
+ * cached. The page is valid until more than DISK_HASH_MAP_MIN_CACHE_PAGES-1
+ * other pages are requested.
+ *
+ * @param map the DiskHashMap
+ * @param page the page
+ * @param willChange true if the caller will change the page
+ * @return the page data
+ */
+static char* getPage(DiskHashMap* map, DiskHashMapPage page, bool willChange) {
+	uint32_t frame = map->pageFrames[page];
+	if (frame == NO_FRAME) {
+		frame = takeFrame(map, page);
+		char* data = getFrameData(map, frame);
+		off_t offset = (off_t)page * DISK_HASH_MAP_PAGE_SIZE;
+		if (pread(map->fd, data, DISK_HASH_MAP_PAGE_SIZE, offset) != DISK_HASH_MAP_PAGE_SIZE) {
+			// treat a page that cannot be read as empty
+			map->hasFailed = true;
+			clearPage(data);
+		}
+		map->pageReads++;
+	} else if (frame != map->newestFrame) {
+		unlinkFrame(map, frame);
+		linkNewestFrame(map, frame);
+	}
+	map->frames[frame].isDirty |= willChange;
+	return getFrameData(map, frame);
+}
+
+/**
+ * Returns an empty page, reusing a free page if there is one. The
+ * page is not read from the file, since it holds no entries.
+ *
+ * @param map the DiskHashMap
+ * @param page set to the page
+ * @return the page data
+ */
+static char* createPage(DiskHashMap* map, DiskHashMapPage* page) {
+	if (map->nFreePages > 0) {
+		*page = map->freePages[--map->nFreePages];
+	} else {
+		*page = map->nPages++;
+		if (*page >= map->pageFrameCapacity) {
+			map->pageFrameCapacity *= 2;
+			map->pageFrames = (uint32_t*)realloc(map->pageFrames,
+				map->pageFrameCapacity * sizeof(uint32_t));
+			for (size_t i = *page; i < map->pageFrameCapacity; i++) {
+				map->pageFrames[i] = NO_FRAME;
+			}
+		}
+	}
+	uint32_t frame = map->pageFrames[*page];
+	if (frame == NO_FRAME) {
+		frame = takeFrame(map, *page);
+	}
+	map->frames[frame].isDirty = true;
+	char* data = getFrameData(map, frame);
+	clearPage(data);
+	return data;
+}
+
+/**
+ * Adds a page to the free pages. The page is marked as holding no
+ * entries, so iterators skip it.
+ *
+ * @param map the DiskHashMap
+ * @param page the page
+ */
+static void freePage(DiskHashMap* map, DiskHashMapPage page) {
+	clearPage(getPage(map, page, true));
+	if (map->nFreePages == map->freePageCapacity) {
+		map->freePageCapacity *= 2;
+		map->freePages = (DiskHashMapPage*)realloc(map->freePages,
+			map->freePageCapacity * sizeof(DiskHashMapPage));
+	}
+	map->freePages[map->nFreePages++] = page;
+}
+
+/**
+ * Adds an entry to a bucket, in the first page of its chain with room
+ * for it or in a new page at the head of the chain. The key must not
+ * already be in the map.
+ *
+ * @param map the DiskHashMap
+ * @param bucket the bucket
+ * @param hashCode the hash code of the key
+ * @param key the key
+ * @param keyLength the length of the key
+ * @param valuestr the value string, or NULL
+ * @param valueLength the length of the value, or NO_VALUE
+ */
+static void appendRecord(DiskHashMap* map, size_t bucket, uint64_t hashCode,
+	const char* key, size_t keyLength, const char* valuestr, size_t valueLength) {
+	size_t recordSize = getRecordSize(keyLength, valueLength);
+	char* data = (char*)NULL;
+	for (DiskHashMapPage page = map->buckets[bucket]; page != NO_PAGE; ) {
+		DiskHashMapPageHeader* header = (DiskHashMapPageHeader*)getPage(map, page, false);
+		if (recordSize + sizeof(DiskHashMapSlot) <= getPageFreeBytes(header)) {
+			data = getPage(map, page, true);
+			break;
+		}
+		page = header->nextPage;
+	}
+	if (data == (char*)NULL) {
+		DiskHashMapPage page;
+		data = createPage(map, &page);
+		((DiskHashMapPageHeader*)data)->nextPage = map->buckets[bucket];
+		map->buckets[bucket] = page;
+	}
+
+	DiskHashMapPageHeader* header = (DiskHashMapPageHeader*)data;
+	header->recordStart -= recordSize;
+	DiskHashMapSlot* slot = &getPageSlots(data)[header->nRecords++];
+	slot->offset = header->recordStart;
+	slot->tag = getSlotTag(hashCode);
+	DiskHashMapRecord* record = getPageRecord(data, header->nRecords-1);
+	record->hashCode = hashCode;
+	record->keyLength = keyLength;
+	record->valueLength = valueLength;
+	char* strings = (char*)(record + 1);
+	memcpy(strings, key, keyLength + 1);
+	if (valueLength != NO_VALUE) {
+		memcpy(strings + keyLength + 1, valuestr, valueLength + 1);
+	}
+	map->recordBytes += recordSize + sizeof(DiskHashMapSlot);
+}
+
+/**
+ * The location of an entry that was found in a bucket.
+ */
+typedef struct {
+	size_t bucket;						// the bucket of the entry
+	DiskHashMapPage page;				// the page of the entry
+	DiskHashMapPage prevPage;			// previous page in chain, or NO_PAGE
+	size_t slot;						// index of the slot of the entry
+	DiskHashMapRecord* record;			// the entry in the page cache
+} DiskHashMapLocation;
+
+/**
+ * Finds the entry for a key.
+ *
+ * @param map the DiskHashMap
+ * @param key the key
+ * @param hashCode the hash code of the key
+ * @param location set to the location of the entry
+ * @return true if the key was found, false otherwise
+ */
+static bool findRecord(DiskHashMap* map, MapKey key, uint64_t hashCode,
+	DiskHashMapLocation* location) {
+	size_t keyLength = SIZE_MAX;
+	uint16_t tag = getSlotTag(hashCode);
+	location->bucket = bucketForHash(map, hashCode);
+	location->prevPage = NO_PAGE;
+	for (DiskHashMapPage page = map->buckets[location->bucket]; page != NO_PAGE; ) {
+		char* data = getPage(map, page, false);
+		DiskHashMapPageHeader* header = (DiskHashMapPageHeader*)data;
+		DiskHashMapSlot* slots = getPageSlots(data);
+		for (size_t slot = 0; slot < header->nRecords; slot++) {
+			if (slots[slot].tag != tag) {
+				continue;
+			}
+			DiskHashMapRecord* record = getPageRecord(data, slot);
+			if (record->hashCode == hashCode) {
+				if (keyLength == SIZE_MAX) {
+					keyLength = strlen(key);
+				}
+				if (   record->keyLength == keyLength
+					&& memcmp(record + 1, key, keyLength) == 0) {
+					location->page = page;
+					location->slot = slot;
+					location->record = record;
+					return true;
+				}
+			}
+		}
+		location->prevPage = page;
+		page = header->nextPage;
+	}
+	return false;
+}
+
+/**
+ * Removes an entry that was found, and frees its page if it becomes
+ * empty. The entries below it move up to close the gap.
+ *
+ * @param map the DiskHashMap
+ * @param location the location of the entry
+ */
+static void removeRecord(DiskHashMap* map, DiskHashMapLocation* location) {
+	char* data = getPage(map, location->page, true);
+	DiskHashMapPageHeader* header = (DiskHashMapPageHeader*)data;
+	DiskHashMapSlot* slots = getPageSlots(data);
+	DiskHashMapRecord* record = getPageRecord(data, location->slot);
+	size_t recordSize = getRecordSize(record->keyLength, record->valueLength);
+	size_t offset = slots[location->slot].offset;
+	memmove(data + header->recordStart + recordSize, data + header->recordStart,
+			offset - header->recordStart);
+	header->recordStart += recordSize;
+	memmove(&slots[location->slot], &slots[location->slot+1],
+			(header->nRecords - location->slot - 1) * sizeof(DiskHashMapSlot));
+	header->nRecords--;
+	for (size_t slot = 0; slot < header->nRecords; slot++) {
+		if (slots[slot].offset < offset) {
+			slots[slot].offset += recordSize;
+		}
+	}
+	map->recordBytes -= recordSize + sizeof(DiskHashMapSlot);
+
+	if (header->nRecords == 0) {
+		DiskHashMapPage nextPage = header->nextPage;
+		if (location->prevPage == NO_PAGE) {
+			map->buckets[location->bucket] = nextPage;
+		} else {
+			((DiskHashMapPageHeader*)getPage(map, location->prevPage, true))->nextPage
+				= nextPage;
+		}
+		freePage(map, location->page);
+	}
+}
+
+/**
+ * Splits the next bucket into itself and a new bucket at the end of
+ * the directory, moving each of its entries to the bucket for its hash
+ * code with one more bit.
+ *
+ * @param map the DiskHashMap
+ */
+static void splitNextBucket(DiskHashMap* map) {
+	if (map->nBuckets == map->bucketCapacity) {
+		map->bucketCapacity *= 2;
+		map->buckets = (DiskHashMapPage*)realloc(map->buckets,
+			map->bucketCapacity * sizeof(DiskHashMapPage));
+	}
+	DiskHashMapPage page = map->buckets[map->splitBucket];
+	map->buckets[map->splitBucket] = NO_PAGE;
+	map->buckets[map->nBuckets++] = NO_PAGE;
+	if (++map->splitBucket == map->levelSize) {
+		// all buckets of this round were split; start the next round
+		map->levelSize *= 2;
+		map->splitBucket = 0;
+	}
+
+	// copy each page of the old chain, free it, and add its entries back
+	while (page != NO_PAGE) {
+		memcpy(map->scratchPage, getPage(map, page, false), DISK_HASH_MAP_PAGE_SIZE);
+		DiskHashMapPageHeader* header = (DiskHashMapPageHeader*)map->scratchPage;
+		freePage(map, page);
+		for (size_t slot = 0; slot < header->nRecords; slot++) {
+			DiskHashMapRecord* record = getPageRecord(map->scratchPage, slot);
+			const char* key = (const char*)(record + 1);
+			map->recordBytes -= getRecordSize(record->keyLength, record->valueLength)
+								+ sizeof(DiskHashMapSlot);
+			appendRecord(map, bucketForHash(map, record->hashCode), record->hashCode,
+						 key, record->keyLength,
+						 key + record->keyLength + 1, record->valueLength);
+		}
+		page = header->nextPage;
+	}
+}
+
+/**
+ * Create new empty DiskHashMap that stores its entries in a new file.
+ *
+ * @param path the path of the file, which is replaced if it exists
+ * @param cachePages the number of pages to cache in memory, at least
+ *   DISK_HASH_MAP_MIN_CACHE_PAGES
+ * @return new DiskHashMap, or NULL if the file could not be created
+ */
+DiskHashMap* createDiskHashMap(const char* path, size_t cachePages) {
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		return (DiskHashMap*)NULL;
+	}
+	if (cachePages < DISK_HASH_MAP_MIN_CACHE_PAGES) {
+		cachePages = DISK_HASH_MAP_MIN_CACHE_PAGES;
+	}
+
+	DiskHashMap* map = (DiskHashMap*)malloc(sizeof(DiskHashMap));
+	map->fd = fd;
+	map->path = strdup(path);
+	map->seed = createMapEntryKeyHashSeed();
+	map->size = 0;
+	map->recordBytes = 0;
+	map->bucketCapacity = 16;
+	map->buckets = (DiskHashMapPage*)malloc(map->bucketCapacity * sizeof(DiskHashMapPage));
+	map->buckets[0] = NO_PAGE;
+	map->nBuckets = 1;
+	map->levelSize = 1;
+	map->splitBucket = 0;
+	map->nPages = 0;
+	map->freePageCapacity = 16;
+	map->freePages = (DiskHashMapPage*)malloc(map->freePageCapacity * sizeof(DiskHashMapPage));
+	map->nFreePages = 0;
+	map->pageFrameCapacity = 16;
+	map->pageFrames = (uint32_t*)malloc(map->pageFrameCapacity * sizeof(uint32_t));
+	for (size_t i = 0; i < map->pageFrameCapacity; i++) {
+		map->pageFrames[i] = NO_FRAME;
+	}
+	map->nFrames = cachePages;
+	map->frames = (DiskHashMapFrame*)malloc(cachePages * sizeof(DiskHashMapFrame));
+	map->frameData = (char*)malloc(cachePages * DISK_HASH_MAP_PAGE_SIZE);
+	map->scratchPage = (char*)malloc(DISK_HASH_MAP_PAGE_SIZE);
+	map->framesUsed = 0;
+	map->newestFrame = NO_FRAME;
+	map->oldestFrame = NO_FRAME;
+	map->pageReads = 0;
+	map->pageWrites = 0;
+	map->hasFailed = false;
+	return map;
+}
+
+/**
+ * Frees a DiskHashMap, and removes its file.
+ *
+ * @param map the DiskHashMap to free
+ */
+void deleteDiskHashMap(DiskHashMap* map) {
+	close(map->fd);
+	unlink(map->path);
+	free(map->path);
+	free(map->buckets);
+	free(map->freePages);
+	free(map->pageFrames);
+	free(map->frames);
+	free(map->frameData);
+	free(map->scratchPage);
+	free(map);
+}
+
+/**
+ * Returns true if the map contains a mapping for the specified key.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsDiskHashMapKey(DiskHashMap* map, MapKey key) {
+	DiskHashMapLocation location;
+	return findRecord(map, key, getMapEntryKeyHashCode(key, map->seed), &location);
+}
+
+/**
+ * Gets the value to which the specified key is mapped. The valuestr of
+ * the value points into the page cache, and is valid until the next
+ * call on the map.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key for the value to get
+ * @param value set to the value for the key
+ * @return value, or NULL if the map contains no mapping for the key
+ *   or the key was mapped to NULL
+ */
+MapValue* getDiskHashMapValue(DiskHashMap* map, MapKey key, MapValue* value) {
+	DiskHashMapLocation location;
+	if (   !findRecord(map, key, getMapEntryKeyHashCode(key, map->seed), &location)
+		|| location.record->valueLength == NO_VALUE) {
+		return (MapValue*)NULL;
+	}
+	value->valuestr = (char*)(location.record + 1) + location.record->keyLength + 1;
+	return value;
+}
+
+/**
+ * Associates the specified value with the specified key. The key and
+ * the valuestr of the value are copied into the map.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key
+ * @param value the entry value, or NULL
+ * @return true if the entry was stored, false if the key and value do
+ *   not fit in a page or the file could not be read or written
+ */
+bool putDiskHashMapEntry(DiskHashMap* map, MapKey key, MapValue* value) {
+	size_t keyLength = strlen(key);
+	const char* valuestr = (value == (MapValue*)NULL) ? (char*)NULL : value->valuestr;
+	size_t valueLength = (valuestr == (char*)NULL) ? NO_VALUE : strlen(valuestr);
+	if (   keyLength >= PAGE_DATA_SIZE
+		|| (valueLength != NO_VALUE && valueLength >= PAGE_DATA_SIZE)
+		|| getRecordSize(keyLength, valueLength) + sizeof(DiskHashMapSlot) > PAGE_DATA_SIZE) {
+		return false;
+	}
+
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	DiskHashMapLocation location;
+	if (findRecord(map, key, hashCode, &location)) {
+		removeRecord(map, &location);
+	} else {
+		map->size++;
+	}
+	appendRecord(map, location.bucket, hashCode, key, keyLength, valuestr, valueLength);
+
+	while (map->recordBytes > map->nBuckets * PAGE_DATA_SIZE * MAX_LOAD_FACTOR) {
+		splitNextBucket(map);
+	}
+	return !map->hasFailed;
+}
+
+/**
+ * Removes the mapping for the specified key.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key
+ * @return true if the key was present, false otherwise
+ */
+bool deleteDiskHashMapEntryForKey(DiskHashMap* map, MapKey key) {
+	DiskHashMapLocation location;
+	if (!findRecord(map, key, getMapEntryKeyHashCode(key, map->seed), &location)) {
+		return false;
+	}
+	removeRecord(map, &location);
+	map->size--;
+	return true;
+}
+
+/**
+ * Returns the number of key-value mappings in the map.
+ *
+ * @param map the DiskHashMap
+ * @return the number of entries in the map
+ */
+size_t getDiskHashMapSize(DiskHashMap* map) {
+	return map->size;
+}
+
+/**
+ * Returns true if a read or write of the file has failed. Entries in
+ * pages that could not be read are treated as absent.
+ *
+ * @param map the DiskHashMap
+ * @return true if the file could not be read or written
+ */
+bool hasDiskHashMapFailed(DiskHashMap* map) {
+	return map->hasFailed;
+}
+
+/**
+ * Initialize a DiskHashMapIterator that the caller has allocated. The
+ * map must not be changed while it is being iterated.
+ *
+ * @param itr the DiskHashMapIterator to initialize
+ * @param map the map
+ */
+void initDiskHashMapIterator(DiskHashMapIterator* itr, DiskHashMap* map) {
+	itr->map = map;
+	itr->page = 0;
+	itr->slot = 0;
+	itr->count = 0;
+}
+
+/**
+ * Determines whether there is another entry in the map
+ *
+ * @param itr the DiskHashMapIterator
+ * @return true if there is another entry, false otherwise
+ */
+bool hasNextDiskHashMapEntry(DiskHashMapIterator* itr) {
+	return itr->count < itr->map->size;
+}
+
+/**
+ * Gets next entry in the map. The key and valuestr of the entry point
+ * into the page cache, and are valid until the next call on the map.
+ *
+ * @param itr the DiskHashMapIterator
+ * @return the next entry or NULL if iterator is at end of the map
+ */
+MapEntry* getNextDiskHashMapEntry(DiskHashMapIterator* itr) {
+	// pages are read in file order, so the scan reads the file sequentially
+	for ( ; itr->page < itr->map->nPages; itr->page++, itr->slot = 0) {
+		char* data = getPage(itr->map, itr->page, false);
+		DiskHashMapPageHeader* header = (DiskHashMapPageHeader*)data;
+		if (itr->slot < header->nRecords) {
+			DiskHashMapRecord* record = getPageRecord(data, itr->slot++);
+			itr->count++;
+			itr->entry.key = (const char*)(record + 1);
+			if (record->valueLength == NO_VALUE) {
+				itr->entry.value = (MapValue*)NULL;
+			} else {
+				itr->value.valuestr = (char*)itr->entry.key + record->keyLength + 1;
+				itr->entry.value = &itr->value;
+			}
+			return &itr->entry;
+		}
+	}
+	return (MapEntry*)NULL;
+}
@@ -0,0 +1,206 @@
+/*
+ * disk_hash_map.h
+ *
+ * This file provides the structures and function declarations of a
+ * DiskHashMap, which is a hash map for more keys than fit in memory.
+ * Only the bucket directory and a cache of pages are kept in memory;
+ * the entries are stored in fixed-size pages of a local file.
+ *
+ * The map uses linear hashing: when the entries fill the pages of the
+ * buckets past a load factor, the next bucket in turn is split into
+ * two, so the directory grows by one bucket at a time and no put has
+ * to rehash the whole file. The entries of a bucket are kept in a chain
+ * of pages. Each page starts with a slot for each of its entries that
+ * holds the high bits of the entry's hash code, so a search reads the
+ * entries of a page only when these match. The page cache holds a fixed
+ * number of pages, evicts the least recently used page, and writes a
+ * page back only if it changed.
+ *
+ * Keys and values are copied into the pages; a value is stored as its
+ * valuestr string. Keys and valuestr strings that a lookup or iterator
+ * returns point into the page cache, and are valid until the next call
+ * on the map. The file is scratch space: it is created by
+ * createDiskHashMap() and removed by deleteDiskHashMap().
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef DISK_HASH_MAP_H_
+#define DISK_HASH_MAP_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "map_entry.h"
+
+#ifndef DISK_HASH_MAP_PAGE_SIZE
+#define DISK_HASH_MAP_PAGE_SIZE 4096
+#endif
+
+/** Fewest pages in the cache; two pages may be in use at once */
+#define DISK_HASH_MAP_MIN_CACHE_PAGES 4
+
+/**
+ * Index of a page in the file.
+ */
+typedef uint32_t DiskHashMapPage;
+
+/**
+ * A page of the cache.
+ */
+typedef struct {
+	DiskHashMapPage page;				// the page held by this frame
+	uint32_t newer;						// index of more recently used frame
+	uint32_t older;						// index of less recently used frame
+	bool isDirty;						// true if changed since read
+} DiskHashMapFrame;
+
+/**
+ * The map.
+ */
+typedef struct {
+	int fd;								// the file of the pages
+	char* path;							// the path of the file
+	uint64_t seed;						// hash seed for keys of this map
+	size_t size;						// number of entries in the map
+	size_t recordBytes;					// bytes of pages used by entries
+	DiskHashMapPage* buckets;			// first page of each bucket chain
+	size_t nBuckets;					// number of buckets
+	size_t bucketCapacity;				// size of the bucket directory
+	size_t levelSize;					// buckets at start of this round
+	size_t splitBucket;					// next bucket to split
+	DiskHashMapPage nPages;				// number of pages in the file
+	DiskHashMapPage* freePages;			// pages that hold no entries
+	size_t nFreePages;					// number of free pages
+	size_t freePageCapacity;			// size of the free page array
+	uint32_t* pageFrames;				// frame of each page, or NO_FRAME
+	size_t pageFrameCapacity;			// size of the page frame array
+	DiskHashMapFrame* frames;			// the frames of the page cache
+	char* frameData;					// the page of each frame
+	char* scratchPage;					// copy of a page being split
+	size_t nFrames;						// number of frames in the cache
+	size_t framesUsed;					// number of frames holding a page
+	uint32_t newestFrame;				// most recently used frame
+	uint32_t oldestFrame;				// least recently used frame
+	size_t pageReads;					// pages read from the file
+	size_t pageWrites;					// pages written to the file
+	bool hasFailed;						// true if a read or write failed
+} DiskHashMap;
+
+/**
+ * An iterator for a DiskHashMap, which reads the pages in file order.
+ */
+typedef struct {
+	DiskHashMap* map;					// the map
+	DiskHashMapPage page;				// current page
+	size_t slot;						// index of next entry in the page
+	size_t count;						// count of entries returned
+	MapEntry entry;						// the entry that was returned
+	MapValue value;						// the value of the entry
+} DiskHashMapIterator;
+
+/**
+ * Create new empty DiskHashMap that stores its entries in a new file.
+ *
+ * @param path the path of the file, which is replaced if it exists
+ * @param cachePages the number of pages to cache in memory, at least
+ *   DISK_HASH_MAP_MIN_CACHE_PAGES
+ * @return new DiskHashMap, or NULL if the file could not be created
+ */
+DiskHashMap* createDiskHashMap(const char* path, size_t cachePages);
+
+/**
+ * Frees a DiskHashMap, and removes its file.
+ *
+ * @param map the DiskHashMap to free
+ */
+void deleteDiskHashMap(DiskHashMap* map);
+
+/**
+ * Returns true if the map contains a mapping for the specified key.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsDiskHashMapKey(DiskHashMap* map, MapKey key);
+
+/**
+ * Gets the value to which the specified key is mapped. The valuestr of
+ * the value points into the page cache, and is valid until the next
+ * call on the map.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key for the value to get
+ * @param value set to the value for the key
+ * @return value, or NULL if the map contains no mapping for the key
+ *   or the key was mapped to NULL
+ */
+MapValue* getDiskHashMapValue(DiskHashMap* map, MapKey key, MapValue* value);
+
+/**
+ * Associates the specified value with the specified key. The key and
+ * the valuestr of the value are copied into the map.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key
+ * @param value the entry value, or NULL
+ * @return true if the entry was stored, false if the key and value do
+ *   not fit in a page or the file could not be read or written
+ */
+bool putDiskHashMapEntry(DiskHashMap* map, MapKey key, MapValue* value);
+
+/**
+ * Removes the mapping for the specified key.
+ *
+ * @param map the DiskHashMap
+ * @param key the entry key
+ * @return true if the key was present, false otherwise
+ */
+bool deleteDiskHashMapEntryForKey(DiskHashMap* map, MapKey key);
+
+/**
+ * Returns the number of key-value mappings in the map.
+ *
+ * @param map the DiskHashMap
+ * @return the number of entries in the map
+ */
+size_t getDiskHashMapSize(DiskHashMap* map);
+
+/**
+ * Returns true if a read or write of the file has failed. Entries in
+ * pages that could not be read are treated as absent.
+ *
+ * @param map the DiskHashMap
+ * @return true if the file could not be read or written
+ */
+bool hasDiskHashMapFailed(DiskHashMap* map);
+
+/**
+ * Initialize a DiskHashMapIterator that the caller has allocated. The
+ * map must not be changed while it is being iterated.
+ *
+ * @param itr the DiskHashMapIterator to initialize
+ * @param map the map
+ */
+void initDiskHashMapIterator(DiskHashMapIterator* itr, DiskHashMap* map);
+
+/**
+ * Determines whether there is another entry in the map
+ *
+ * @param itr the DiskHashMapIterator
+ * @return true if there is another entry, false otherwise
+ */
+bool hasNextDiskHashMapEntry(DiskHashMapIterator* itr);
+
+/**
+ * Gets next entry in the map. The key and valuestr of the entry point
+ * into the page cache, and are valid until the next call on the map.
+ *
+ * @param itr the DiskHashMapIterator
+ * @return the next entry or NULL if iterator is at end of the map
+ */
+MapEntry* getNextDiskHashMapEntry(DiskHashMapIterator* itr);
+
+#endif /* DISK_HASH_MAP_H_ */
@@ -0,0 +1,474 @@
+/*
+ * epoch_hash_map.c
+ *
+ * This file provides the implementation of an EpochHashMap, which is a
+ * Map whose lookups take no locks.
+ *
+ * A reader announces a read section by storing the current epoch in
+ * its EpochHashMapReader, and clears it when done. A writer that
+ * unlinks an entry or table tags it with the current epoch and then
+ * advances the epoch. The item is freed once every reader in a read
+ * section announced a later epoch: such readers started after the
+ * item was unlinked, so they cannot reach it.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "epoch_hash_map.h"
+
+#ifndef DEFAULT_LOADING_FACTOR
+#define DEFAULT_LOADING_FACTOR 0.75f
+#endif
+
+#ifndef DEFAULT_CAPACITY
+#define DEFAULT_CAPACITY 16
+#endif
+
+/**
+ * Get the chain index for the hash key in a table.
+ *
+ * @param hashCode the hash key
+ * @param table the table
+ * @return the hash key index in the table
+ */
+static inline size_t indexForHashCode(uint64_t hashCode, EpochHashTable* table) {
+	return hashCode & (table->capacity-1);  // mod function for power of 2 capacity
+}
+
+/**
+ * Allocates a hash table whose chains are all empty.
+ *
+ * @param capacity the capacity of the table, a power of two
+ * @return the new table
+ */
+static EpochHashTable* allocEpochHashTable(size_t capacity) {
+	EpochHashTable* table = (EpochHashTable*)malloc(
+		sizeof(EpochHashTable) + capacity*sizeof(EpochHashChainEntry*));
+	table->capacity = capacity;
+	for (size_t i = 0; i < capacity; i++) {
+		atomic_init(&table->hashChains[i], (EpochHashChainEntry*)NULL);
+	}
+	return table;
+}
+
+/**
+ * Frees a hash table and the entries in its chains.
+ *
+ * @param table the table
+ */
+static void freeEpochHashTable(EpochHashTable* table) {
+	for (size_t i = 0; i < table->capacity; i++) {
+		EpochHashChainEntry* entry =
+			atomic_load_explicit(&table->hashChains[i], memory_order_relaxed);
+		while (entry != (EpochHashChainEntry*)NULL) {
+			EpochHashChainEntry* next =
+				atomic_load_explicit(&entry->nextEntry, memory_order_relaxed);
+			free(entry);
+			entry = next;
+		}
+	}
+	free(table);
+}
+
+/**
+ * Allocates a chain entry.
+ *
+ * @param key the key
+ * @param value the value
+ * @param hashCode the hash code of the key
+ * @param nextEntry the next entry in the chain
+ * @return the new entry
+ */
+static EpochHashChainEntry* allocEpochHashChainEntry(MapKey key, MapValue* value,
+	uint64_t hashCode, EpochHashChainEntry* nextEntry) {
+	EpochHashChainEntry* entry =
+		(EpochHashChainEntry*)malloc(sizeof(EpochHashChainEntry));
+	entry->entry.key = key;
+	entry->entry.value = value;
+	entry->hashCode = hashCode;
+	atomic_init(&entry->nextEntry, nextEntry);
+	return entry;
+}
+
+/**
+ * Starts a read section. The reader announces an epoch and checks that
+ * it is still current; the seq_cst accesses pair with those of
+ * reclaimRetiredItems(), so a reader either sees items unlinked or is
+ * seen by the writer. The seq_cst store is a locked instruction on
+ * x86, but it writes only the reader's own cache-line-aligned slot, so
+ * readers do not contend with each other.
+ *
+ * @param reader the reader
+ * @return the current table
+ */
+static inline EpochHashTable* enterReadSection(EpochHashMapReader* reader) {
+	uint64_t epoch = atomic_load_explicit(&reader->map->epoch, memory_order_relaxed);
+	for (;;) {
+		atomic_store_explicit(&reader->epoch, epoch, memory_order_seq_cst);
+		uint64_t currentEpoch = atomic_load_explicit(&reader->map->epoch, memory_order_seq_cst);
+		if (currentEpoch == epoch) {
+			break;
+		}
+		epoch = currentEpoch;
+	}
+	return atomic_load_explicit(&reader->map->table, memory_order_acquire);
+}
+
+/**
+ * Ends a read section.
+ *
+ * @param reader the reader
+ */
+static inline void exitReadSection(EpochHashMapReader* reader) {
+	atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
+
+/**
+ * Returns the link that points to the entry for a key in a table,
+ * or to the NULL at the end of its chain if the key is not present.
+ *
+ * @param table the table
+ * @param key the key
+ * @param hashCode the hash code of the key
+ * @return the link for the key
+ */
+static EpochHashChainEntry* _Atomic* findChainLink(
+	EpochHashTable* table, MapKey key, uint64_t hashCode) {
+	EpochHashChainEntry* _Atomic* link = &table->hashChains[indexForHashCode(hashCode, table)];
+	EpochHashChainEntry* entry;
+	while ((entry = atomic_load_explicit(link, memory_order_acquire))
+			!= (EpochHashChainEntry*)NULL) {
+		if (entry->hashCode == hashCode && compareMapKey(entry->entry.key, key) == 0) {
+			break;
+		}
+		link = &entry->nextEntry;
+	}
+	return link;
+}
+
+/**
+ * Adds an unlinked entry or table to the items waiting to be freed.
+ * Called with the write lock held.
+ *
+ * @param map the map
+ * @param item the entry or table
+ * @param isTable true if item is a table
+ */
+static void retireItem(EpochHashMap* map, void* item, bool isTable) {
+	EpochRetiredItem* retired = (EpochRetiredItem*)malloc(sizeof(EpochRetiredItem));
+	retired->item = item;
+	retired->isTable = isTable;
+	retired->epoch = atomic_load_explicit(&map->epoch, memory_order_relaxed);
+	retired->next = map->retired;
+	map->retired = retired;
+}
+
+/**
+ * Frees the retired items that no reader can still see, and advances
+ * the epoch. Called with the write lock held.
+ *
+ * @param map the map
+ */
+static void reclaimRetiredItems(EpochHashMap* map) {
+	if (map->retired == (EpochRetiredItem*)NULL) {
+		return;
+	}
+	// pairs with enterReadSection(): a reader that announced an earlier
+	// epoch is seen below, and one that announces the new epoch sees
+	// the items unlinked
+	uint64_t epoch = atomic_load_explicit(&map->epoch, memory_order_relaxed);
+	atomic_store_explicit(&map->epoch, epoch+1, memory_order_seq_cst);
+	uint64_t minEpoch = UINT64_MAX;
+	for (EpochHashMapReader* reader =
+			atomic_load_explicit(&map->readers, memory_order_acquire);
+		 reader != (EpochHashMapReader*)NULL;
+		 reader = atomic_load_explicit(&reader->next, memory_order_relaxed)) {
+		uint64_t readerEpoch = atomic_load_explicit(&reader->epoch, memory_order_seq_cst);
+		if (readerEpoch != 0 && readerEpoch < minEpoch) {
+			minEpoch = readerEpoch;
+		}
+	}
+
+	EpochRetiredItem** link = &map->retired;
+	while (*link != (EpochRetiredItem*)NULL) {
+		EpochRetiredItem* retired = *link;
+		if (retired->epoch < minEpoch) {
+			*link = retired->next;
+			if (retired->isTable) {
+				freeEpochHashTable((EpochHashTable*)retired->item);
+			} else {
+				free(retired->item);
+			}
+			free(retired);
+		} else {
+			link = &retired->next;
+		}
+	}
+}
+
+/**
+ * Replaces the table with one of twice the capacity. The new table
+ * holds copies of the entries, and the old table and its entries are
+ * retired. Called with the write lock held.
+ *
+ * @param map the map
+ * @param table the current table
+ */
+static void resizeEpochHashTable(EpochHashMap* map, EpochHashTable* table) {
+	EpochHashTable* newTable = allocEpochHashTable(2*table->capacity);
+	for (size_t i = 0; i < table->capacity; i++) {
+		for (EpochHashChainEntry* entry =
+				atomic_load_explicit(&table->hashChains[i], memory_order_relaxed);
+			 entry != (EpochHashChainEntry*)NULL;
+			 entry = atomic_load_explicit(&entry->nextEntry, memory_order_relaxed)) {
+			EpochHashChainEntry* _Atomic* chain =
+				&newTable->hashChains[indexForHashCode(entry->hashCode, newTable)];
+			EpochHashChainEntry* newEntry = allocEpochHashChainEntry(entry->entry.key,
+				entry->entry.value, entry->hashCode,
+				atomic_load_explicit(chain, memory_order_relaxed));
+			atomic_store_explicit(chain, newEntry, memory_order_relaxed);
+		}
+	}
+	atomic_store_explicit(&map->table, newTable, memory_order_release);
+	retireItem(map, table, true);
+}
+
+/**
+ * Create new empty EpochHashMap.
+ *
+ * @return new EpochHashMap
+ */
+EpochHashMap* createEpochHashMap(void) {
+	EpochHashMap* map = (EpochHashMap*)malloc(sizeof(EpochHashMap));
+	atomic_init(&map->table, allocEpochHashTable(DEFAULT_CAPACITY));
+	atomic_init(&map->size, 0);
+	map->loadFactor = DEFAULT_LOADING_FACTOR;
+	map->seed = createMapEntryKeyHashSeed();
+	atomic_init(&map->epoch, 1);
+	atomic_init(&map->readers, (EpochHashMapReader*)NULL);
+	map->retired = (EpochRetiredItem*)NULL;
+	pthread_mutex_init(&map->writeLock, NULL);
+	return map;
+}
+
+/**
+ * Frees an EpochHashMap and its readers. No other thread may be
+ * using the map.
+ *
+ * @param map the EpochHashMap to free
+ */
+void deleteEpochHashMap(EpochHashMap* map) {
+	while (map->retired != (EpochRetiredItem*)NULL) {
+		EpochRetiredItem* retired = map->retired;
+		map->retired = retired->next;
+		if (retired->isTable) {
+			freeEpochHashTable((EpochHashTable*)retired->item);
+		} else {
+			free(retired->item);
+		}
+		free(retired);
+	}
+	freeEpochHashTable(atomic_load(&map->table));
+	EpochHashMapReader* reader = atomic_load(&map->readers);
+	while (reader != (EpochHashMapReader*)NULL) {
+		EpochHashMapReader* next = atomic_load(&reader->next);
+		free(reader);
+		reader = next;
+	}
+	pthread_mutex_destroy(&map->writeLock);
+	free(map);
+}
+
+/**
+ * Registers a reader of the map. Each thread that looks up keys
+ * needs a reader of its own.
+ *
+ * @param map the EpochHashMap
+ * @return the reader
+ */
+EpochHashMapReader* registerEpochHashMapReader(EpochHashMap* map) {
+	pthread_mutex_lock(&map->writeLock);
+	EpochHashMapReader* reader = atomic_load(&map->readers);
+	while (reader != (EpochHashMapReader*)NULL && reader->isRegistered) {
+		reader = atomic_load(&reader->next);
+	}
+	if (reader == (EpochHashMapReader*)NULL) {
+		reader = (EpochHashMapReader*)aligned_alloc(
+			sizeof(EpochHashMapReader), sizeof(EpochHashMapReader));
+		atomic_init(&reader->epoch, 0);
+		reader->map = map;
+		atomic_init(&reader->next, atomic_load(&map->readers));
+		atomic_store_explicit(&map->readers, reader, memory_order_release);
+	}
+	reader->isRegistered = true;
+	pthread_mutex_unlock(&map->writeLock);
+	return reader;
+}
+
+/**
+ * Unregisters a reader of the map. The reader may be reused by a
+ * later call to registerEpochHashMapReader().
+ *
+ * @param reader the reader
+ */
+void unregisterEpochHashMapReader(EpochHashMapReader* reader) {
+	pthread_mutex_lock(&reader->map->writeLock);
+	atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+	reader->isRegistered = false;
+	pthread_mutex_unlock(&reader->map->writeLock);
+}
+
+/**
+ * Returns true if the map contains a mapping for the specified key.
+ * Takes no locks.
+ *
+ * @param reader the reader of the calling thread
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsEpochHashMapKey(EpochHashMapReader* reader, MapKey key) {
+	return getEpochHashMapValue(reader, key) != (MapValue*)NULL;
+}
+
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key. Takes no locks.
+ *
+ * @param reader the reader of the calling thread
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* getEpochHashMapValue(EpochHashMapReader* reader, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, reader->map->seed);
+	EpochHashTable* table = enterReadSection(reader);
+	EpochHashChainEntry* entry =
+		atomic_load_explicit(findChainLink(table, key, hashCode), memory_order_acquire);
+	MapValue* value =
+		(entry == (EpochHashChainEntry*)NULL) ? (MapValue*)NULL : entry->entry.value;
+	exitReadSection(reader);
+	return value;
+}
+
+/**
+ * Calls the callback for each entry in the map until the callback
+ * returns false. Takes no locks. The traversal is weakly consistent:
+ * entries that writers put or delete meanwhile may or may not be
+ * visited. The callback must not use the map.
+ *
+ * @param reader the reader of the calling thread
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all entries were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachEpochHashMapEntry(EpochHashMapReader* reader,
+	HashMapForEachCallback callback, HashMapForEachData callbackData) {
+	bool result = true;
+	EpochHashTable* table = enterReadSection(reader);
+	for (size_t i = 0; i < table->capacity && result; i++) {
+		for (EpochHashChainEntry* entry =
+				atomic_load_explicit(&table->hashChains[i], memory_order_acquire);
+			 entry != (EpochHashChainEntry*)NULL && result;
+			 entry = atomic_load_explicit(&entry->nextEntry, memory_order_acquire)) {
+			result = (*callback)(&entry->entry, callbackData);
+		}
+	}
+	exitReadSection(reader);
+	return result;
+}
+
+/**
+ * Associates the specified value with the specified key in this map.
+ * Writers are serialized.
+ *
+ * @param map the EpochHashMap
+ * @param key the key for the value to put
+ * @param value the value for the key
+ * @return the previous value for the key, or NULL for a new entry
+ */
+MapValue* putEpochHashMapEntry(EpochHashMap* map, MapKey key, MapValue* value) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	pthread_mutex_lock(&map->writeLock);
+	EpochHashTable* table = atomic_load_explicit(&map->table, memory_order_relaxed);
+	EpochHashChainEntry* _Atomic* link = findChainLink(table, key, hashCode);
+	EpochHashChainEntry* oldEntry = atomic_load_explicit(link, memory_order_relaxed);
+	MapValue* oldValue = (MapValue*)NULL;
+	if (oldEntry != (EpochHashChainEntry*)NULL) {
+		// replace the entry so readers see either the old or new value
+		oldValue = oldEntry->entry.value;
+		EpochHashChainEntry* newEntry = allocEpochHashChainEntry(key, value, hashCode,
+			atomic_load_explicit(&oldEntry->nextEntry, memory_order_relaxed));
+		atomic_store_explicit(link, newEntry, memory_order_release);
+		retireItem(map, oldEntry, false);
+	} else {
+		// add the entry at the head of its chain
+		EpochHashChainEntry* _Atomic* chain =
+			&table->hashChains[indexForHashCode(hashCode, table)];
+		EpochHashChainEntry* newEntry = allocEpochHashChainEntry(key, value, hashCode,
+			atomic_load_explicit(chain, memory_order_relaxed));
+		atomic_store_explicit(chain, newEntry, memory_order_release);
+		size_t size = atomic_load_explicit(&map->size, memory_order_relaxed) + 1;
+		atomic_store_explicit(&map->size, size, memory_order_relaxed);
+		if (size > table->capacity*map->loadFactor) {
+			resizeEpochHashTable(map, table);
+		}
+	}
+	reclaimRetiredItems(map);
+	pthread_mutex_unlock(&map->writeLock);
+	return oldValue;
+}
+
+/**
+ * Removes the mapping for a key from this map if it is present.
+ * Writers are serialized.
+ *
+ * @param map the EpochHashMap
+ * @param key the key for the value to remove
+ * @return the value of the entry that was removed
+ */
+MapValue* deleteEpochHashMapEntryForKey(EpochHashMap* map, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	pthread_mutex_lock(&map->writeLock);
+	EpochHashTable* table = atomic_load_explicit(&map->table, memory_order_relaxed);
+	EpochHashChainEntry* _Atomic* link = findChainLink(table, key, hashCode);
+	EpochHashChainEntry* entry = atomic_load_explicit(link, memory_order_relaxed);
+	MapValue* value = (MapValue*)NULL;
+	if (entry != (EpochHashChainEntry*)NULL) {
+		// readers at the entry still find the rest of the chain through it
+		value = entry->entry.value;
+		atomic_store_explicit(link,
+			atomic_load_explicit(&entry->nextEntry, memory_order_relaxed),
+			memory_order_release);
+		atomic_fetch_sub_explicit(&map->size, 1, memory_order_relaxed);
+		retireItem(map, entry, false);
+		reclaimRetiredItems(map);
+	}
+	pthread_mutex_unlock(&map->writeLock);
+	return value;
+}
+
+/**
+ * Frees the unlinked entries and tables that no reader can still see.
+ * Writers do this after each change; a writer can call it again once
+ * readers have moved on so memory is not held until the next change.
+ *
+ * @param map the EpochHashMap
+ */
+void reclaimEpochHashMap(EpochHashMap* map) {
+	pthread_mutex_lock(&map->writeLock);
+	reclaimRetiredItems(map);
+	pthread_mutex_unlock(&map->writeLock);
+}
+
+/**
+ * Returns the number of key-value mappings in this map.
+ *
+ * @param map the EpochHashMap
+ * @return the number of entries in the map
+ */
+size_t getEpochHashMapSize(EpochHashMap* map) {
+	return atomic_load_explicit(&map->size, memory_order_relaxed);
+}
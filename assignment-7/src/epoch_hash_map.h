@@ -0,0 +1,191 @@
+/*
+ * epoch_hash_map.h
+ *
+ * This file provides the structures and function declarations of an
+ * EpochHashMap, which is a Map for read-mostly workloads whose lookups
+ * take no locks. Readers walk the hash chains while writers, one at a
+ * time, publish new chain entries and tables with release stores.
+ * Entries and tables that writers unlink are freed only once no reader
+ * that could still see them is in a read section (epoch-based
+ * reclamation).
+ *
+ * Each reader thread registers an EpochHashMapReader, and passes it
+ * to the lookup functions. A read section costs a store to the reader's
+ * own cache line, so lookups from different threads do not contend.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef EPOCH_HASH_MAP_H_
+#define EPOCH_HASH_MAP_H_
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "hash_map.h"
+
+/**
+ * An entry in a hash chain. An entry is never changed once it is
+ * published except for its next link; a put for an existing key
+ * replaces the entry.
+ */
+typedef struct EpochHashChainEntry {
+	MapEntry entry;						// entry key/value pair
+	uint64_t hashCode;					// hash code for the entry key
+	struct EpochHashChainEntry* _Atomic nextEntry;	// next entry in chain
+} EpochHashChainEntry;
+
+/**
+ * The hash table. A resize builds a new table with copies of the
+ * entries and swaps it in, so readers of the old table are undisturbed.
+ */
+typedef struct {
+	size_t capacity;					// the size of the hash table
+	EpochHashChainEntry* _Atomic hashChains[];	// first entry of each chain
+} EpochHashTable;
+
+/**
+ * An entry or table that has been unlinked, waiting until no reader
+ * can still see it.
+ */
+typedef struct EpochRetiredItem {
+	void* item;							// the entry or table
+	bool isTable;						// true if item is an EpochHashTable
+	uint64_t epoch;						// epoch in which it was unlinked
+	struct EpochRetiredItem* next;		// next retired item
+} EpochRetiredItem;
+
+struct EpochHashMap;
+
+/**
+ * A reader of the map. Readers are aligned to a cache line so that
+ * read sections of different threads do not share a line.
+ */
+typedef struct EpochHashMapReader {
+	_Atomic uint64_t epoch;				// epoch of read section, or 0 if none
+	struct EpochHashMap* map;			// the map
+	bool isRegistered;					// false if free for reuse
+	struct EpochHashMapReader* _Atomic next;	// next registered reader
+} __attribute__((aligned(64))) EpochHashMapReader;
+
+/**
+ * The epoch map.
+ */
+typedef struct EpochHashMap {
+	EpochHashTable* _Atomic table;		// the current table
+	_Atomic size_t size;				// number of entries in table
+	float loadFactor;					// % full before resizing table
+	uint64_t seed;						// hash seed for keys of this map
+	_Atomic uint64_t epoch;				// current epoch, starting from 1
+	EpochHashMapReader* _Atomic readers;	// the readers
+	EpochRetiredItem* retired;			// items waiting to be freed
+	pthread_mutex_t writeLock;			// serializes writers
+} EpochHashMap;
+
+/**
+ * Create new empty EpochHashMap.
+ *
+ * @return new EpochHashMap
+ */
+EpochHashMap* createEpochHashMap(void);
+
+/**
+ * Frees an EpochHashMap and its readers. No other thread may be
+ * using the map.
+ *
+ * @param map the EpochHashMap to free
+ */
+void deleteEpochHashMap(EpochHashMap* map);
+
+/**
+ * Registers a reader of the map. Each thread that looks up keys
+ * needs a reader of its own.
+ *
+ * @param map the EpochHashMap
+ * @return the reader
+ */
+EpochHashMapReader* registerEpochHashMapReader(EpochHashMap* map);
+
+/**
+ * Unregisters a reader of the map. The reader may be reused by a
+ * later call to registerEpochHashMapReader().
+ *
+ * @param reader the reader
+ */
+void unregisterEpochHashMapReader(EpochHashMapReader* reader);
+
+/**
+ * Returns true if the map contains a mapping for the specified key.
+ * Takes no locks.
+ *
+ * @param reader the reader of the calling thread
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsEpochHashMapKey(EpochHashMapReader* reader, MapKey key);
+
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key. Takes no locks.
+ *
+ * @param reader the reader of the calling thread
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* getEpochHashMapValue(EpochHashMapReader* reader, MapKey key);
+
+/**
+ * Calls the callback for each entry in the map until the callback
+ * returns false. Takes no locks. The traversal is weakly consistent:
+ * entries that writers put or delete meanwhile may or may not be
+ * visited. The callback must not use the map.
+ *
+ * @param reader the reader of the calling thread
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all entries were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachEpochHashMapEntry(EpochHashMapReader* reader,
+	HashMapForEachCallback callback, HashMapForEachData callbackData);
+
+/**
+ * Associates the specified value with the specified key in this map.
+ * Writers are serialized.
+ *
+ * @param map the EpochHashMap
+ * @param key the key for the value to put
+ * @param value the value for the key
+ * @return the previous value for the key, or NULL for a new entry
+ */
+MapValue* putEpochHashMapEntry(EpochHashMap* map, MapKey key, MapValue* value);
+
+/**
+ * Removes the mapping for a key from this map if it is present.
+ * Writers are serialized.
+ *
+ * @param map the EpochHashMap
+ * @param key the key for the value to remove
+ * @return the value of the entry that was removed
+ */
+MapValue* deleteEpochHashMapEntryForKey(EpochHashMap* map, MapKey key);
+
+/**
+ * Frees the unlinked entries and tables that no reader can still see.
+ * Writers do this after each change; a writer can call it again once
+ * readers have moved on so memory is not held until the next change.
+ *
+ * @param map the EpochHashMap
+ */
+void reclaimEpochHashMap(EpochHashMap* map);
+
+/**
+ * Returns the number of key-value mappings in this map.
+ *
+ * @param map the EpochHashMap
+ * @return the number of entries in the map
+ */
+size_t getEpochHashMapSize(EpochHashMap* map);
+
+#endif /* EPOCH_HASH_MAP_H_ */
@@ -0,0 +1,310 @@
+/*
+ * frozen_hash_map.c
+ *
+ * This file provides the implementation of a FrozenHashMap, which is an
+ * immutable copy of a HashMap that uses a minimal perfect hash.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "frozen_hash_map.h"
+
+/** Number of hash seeds to try before giving up */
+#define FROZEN_MAX_SEEDS 8
+
+/**
+ * An entry collected from the map being frozen.
+ */
+typedef struct {
+	MapEntry entry;						// entry key/value pair
+	uint64_t hashCode;					// hash code for the entry key
+} FrozenSource;
+
+/**
+ * Data for the callback that collects the entries of a map.
+ */
+typedef struct {
+	FrozenSource* sources;				// the collected entries
+	size_t count;						// number of entries collected
+} FrozenSourceData;
+
+/**
+ * For-each callback that collects an entry.
+ *
+ * @param entry the entry
+ * @param data the FrozenSourceData
+ * @return true to continue
+ */
+static bool collectFrozenSource(MapEntry* entry, HashMapForEachData data) {
+	FrozenSourceData* sourceData = (FrozenSourceData*)data;
+	sourceData->sources[sourceData->count++].entry = *entry;
+	return true;
+}
+
+/**
+ * Returns the bucket of a key hash code. The high bits of the hash
+ * code choose the bucket.
+ *
+ * @param hashCode the hash code
+ * @param nBuckets the number of buckets
+ * @return the bucket
+ */
+static inline size_t getFrozenBucket(uint64_t hashCode, size_t nBuckets) {
+	return ((hashCode >> 32) * nBuckets) >> 32;
+}
+
+/**
+ * Returns the slot of a key hash code for a displacement. Each
+ * displacement remixes the hash code, so it places the keys of a
+ * bucket independently of the other displacements.
+ *
+ * @param hashCode the hash code
+ * @param displacement the displacement of the key's bucket
+ * @param size the number of slots
+ * @return the slot
+ */
+static inline size_t getFrozenSlot(
+	uint64_t hashCode, uint32_t displacement, size_t size) {
+	uint64_t h = hashCode ^ (displacement * 0x9E3779B97F4A7C15ULL);
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	return ((h >> 32) * size) >> 32;
+}
+
+/**
+ * Finds a displacement for every bucket, placing the largest buckets
+ * first while the table is still mostly empty.
+ *
+ * @param sources the entries, with their hash codes
+ * @param size the number of entries and slots
+ * @param nBuckets the number of buckets
+ * @param displacements set to the displacement of each bucket
+ * @param slotSources set to the entry of each slot
+ * @return true if every bucket was placed, false if a bucket could
+ *   not be placed with this hash seed
+ */
+static bool placeFrozenBuckets(FrozenSource* sources, size_t size,
+	size_t nBuckets, uint32_t* displacements, FrozenSource** slotSources) {
+	// group the entries by bucket
+	size_t* bucketStart = (size_t*)calloc(nBuckets+1, sizeof(size_t));
+	for (size_t i = 0; i < size; i++) {
+		bucketStart[getFrozenBucket(sources[i].hashCode, nBuckets) + 1]++;
+	}
+	size_t maxBucketSize = 0;
+	for (size_t b = 0; b < nBuckets; b++) {
+		if (bucketStart[b+1] > maxBucketSize) {
+			maxBucketSize = bucketStart[b+1];
+		}
+		bucketStart[b+1] += bucketStart[b];
+	}
+	size_t* next = (size_t*)malloc(nBuckets * sizeof(size_t));
+	memcpy(next, bucketStart, nBuckets * sizeof(size_t));
+	FrozenSource** bucketEntries = (FrozenSource**)malloc(size * sizeof(FrozenSource*));
+	for (size_t i = 0; i < size; i++) {
+		bucketEntries[next[getFrozenBucket(sources[i].hashCode, nBuckets)]++] = &sources[i];
+	}
+
+	// order the buckets from largest to smallest
+	size_t* sizeStart = (size_t*)calloc(maxBucketSize+2, sizeof(size_t));
+	for (size_t b = 0; b < nBuckets; b++) {
+		sizeStart[maxBucketSize - (bucketStart[b+1] - bucketStart[b]) + 1]++;
+	}
+	for (size_t s = 0; s <= maxBucketSize; s++) {
+		sizeStart[s+1] += sizeStart[s];
+	}
+	size_t* bucketOrder = next;
+	for (size_t b = 0; b < nBuckets; b++) {
+		bucketOrder[sizeStart[maxBucketSize - (bucketStart[b+1] - bucketStart[b])]++] = b;
+	}
+	free(sizeStart);
+
+	// try displacements for each bucket until its entries all land in
+	// free slots; a last bucket may need about size tries
+	uint64_t maxTries = (size < (1<<16)) ? (1<<20) : 16*(uint64_t)size;
+	size_t* bucketSlots = (size_t*)malloc((maxBucketSize+1) * sizeof(size_t));
+	bool placed = true;
+	for (size_t o = 0; placed && o < nBuckets; o++) {
+		size_t b = bucketOrder[o];
+		size_t bucketSize = bucketStart[b+1] - bucketStart[b];
+		FrozenSource** entries = &bucketEntries[bucketStart[b]];
+		placed = false;
+		for (uint64_t d = 0; !placed && d < maxTries && d <= UINT32_MAX; d++) {
+			size_t k = 0;
+			for ( ; k < bucketSize; k++) {
+				size_t slot = getFrozenSlot(entries[k]->hashCode, d, size);
+				if (slotSources[slot] != (FrozenSource*)NULL) {
+					break;
+				}
+				slotSources[slot] = entries[k];
+				bucketSlots[k] = slot;
+			}
+			placed = (k == bucketSize);
+			if (placed) {
+				displacements[b] = d;
+			} else {
+				// undo the slots taken on this try
+				while (k > 0) {
+					slotSources[bucketSlots[--k]] = (FrozenSource*)NULL;
+				}
+			}
+		}
+	}
+
+	free(bucketSlots);
+	free(bucketOrder);
+	free(bucketEntries);
+	free(bucketStart);
+	return placed;
+}
+
+/**
+ * Creates a FrozenHashMap with the entries of a map. If the map owns
+ * its keys, the frozen map owns copies of them, so the map can be
+ * deleted afterwards; otherwise it shares the caller's keys.
+ *
+ * @param map the HashMap
+ * @return the frozen map, or NULL if no perfect hash was found
+ */
+FrozenHashMap* freezeHashMap(HashMap* map) {
+	size_t size = getHashMapSize(map);
+	if (size > UINT32_MAX) {
+		return (FrozenHashMap*)NULL;
+	}
+	FrozenSourceData sourceData = {
+		(FrozenSource*)malloc((size+1) * sizeof(FrozenSource)), 0
+	};
+	forEachHashMapEntry(map, collectFrozenSource, &sourceData);
+
+	FrozenHashMap* frozenMap = (FrozenHashMap*)malloc(sizeof(FrozenHashMap));
+	frozenMap->size = size;
+	frozenMap->nBuckets = (size + FROZEN_BUCKET_SIZE-1) / FROZEN_BUCKET_SIZE;
+	if (frozenMap->nBuckets == 0) {
+		frozenMap->nBuckets = 1;
+	}
+	frozenMap->displacements = (uint32_t*)calloc(frozenMap->nBuckets, sizeof(uint32_t));
+	FrozenSource** slotSources = (FrozenSource**)malloc((size+1) * sizeof(FrozenSource*));
+
+	// keys with equal hash codes cannot be separated, so a failure
+	// is retried with a new seed
+	bool placed = false;
+	for (int attempt = 0; !placed && attempt < FROZEN_MAX_SEEDS; attempt++) {
+		frozenMap->seed = createMapEntryKeyHashSeed();
+		for (size_t i = 0; i < size; i++) {
+			sourceData.sources[i].hashCode =
+				getMapEntryKeyHashCode(sourceData.sources[i].entry.key, frozenMap->seed);
+			slotSources[i] = (FrozenSource*)NULL;
+		}
+		placed = placeFrozenBuckets(sourceData.sources, size,
+			frozenMap->nBuckets, frozenMap->displacements, slotSources);
+	}
+
+	if (placed) {
+		frozenMap->keyArena = (map->keyArena != (MapKeyArena*)NULL)
+			? createMapKeyArena() : (MapKeyArena*)NULL;
+		frozenMap->slots =
+			(FrozenHashMapSlot*)malloc((size+1) * sizeof(FrozenHashMapSlot));
+		for (size_t i = 0; i < size; i++) {
+			FrozenHashMapSlot* slot = &frozenMap->slots[i];
+			MapEntry* entry = &slotSources[i]->entry;
+			slot->entry.key = (frozenMap->keyArena == (MapKeyArena*)NULL) ? entry->key
+				: copyMapKeyToArena(frozenMap->keyArena, entry->key, strlen(entry->key));
+			slot->entry.value = entry->value;
+			slot->hashCode = slotSources[i]->hashCode;
+		}
+	} else {
+		free(frozenMap->displacements);
+		free(frozenMap);
+		frozenMap = (FrozenHashMap*)NULL;
+	}
+	free(slotSources);
+	free(sourceData.sources);
+	return frozenMap;
+}
+
+/**
+ * Deletes a FrozenHashMap and any copies of its keys.
+ *
+ * @param map the frozen map
+ */
+void deleteFrozenHashMap(FrozenHashMap* map) {
+	if (map->keyArena != (MapKeyArena*)NULL) {
+		deleteMapKeyArena(map->keyArena);
+	}
+	free(map->slots);
+	free(map->displacements);
+	free(map);
+}
+
+/**
+ * Finds the entry for a key. The key's slot is the only place the
+ * key can be, so this takes one probe and at most one key compare.
+ *
+ * @param map the frozen map
+ * @param key the key
+ * @return the entry for the key, or NULL if the key is not present
+ */
+static inline MapEntry* findFrozenHashMapEntry(FrozenHashMap* map, MapKey key) {
+	if (map->size == 0) {
+		return (MapEntry*)NULL;
+	}
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	uint32_t displacement = map->displacements[getFrozenBucket(hashCode, map->nBuckets)];
+	FrozenHashMapSlot* slot = &map->slots[getFrozenSlot(hashCode, displacement, map->size)];
+	return (slot->hashCode == hashCode && compareMapKey(key, slot->entry.key) == 0)
+		? &slot->entry : (MapEntry*)NULL;
+}
+
+/**
+ * Returns true if the frozen map contains a mapping for the specified key.
+ *
+ * @param map the frozen map
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsFrozenHashMapKey(FrozenHashMap* map, MapKey key) {
+	return findFrozenHashMapEntry(map, key) != (MapEntry*)NULL;
+}
+
+/**
+ * Gets the value to which the specified key is mapped.
+ *
+ * @param map the frozen map
+ * @param key the entry key for the value to get
+ * @return the value, or NULL if the map contains no mapping for the key
+ */
+MapValue* getFrozenHashMapValue(FrozenHashMap* map, MapKey key) {
+	MapEntry* entry = findFrozenHashMapEntry(map, key);
+	return (entry == (MapEntry*)NULL) ? (MapValue*)NULL : entry->value;
+}
+
+/**
+ * Calls a function with each entry of the frozen map, in slot order.
+ *
+ * @param map the frozen map
+ * @param callback the function to call
+ * @param callbackData data passed to each call
+ * @return true if called for every entry, false if a call returned false
+ */
+bool forEachFrozenHashMapEntry(FrozenHashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData) {
+	for (size_t i = 0; i < map->size; i++) {
+		if (!callback(&map->slots[i].entry, callbackData)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Returns the number of key-value mappings in the frozen map.
+ *
+ * @param map the frozen map
+ * @return the number of entries in the map
+ */
+size_t getFrozenHashMapSize(FrozenHashMap* map) {
+	return map->size;
+}
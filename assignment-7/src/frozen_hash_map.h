@@ -0,0 +1,105 @@
+/*
+ * frozen_hash_map.h
+ *
+ * This file provides the structures and function declarations of a
+ * FrozenHashMap, which is an immutable copy of a HashMap that is built
+ * once and then only queried. It uses a minimal perfect hash in the
+ * style of CHD (compress, hash and displace): the keys are hashed into
+ * small buckets, and each bucket stores the displacement that places
+ * all of its keys into distinct slots of a table with exactly one slot
+ * per key. A lookup hashes the key, reads its bucket's displacement,
+ * and compares the key in the one slot it can be in. The displacements
+ * take 1 byte per key, so mid-sized maps keep them in cache.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef FROZEN_HASH_MAP_H_
+#define FROZEN_HASH_MAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hash_map.h"
+#include "map_key_arena.h"
+
+/** Average number of keys in each bucket of a FrozenHashMap */
+#define FROZEN_BUCKET_SIZE 4
+
+/**
+ * A slot of the frozen map. The hash code lets a lookup for a missing
+ * key usually fail without reading the key.
+ */
+typedef struct {
+	MapEntry entry;						// entry key/value pair
+	uint64_t hashCode;					// hash code for the entry key
+} FrozenHashMapSlot;
+
+/**
+ * The frozen map.
+ */
+typedef struct {
+	FrozenHashMapSlot* slots;			// one entry per key
+	uint32_t* displacements;			// displacement of each bucket
+	size_t size;						// number of entries and slots
+	size_t nBuckets;					// number of buckets
+	uint64_t seed;						// hash seed for keys of this map
+	MapKeyArena* keyArena;				// copies of the keys, or NULL if
+										// the keys are not owned
+} FrozenHashMap;
+
+/**
+ * Creates a FrozenHashMap with the entries of a map. If the map owns
+ * its keys, the frozen map owns copies of them, so the map can be
+ * deleted afterwards; otherwise it shares the caller's keys.
+ *
+ * @param map the HashMap
+ * @return the frozen map, or NULL if no perfect hash was found
+ */
+FrozenHashMap* freezeHashMap(HashMap* map);
+
+/**
+ * Deletes a FrozenHashMap and any copies of its keys.
+ *
+ * @param map the frozen map
+ */
+void deleteFrozenHashMap(FrozenHashMap* map);
+
+/**
+ * Returns true if the frozen map contains a mapping for the specified key.
+ *
+ * @param map the frozen map
+ * @param key the entry key to check
+ * @return true if the map contains the key, false otherwise
+ */
+bool containsFrozenHashMapKey(FrozenHashMap* map, MapKey key);
+
+/**
+ * Gets the value to which the specified key is mapped.
+ *
+ * @param map the frozen map
+ * @param key the entry key for the value to get
+ * @return the value, or NULL if the map contains no mapping for the key
+ */
+MapValue* getFrozenHashMapValue(FrozenHashMap* map, MapKey key);
+
+/**
+ * Calls a function with each entry of the frozen map, in slot order.
+ *
+ * @param map the frozen map
+ * @param callback the function to call
+ * @param callbackData data passed to each call
+ * @return true if called for every entry, false if a call returned false
+ */
+bool forEachFrozenHashMapEntry(FrozenHashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData);
+
+/**
+ * Returns the number of key-value mappings in the frozen map.
+ *
+ * @param map the frozen map
+ * @return the number of entries in the map
+ */
+size_t getFrozenHashMapSize(FrozenHashMap* map);
+
+#endif /* FROZEN_HASH_MAP_H_ */
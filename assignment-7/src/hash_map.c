@@ -7,10 +7,14 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <strings.h>
 #include "hash_map.h"
 #include "hash_map_iterator.h"
 
+// chained table; see hash_map_open.c for the open-addressed table
+#ifndef HASH_MAP_OPEN_ADDRESSING
+
 #ifndef DEFAULT_LOADING_FACTOR
 #define DEFAULT_LOADING_FACTOR 0.75f;
 #endif
@@ -19,6 +23,21 @@
 #define DEFAULT_CAPACITY 16
 #endif
 
+#ifndef REHASH_STEP_ENTRIES
+#define REHASH_STEP_ENTRIES 8	// old table entries moved per operation
+#endif
+
+#ifndef MIN_ENTRY_CAPACITY
+#define MIN_ENTRY_CAPACITY 8	// size of the first entry array
+#endif
+
+#ifndef BATCH_GROUP_SIZE
+#define BATCH_GROUP_SIZE 16		// keys whose lookups are overlapped
+#endif
+
+/** Index that marks the end of a hash chain */
+#define NO_ENTRY ((HashEntryIndex)-1)
+
 /**
  * Get the hash table index for the hash key in a table of a given capacity.
  *
@@ -26,10 +45,298 @@
  * @param capacity the capacity of the table;
  * @return the hash key index in the table
  */
-static size_t indexForTableEntryArray(int hashCode, size_t capacity) {
+static size_t indexForTableEntryArray(uint64_t hashCode, size_t capacity) {
 	return hashCode & (capacity-1);  // mod function for power of 2 capacity
 }
 
+/**
+ * Allocates a hash table whose chains are all empty. A table of one
+ * chain is the one kept in the map.
+ *
+ * @param map the map
+ * @param capacity the capacity of the table
+ * @return the new table
+ */
+static HashTableEntry* allocTableEntryArray(HashMap* map, size_t capacity) {
+	HashTableEntry* table = (capacity == 1) ? map->smallTable
+		: (HashTableEntry*)malloc(capacity*sizeof(HashTableEntry));
+	for (int i = 0; i < capacity; i++) {
+		table[i].hashChain = NO_ENTRY;
+	}
+	return table;
+}
+
+/**
+ * Frees a hash table unless it is the one kept in the map.
+ *
+ * @param map the map
+ * @param table the table, or NULL
+ */
+static void freeTableEntryArray(HashMap* map, HashTableEntry* table) {
+	if (table != map->smallTable) {
+		free(table);
+	}
+}
+
+/**
+ * Returns true if the entry at an index of the entry array was deleted.
+ *
+ * @param map the map
+ * @param index the index of the entry
+ * @return true if the entry was deleted
+ */
+static inline bool isDeletedEntry(HashMap* map, size_t index) {
+	return map->entries[index].entry.key == (MapKey)NULL;
+}
+
+/**
+ * Returns the number of entries a table of the specified capacity
+ * holds before it is resized. A table of one chain is searched
+ * linearly, and holds up to SMALL_MAP_ENTRIES entries.
+ *
+ * @param map the map
+ * @param capacity the capacity of the table
+ * @return the maximum number of entries
+ */
+static inline size_t maxEntriesForCapacity(HashMap* map, size_t capacity) {
+	return (capacity == 1) ? SMALL_MAP_ENTRIES : capacity*map->loadFactor;
+}
+
+/**
+ * Returns the smallest table capacity that can hold the specified
+ * number of entries without being resized.
+ *
+ * @param map the map
+ * @param nEntries the number of entries
+ * @return the capacity, 1 for a small map, otherwise a power of
+ *  two >= DEFAULT_CAPACITY
+ */
+static size_t capacityForEntries(HashMap* map, size_t nEntries) {
+	if (nEntries <= SMALL_MAP_ENTRIES) {
+		return 1;
+	}
+	size_t capacity = DEFAULT_CAPACITY;
+	while (nEntries > capacity*map->loadFactor) {
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+/**
+ * Get the table entry whose chain holds the key with the hash code.
+ * While the map is being rehashed, this is the entry in the old table
+ * unless that entry has already been moved to the new table.
+ *
+ * @param map the map
+ * @param hashCode the hash key
+ * @return the table entry for the hash key
+ */
+static HashTableEntry* tableEntryForHashCode(HashMap* map, uint64_t hashCode) {
+	if (map->oldHashTable != (HashTableEntry*)NULL) {
+		size_t oldIndex = indexForTableEntryArray(hashCode, map->oldCapacity);
+		if (oldIndex >= map->rehashIndex) {
+			return &map->oldHashTable[oldIndex];
+		}
+	}
+	return &map->hashTable[indexForTableEntryArray(hashCode, map->capacity)];
+}
+
+/**
+ * Returns true if the map keeps a Bloom filter that shows that no key
+ * with the hash code is in the map.
+ *
+ * @param map the map
+ * @param hashCode the hash key
+ * @return true if the key is not in the map, false if it may be
+ */
+static inline bool isBloomFilterMiss(HashMap* map, uint64_t hashCode) {
+	return map->bloomFilter != (BloomFilter*)NULL
+		&& !mayContainBloomFilterHashCode(map->bloomFilter, hashCode);
+}
+
+/**
+ * Finds the link in the chain of the table entry that holds the index
+ * of the chain entry for the key, without counting the search. The link
+ * is the hashChain field of the table entry or the nextEntry field of
+ * the previous chain entry.
+ *
+ * @param map the map
+ * @param tableEntry the table entry for the hash key
+ * @param key the key
+ * @param hashCode the hash key of the key
+ * @param nProbes set to the number of chain entries probed
+ * @return the link to the chain entry for the key, or to NO_ENTRY at
+ *  the end of the chain if the key is not in the chain
+ */
+static HashEntryIndex* searchChain(HashMap* map,
+	HashTableEntry* tableEntry, MapKey key, uint64_t hashCode, size_t* nProbes) {
+	size_t keyLength = SIZE_MAX;
+	HashEntryIndex* link = &tableEntry->hashChain;
+	*nProbes = 0;
+	for ( ; *link != NO_ENTRY; link = &map->entries[*link].nextEntry) {
+		HashChainEntry* chainEntry = &map->entries[*link];
+		(*nProbes)++;
+		if (   chainEntry->hashCode == hashCode
+			&& isEqualMapEntryKey(map->keyArena, key, &keyLength, chainEntry->entry.key)) {
+			break;
+		}
+	}
+	return link;
+}
+
+/**
+ * Finds the link in the chain of the table entry that holds the index
+ * of the chain entry for the key. The link is the hashChain field of
+ * the table entry or the nextEntry field of the previous chain entry.
+ *
+ * @param map the map
+ * @param tableEntry the table entry for the hash key
+ * @param key the key
+ * @param hashCode the hash key of the key
+ * @return the link to the chain entry for the key, or to NO_ENTRY at
+ *  the end of the chain if the key is not in the chain
+ */
+static HashEntryIndex* findChainLink(HashMap* map,
+	HashTableEntry* tableEntry, MapKey key, uint64_t hashCode) {
+	size_t nProbes;
+	HashEntryIndex* link = searchChain(map, tableEntry, key, hashCode, &nProbes);
+	HASH_MAP_COUNT_SEARCH(map, *link != NO_ENTRY, nProbes);
+	return link;
+}
+
+/**
+ * Moves entries for up to nEntries old table entries to the new table,
+ * and frees the old table once all its entries have been moved.
+ *
+ * @param map the map
+ * @param nEntries the maximum number of old table entries to move
+ */
+static void transferTableEntries(HashMap* map, size_t nEntries) {
+	HASH_MAP_START_TIMER(start);
+	for ( ; nEntries > 0 && map->rehashIndex < map->oldCapacity; nEntries--) {
+		// transfer entries for list entries at current index
+		HashEntryIndex listEntry = map->oldHashTable[map->rehashIndex].hashChain;
+		map->oldHashTable[map->rehashIndex++].hashChain = NO_ENTRY;
+		while (listEntry != NO_ENTRY) {
+			HashChainEntry* chainEntry = &map->entries[listEntry];
+			HashEntryIndex nextEntry = chainEntry->nextEntry;
+
+			// splice in at head of the new table entry chain
+			size_t newIndex = indexForTableEntryArray(chainEntry->hashCode, map->capacity);
+			chainEntry->nextEntry = map->hashTable[newIndex].hashChain;
+			map->hashTable[newIndex].hashChain = listEntry;
+
+			listEntry = nextEntry;
+		}
+	}
+
+	if (map->rehashIndex == map->oldCapacity) {
+		freeTableEntryArray(map, map->oldHashTable);
+		map->oldHashTable = (HashTableEntry*)NULL;
+		map->oldCapacity = 0;
+		map->rehashIndex = 0;
+	}
+	HASH_MAP_STOP_TIMER(map, start);
+}
+
+/**
+ * Does one bounded step of rehashing if the map is being rehashed.
+ *
+ * @param map the map
+ */
+static void rehashStep(HashMap* map) {
+	if (map->oldHashTable != (HashTableEntry*)NULL) {
+		transferTableEntries(map, REHASH_STEP_ENTRIES);
+	}
+}
+
+/**
+ * Moves the entries that follow deleted entries down in the entry
+ * array, and links all the entries into a new table of the specified
+ * capacity. Any rehash in progress is finished by this.
+ *
+ * @param map the map
+ * @param newCapacity the new capacity, must be a power of two that
+ *  can hold the entries of the map.
+ */
+static void compactEntryArray(HashMap* map, size_t newCapacity) {
+	HASH_MAP_START_TIMER(start);
+	if (newCapacity != map->capacity) {
+		HASH_MAP_COUNT_RESIZE(map);
+	}
+	freeTableEntryArray(map, map->oldHashTable);
+	map->oldHashTable = (HashTableEntry*)NULL;
+	map->oldCapacity = 0;
+	map->rehashIndex = 0;
+	freeTableEntryArray(map, map->hashTable);
+	map->hashTable = allocTableEntryArray(map, newCapacity);
+	map->capacity = newCapacity;
+
+	size_t count = 0;
+	for (size_t i = 0; i < map->entryCount; i++) {
+		if (!isDeletedEntry(map, i)) {
+			HashChainEntry* chainEntry = &map->entries[count];
+			*chainEntry = map->entries[i];
+			HashTableEntry* tableEntry = &map->hashTable[
+				indexForTableEntryArray(chainEntry->hashCode, map->capacity)];
+			chainEntry->nextEntry = tableEntry->hashChain;
+			tableEntry->hashChain = count++;
+		}
+	}
+	map->entryCount = count;
+	rebuildHashMapBloomFilter(map);
+	HASH_MAP_STOP_TIMER(map, start);
+}
+
+/**
+ * Changes the size of the entry array. An array of up to
+ * SMALL_MAP_ENTRIES entries is the one kept in the map.
+ *
+ * @param map the map
+ * @param entryCapacity the new size, at least the number of entries used
+ */
+static void resizeEntryArray(HashMap* map, size_t entryCapacity) {
+	if (entryCapacity <= SMALL_MAP_ENTRIES) {
+		if (map->entries != map->smallEntries) {
+			memcpy(map->smallEntries, map->entries, map->entryCount*sizeof(HashChainEntry));
+			free(map->entries);
+			map->entries = map->smallEntries;
+		}
+		entryCapacity = SMALL_MAP_ENTRIES;
+	} else if (map->entries == map->smallEntries) {
+		map->entries = (HashChainEntry*)malloc(entryCapacity*sizeof(HashChainEntry));
+		memcpy(map->entries, map->smallEntries, map->entryCount*sizeof(HashChainEntry));
+	} else {
+		map->entries = (HashChainEntry*)realloc(
+			map->entries, entryCapacity*sizeof(HashChainEntry));
+	}
+	map->entryCapacity = entryCapacity;
+}
+
+/**
+ * Makes room at the end of the entry array for the specified number of
+ * new entries. Deleted entries are removed first if at least half the
+ * used entries are deleted, otherwise the array is grown.
+ *
+ * @param map the map
+ * @param nEntries the number of entries to make room for
+ */
+static void reserveEntryArray(HashMap* map, size_t nEntries) {
+	if (map->entryCount + nEntries <= map->entryCapacity) {
+		return;
+	}
+	if (map->entryCount - map->size >= map->entryCount/2 && map->size < map->entryCount) {
+		compactEntryArray(map, map->capacity);
+	}
+	if (map->entryCount + nEntries > map->entryCapacity) {
+		size_t entryCapacity = (map->entryCapacity < MIN_ENTRY_CAPACITY)
+			? MIN_ENTRY_CAPACITY : 2*map->entryCapacity;
+		if (entryCapacity < map->entryCount + nEntries) {
+			entryCapacity = map->entryCount + nEntries;
+		}
+		resizeEntryArray(map, entryCapacity);
+	}
+}
 
 /**
  * Create new empty HashMap.
@@ -37,22 +344,59 @@ static size_t indexForTableEntryArray(int hashCode, size_t capacity) {
  * @return new HashMap
  */
 HashMap* createHashMap(void) {
+	return createHashMapWithCapacity(0);
+}
+
+/**
+ * Create new empty HashMap whose table can hold the specified
+ * number of entries without being resized.
+ *
+ * @param nEntries the expected number of entries
+ * @return new HashMap
+ */
+HashMap* createHashMapWithCapacity(size_t nEntries) {
 	// create and initialize the map
 	HashMap* map = (HashMap*)malloc(sizeof(HashMap));
 	map->size = 0;
 	map->loadFactor = DEFAULT_LOADING_FACTOR;
-	map->capacity = DEFAULT_CAPACITY;
+	map->seed = createMapEntryKeyHashSeed();
+	map->capacity = capacityForEntries(map, nEntries);
+	map->oldHashTable = (HashTableEntry*)NULL;
+	map->oldCapacity = 0;
+	map->rehashIndex = 0;
+	map->entries = map->smallEntries;
+	map->entryCount = 0;
+	map->entryCapacity = SMALL_MAP_ENTRIES;
+	map->keyArena = (MapKeyArena*)NULL;
+	map->bloomFilter = (BloomFilter*)NULL;
+	map->sortedKeys = (SortedKeyView*)NULL;
+	resetHashMapStats(map);
+	if (nEntries > SMALL_MAP_ENTRIES) {
+		resizeEntryArray(map, nEntries);
+	}
 
 	// create and initial hash table list for the map
-	map->hashTable =
-		(HashTableEntry*)malloc(map->capacity * sizeof (HashTableEntry));
-	for (int i = 0; i < map->capacity; i++) {
-		map->hashTable[i].hashChain = (HashChainEntry*)NULL;
-	}
+	map->hashTable = allocTableEntryArray(map, map->capacity);
 
 	return map;
 }
 
+/**
+ * Create new empty HashMap that owns its keys. A put that adds an
+ * entry copies the key into an arena of the map, so callers need not
+ * keep keys alive. The copies are freed all at once by clearHashMap(),
+ * shrinkHashMap() and deleteHashMap(); until then copies of deleted
+ * keys remain in the arena.
+ *
+ * @param nEntries the expected number of entries, or 0
+ * @return new HashMap
+ */
+HashMap* createHashMapWithOwnedKeys(size_t nEntries) {
+	HashMap* map = createHashMapWithCapacity(nEntries);
+	map->keyArena = createMapKeyArena();
+	return map;
+}
+
 /**
  * Frees a HashMap.
  *
@@ -60,8 +404,16 @@ HashMap* createHashMap(void) {
  */
 void deleteHashMap(HashMap* map) {
 	clearHashMap(map);
-	free(map->hashTable);
+	freeTableEntryArray(map, map->hashTable);
 	map->hashTable = (HashTableEntry*)NULL;
+	if (map->keyArena != (MapKeyArena*)NULL) {
+		deleteMapKeyArena(map->keyArena);
+		map->keyArena = (MapKeyArena*)NULL;
+	}
+	disableHashMapBloomFilter(map);
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		deleteSortedKeyView(map->sortedKeys);
+	}
 	free(map);
 }
 
@@ -71,22 +423,36 @@ void deleteHashMap(HashMap* map) {
  * @param map the HashMap
  */
 void clearHashMap(HashMap* map) {
+	// abandon any rehash in progress
+	freeTableEntryArray(map, map->oldHashTable);
+	map->oldHashTable = (HashTableEntry*)NULL;
+	map->oldCapacity = 0;
+	map->rehashIndex = 0;
+
 	// clear the table entries
 	if (map->hashTable != (HashTableEntry*)NULL) {  // call assert?
 		for (int i = 0; i < map->capacity; i++) {
-			// free the list entry chain
-			HashChainEntry* listEntry = map->hashTable[i].hashChain;
-			while (listEntry != (HashChainEntry*)NULL) {
-				HashChainEntry* nextListEntry = listEntry->nextEntry;
-				listEntry->entry = (MapEntry){(char*)NULL, (MapValue*)NULL};
-				listEntry->nextEntry = (HashChainEntry*)NULL;
-				free(listEntry);
-				listEntry = nextListEntry;
-			}
-			map->hashTable[i].hashChain = (HashChainEntry*)NULL;
+			map->hashTable[i].hashChain = NO_ENTRY;
 		}
 	}
+
+	// free the entry array, and use the one kept in the map
+	if (map->entries != map->smallEntries) {
+		free(map->entries);
+		map->entries = map->smallEntries;
+	}
+	map->entryCount = 0;
+	map->entryCapacity = SMALL_MAP_ENTRIES;
 	map->size = 0;
+
+	// free the key copies
+	if (map->keyArena != (MapKeyArena*)NULL) {
+		clearMapKeyArena(map->keyArena);
+	}
+	rebuildHashMapBloomFilter(map);
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		clearSortedKeyView(map->sortedKeys);
+	}
 }
 
 /**
@@ -106,15 +472,12 @@ bool containsHashMapKey(HashMap* map, MapKey key) {
  * @param value the entry value to check
  */
 bool containsHashMapValue(HashMap* map, MapValue* value) {
-	HashMapIterator* itr = createHashMapIterator(map);
-	while (hasNextHashMapEntry(itr)) {
-		MapEntry* mapEntry = getNextHashMapEntry(itr);
-		if (compareMapValue(mapEntry->value, value) == 0) {
-			deleteHashMapIterator(itr);
+	for (size_t i = 0; i < map->entryCount; i++) {
+		if (   !isDeletedEntry(map, i)
+			&& compareMapValue(map->entries[i].entry.value, value) == 0) {
 			return true;
 		}
 	}
-	deleteHashMapIterator(itr);
 	return false;
 }
 
@@ -127,19 +490,42 @@ bool containsHashMapValue(HashMap* map, MapValue* value) {
  */
 MapEntry** getHashMapEntries(HashMap* map) {
 	// allocate MapEntrySet array
-	MapEntry** mapEntrySet = (MapEntry**)malloc(map->size*sizeof(MapEntry*) + 1);
+	MapEntry** mapEntrySet = (MapEntry**)malloc((map->size+1)*sizeof(MapEntry*));
 	int i = 0;
-	HashMapIterator* itr = createHashMapIterator(map);
-	while (hasNextHashMapEntry(itr)) {
-		MapEntry* mapEntry = getNextHashMapEntry(itr);
+	HashMapIterator itr;
+	initHashMapIterator(&itr, map);
+	while (hasNextHashMapEntry(&itr)) {
+		MapEntry* mapEntry = getNextHashMapEntry(&itr);
 		mapEntrySet[i++] = mapEntry;
 	}
 	mapEntrySet[i] = (MapEntry*)NULL; // NULL terminated array
 
-	deleteHashMapIterator(itr);
+	finishHashMapIterator(&itr);
 	return mapEntrySet;
 }
 
+/**
+ * Calls the callback for each entry in the map until the callback
+ * returns false. The callback may change the value of the entry,
+ * but must not add or delete entries.
+ *
+ * @param map the HashMap
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all entries were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachHashMapEntry(HashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData) {
+	for (size_t i = 0; i < map->entryCount; i++) {
+		if (   !isDeletedEntry(map, i)
+			&& !callback(&map->entries[i].entry, callbackData)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 /**
  * Returns the entry to which the specified key is mapped, or null if
  * this map contains no mapping for the key.
@@ -149,17 +535,15 @@ MapEntry** getHashMapEntries(HashMap* map) {
  * @return the MapEntry for the given key
  */
 MapEntry* getHashMapEntry(HashMap* map, MapKey key) {
-	int hashCode = getMapEntryKeyHashCode(key);
-	size_t entryIndex = indexForTableEntryArray(hashCode, map->capacity);
-
-	HashChainEntry* chainEntry = map->hashTable[entryIndex].hashChain;
-	for ( ; chainEntry != (HashChainEntry*)NULL; chainEntry= chainEntry->nextEntry) {
-		if (hashCode == chainEntry->hashCode &&
-			compareMapKey(key, chainEntry->entry.key) == 0) { // what if different? assert?
-			return &chainEntry->entry;
-		}
+	rehashStep(map);
+
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	if (isBloomFilterMiss(map, hashCode)) {
+		return (MapEntry*)NULL;
 	}
-	return (MapEntry*)NULL;
+	HashEntryIndex index =
+		*findChainLink(map, tableEntryForHashCode(map, hashCode), key, hashCode);
+	return (index == NO_ENTRY) ? (MapEntry*)NULL : &map->entries[index].entry;
 }
 
 /**
@@ -175,6 +559,84 @@ MapValue* getHashMapValue(HashMap* map, MapKey key) {
 	return (entry == (MapEntry*)NULL) ? (MapValue*)NULL : entry->value;
 }
 
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key. Unlike getHashMapValue(),
+ * this does not move entries of a map that is being rehashed, so it
+ * does not modify the map and can be called by several threads at
+ * once while no thread is modifying the map. Its search is not counted
+ * in the statistics kept with HASH_MAP_STATS.
+ *
+ * @param map the HashMap
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* peekHashMapValue(HashMap* map, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	if (isBloomFilterMiss(map, hashCode)) {
+		return (MapValue*)NULL;
+	}
+	// the search is not counted, since the statistics counters may not
+	// be updated by several threads at once
+	size_t nProbes;
+	HashEntryIndex index =
+		*searchChain(map, tableEntryForHashCode(map, hashCode), key, hashCode, &nProbes);
+	return (index == NO_ENTRY) ? (MapValue*)NULL : map->entries[index].entry.value;
+}
+
+/**
+ * Gets the values for an array of keys. The keys are looked up together
+ * so that the memory accesses for different keys overlap, which is
+ * faster than calling getHashMapValue() for each key in large maps.
+ *
+ * @param map the HashMap
+ * @param keys the keys for the values to get
+ * @param nKeys the number of keys
+ * @param values set to the value for each key, or NULL if no mapping
+ * @return the number of keys that have a mapping
+ */
+size_t getHashMapValuesBatch(
+	HashMap* map, const MapKey keys[], size_t nKeys, MapValue* values[]) {
+	rehashStep(map);
+
+	uint64_t hashCodes[BATCH_GROUP_SIZE];
+	HashTableEntry* tableEntries[BATCH_GROUP_SIZE];
+	size_t nFound = 0;
+
+	for (size_t group = 0; group < nKeys; group += BATCH_GROUP_SIZE) {
+		size_t groupSize = (nKeys - group < BATCH_GROUP_SIZE)
+			? nKeys - group : BATCH_GROUP_SIZE;
+
+		// hash the keys and prefetch their table entries
+		for (size_t i = 0; i < groupSize; i++) {
+			hashCodes[i] = getMapEntryKeyHashCode(keys[group+i], map->seed);
+			tableEntries[i] = tableEntryForHashCode(map, hashCodes[i]);
+			__builtin_prefetch(tableEntries[i]);
+		}
+
+		// prefetch the chain heads
+		for (size_t i = 0; i < groupSize; i++) {
+			HashEntryIndex chainHead = tableEntries[i]->hashChain;
+			if (chainHead != NO_ENTRY) {
+				__builtin_prefetch(&map->entries[chainHead]);
+			}
+		}
+
+		// compare the keys
+		for (size_t i = 0; i < groupSize; i++) {
+			HashEntryIndex index =
+				*findChainLink(map, tableEntries[i], keys[group+i], hashCodes[i]);
+			if (index == NO_ENTRY) {
+				values[group+i] = (MapValue*)NULL;
+			} else {
+				values[group+i] = map->entries[index].entry.value;
+				nFound++;
+			}
+		}
+	}
+	return nFound;
+}
+
 /**
  * Returns an null-terminated array of pointers to MapValue entries contained
  * in this map. Caller is responsible for freeing allocated array.
@@ -184,16 +646,17 @@ MapValue* getHashMapValue(HashMap* map, MapKey key) {
  */
 MapValue** getHashMapValues(HashMap* map) {
 	// allocate MapEntrySet array
-	MapValue** valueSet = (MapValue**)malloc(map->size*sizeof(MapValue*) + 1);
+	MapValue** valueSet = (MapValue**)malloc((map->size+1)*sizeof(MapValue*));
 	int i = 0;
-	HashMapIterator* itr = createHashMapIterator(map);
-	while (hasNextHashMapEntry(itr)) {
-		MapEntry* mapEntry = getNextHashMapEntry(itr);
+	HashMapIterator itr;
+	initHashMapIterator(&itr, map);
+	while (hasNextHashMapEntry(&itr)) {
+		MapEntry* mapEntry = getNextHashMapEntry(&itr);
 		valueSet[i++] = mapEntry->value;
 	}
 	valueSet[i] = (MapValue*)NULL; // NULL terminated array
 
-	deleteHashMapIterator(itr);
+	finishHashMapIterator(&itr);
 	return valueSet;
 }
 
@@ -216,103 +679,163 @@ bool isHashMapEmpty(HashMap* map) {
  */
 MapKey** getHashMapKeys(HashMap* map) {
 	// allocate MapEntrySet array
-	MapKey** keySet = (MapKey**)malloc(map->size*sizeof(MapKey*) + 1);
+	MapKey** keySet = (MapKey**)malloc((map->size+1)*sizeof(MapKey*));
 	int i = 0;
-	HashMapIterator* itr = createHashMapIterator(map);
-	while (hasNextHashMapEntry(itr)) {
-		MapEntry* mapEntry = getNextHashMapEntry(itr);
+	HashMapIterator itr;
+	initHashMapIterator(&itr, map);
+	while (hasNextHashMapEntry(&itr)) {
+		MapEntry* mapEntry = getNextHashMapEntry(&itr);
 		keySet[i++] = &mapEntry->key;
 	}
 	keySet[i] = (MapKey*)NULL; // NULL terminated array
 
-	deleteHashMapIterator(itr);
+	finishHashMapIterator(&itr);
 	return keySet;
 }
 
 /**
- * Transfers all entries from current table to newTable.
+ * Returns the keys of this map in increasing order. The first call
+ * sorts the keys into a view that the map keeps from then on: a key
+ * pointer per key, and a change record for each later put or delete.
+ * Later calls merge in the changes with O(k log n) comparisons for k
+ * changes, but also scan and move every key, so each refresh is O(n)
+ * rather than the O(n log n) of sorting a copy of getHashMapKeys().
  *
- * @param oldTable the old table entry array
- * @param oldCapacity the capacity of the old table entry array
- * @param newTable the new table entry array
- * @param newCapacity the capacity of the new table entry array
+ * @param map the HashMap
+ * @return the getHashMapSize() keys of the map in strcmp() order,
+ *   valid until the map is changed
  */
-void transferTableEntryArray(HashTableEntry* oldTable, int oldCapacity,
-		           HashTableEntry* newTable, int newCapacity) {
-	// transfer entries for each table entry
-	for (int index = 0; index < oldCapacity; index++) {
-		// transfer entries for list entries at current index
-		HashChainEntry* listEntry = oldTable[index].hashChain;
-		oldTable[index].hashChain = (HashChainEntry*)NULL;  // disconnect chain
-		while (listEntry != (HashChainEntry*)NULL) {
-			HashChainEntry* nextEntry = listEntry->nextEntry;
-
-			// splice in at head of the new table entry chain
-			int newIndex = indexForTableEntryArray(listEntry->hashCode, newCapacity);
-			listEntry->nextEntry = newTable[newIndex].hashChain;
-			newTable[newIndex].hashChain = listEntry;
-
-			listEntry = nextEntry;
+MapKey* getSortedHashMapKeys(HashMap* map) {
+	if (map->sortedKeys == (SortedKeyView*)NULL) {
+		map->sortedKeys = createSortedKeyView();
+	}
+	SortedKeyView* view = map->sortedKeys;
+	if (view->isStale) {
+		MapKey* keys = prepareSortedKeyView(view, map->size);
+		size_t count = 0;
+		for (size_t i = 0; i < map->entryCount; i++) {
+			if (!isDeletedEntry(map, i)) {
+				keys[count++] = map->entries[i].entry.key;
+			}
 		}
+		sortSortedKeyView(view);
+	} else {
+		updateSortedKeyView(view);
 	}
+	return view->keys;
+}
+
+/**
+ * Returns the position in getSortedHashMapKeys() of the first key of
+ * this map that is not less than the specified key.
+ *
+ * @param map the HashMap
+ * @param key the key
+ * @return the index of the key, or the size of the map if all keys
+ *   are less than the key
+ */
+size_t findHashMapLowerBound(HashMap* map, MapKey key) {
+	getSortedHashMapKeys(map);
+	return findSortedKeyViewLowerBound(map->sortedKeys, key);
 }
 
 /**
- * Replace old table entry array in map with resized table entry array
- * with contents transferred to the new table entry array. This method
- * is used with the table is at its threshold.
+ * Replace old table entry array in map with resized table entry array.
+ * This method is used when the table is at its threshold. Entries are
+ * linked into the new table entry array incrementally by later
+ * operations on the map, or by completeHashMapRehash().
  *
  * @param map the map
- * @param newCapacity the new capacity, must be a power of two that is
- *  greater than current capacity.
+ * @param newCapacity the new capacity, must be a power of two that
+ *  can hold the entries of the map.
  */
 void resizeTableEntryArray(HashMap* map, int newCapacity) {
-	HashTableEntry* oldTable = map->hashTable;
-	int oldCapacity = map->capacity;
+	// finish any previous resize before starting another
+	completeHashMapRehash(map);
 
-	HashTableEntry* newTable = (HashTableEntry*)malloc(newCapacity*sizeof(HashTableEntry));
-	for (int i = 0; i < newCapacity; i++) {  // initialize new table
-		newTable[i].hashChain = (HashChainEntry*)NULL;
-	}
-	transferTableEntryArray(oldTable, oldCapacity, newTable, newCapacity);
-	map->hashTable = newTable;
+	HASH_MAP_START_TIMER(start);
+	HASH_MAP_COUNT_RESIZE(map);
+	map->oldHashTable = map->hashTable;
+	map->oldCapacity = map->capacity;
+	map->rehashIndex = 0;
+	map->hashTable = allocTableEntryArray(map, newCapacity);
 	map->capacity = newCapacity;
-	free(oldTable);
+	rebuildHashMapBloomFilter(map);
+	HASH_MAP_STOP_TIMER(map, start);
 }
 
 /**
- * Adds a new entry with the key, value and hash code to the map,
- * and resizes the map entry table array if necessary.
+ * Adds a new entry with the key, value and hash code to the end of the
+ * entry array, and resizes the map entry table array if necessary.
  *
  * @param map the map
  * @param hashCode the hash key of the key
  * @param key the key to add
  * @param value the value to add
- * @param the entry index in the table entry array
- *
+ * @return the new chain entry
  */
-static void addEntryToTableEntryArray(
-	HashMap* map, int hashCode, MapKey key, MapValue* value, int entryIndex) {
+static HashChainEntry* addEntryToTableEntryArray(HashMap* map, uint64_t hashCode,
+	MapKey key, MapValue* value) {
 
-	// splice in new list entry at head of chain
-	HashChainEntry* newChainEntry = (HashChainEntry*)malloc(sizeof(HashChainEntry));
+	// make room first: removing deleted entries relinks the table
+	reserveEntryArray(map, 1);
+	HashTableEntry* tableEntry = tableEntryForHashCode(map, hashCode);
 
 	// set fields of new list entry
+	HashEntryIndex index = map->entryCount++;
+	HashChainEntry* newChainEntry = &map->entries[index];
 	newChainEntry->hashCode = hashCode;
-	newChainEntry->entry.key = key;
+	newChainEntry->entry.key = (map->keyArena == (MapKeyArena*)NULL)
+		? key : copyMapKeyToArena(map->keyArena, key, strlen(key));
 	newChainEntry->entry.value = value;
 
 	// splice entry to head of list
-	newChainEntry->nextEntry = map->hashTable[entryIndex].hashChain;
-	map->hashTable[entryIndex].hashChain = newChainEntry;
+	newChainEntry->nextEntry = tableEntry->hashChain;
+	tableEntry->hashChain = index;
+	if (map->bloomFilter != (BloomFilter*)NULL) {
+		addBloomFilterHashCode(map->bloomFilter, hashCode);
+	}
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		addSortedKeyViewChange(map->sortedKeys, newChainEntry->entry.key, true);
+	}
 
-	// resize table if at threshold (map capacity * loadFactor)
-	if (++map->size > map->capacity*map->loadFactor) {
-		resizeTableEntryArray(map, 2* map->capacity);
+	// resize table if at threshold (map capacity * loadFactor);
+	// deferred until a resize that is in progress has finished
+	if (   ++map->size > maxEntriesForCapacity(map, map->capacity)
+		&& map->oldHashTable == (HashTableEntry*)NULL) {
+		resizeTableEntryArray(map, capacityForEntries(map, map->size));
 	}
- }
+	return newChainEntry;
+}
+
+/**
+ * Removes the chain entry that a chain link points to from the map.
+ * The entry is marked deleted in the entry array, and dropped from
+ * the array if it is the last one.
+ *
+ * @param map the map
+ * @param link the link to the chain entry
+ * @return the value of the removed entry
+ */
+static MapValue* removeChainEntry(HashMap* map, HashEntryIndex* link) {
+	// splice out node from list
+	HashChainEntry* chainEntry = &map->entries[*link];
+	*link = chainEntry->nextEntry;
 
+	// mark the entry deleted
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		addSortedKeyViewChange(map->sortedKeys, chainEntry->entry.key, false);
+	}
+	MapValue* value = chainEntry->entry.value;
+	chainEntry->entry = (MapEntry){(MapKey)NULL, (MapValue*)NULL};
+	chainEntry->nextEntry = NO_ENTRY;
+	while (map->entryCount > 0 && isDeletedEntry(map, map->entryCount-1)) {
+		map->entryCount--;
+	}
 
+	map->size--;
+	return value;
+}
 
 /**
  * Associates the specified value with the specified key in this map
@@ -323,27 +846,135 @@ static void addEntryToTableEntryArray(
  * @return the previous value for the key, or NULL for a new entry
  */
 MapValue* putHashMapEntry(HashMap* map, MapKey key, MapValue* value) {
-	int hashCode = getMapEntryKeyHashCode(key);
-	int entryIndex = indexForTableEntryArray(hashCode, map->capacity);
+	rehashStep(map);
+
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	HashTableEntry* tableEntry = tableEntryForHashCode(map, hashCode);
 
 	// look for existing entry in entry chain
-	HashChainEntry* listEntry = map->hashTable[entryIndex].hashChain;
-	for ( ; listEntry != (HashChainEntry*)NULL; listEntry = listEntry->nextEntry) {
-		if (   listEntry->hashCode == hashCode
-			&& compareMapKey(key, listEntry->entry.key) == 0) {
-			MapValue* oldValue = listEntry->entry.value;
-			listEntry->entry.value = value;
-			return oldValue;
-		}
+	HashEntryIndex index = isBloomFilterMiss(map, hashCode)
+		? NO_ENTRY : *findChainLink(map, tableEntry, key, hashCode);
+	if (index != NO_ENTRY) {
+		MapValue* oldValue = map->entries[index].entry.value;
+		map->entries[index].entry.value = value;
+		return oldValue;
 	}
 	// add entry to map and resize if necessary
-	addEntryToTableEntryArray(map, hashCode, key, value,entryIndex);
+	addEntryToTableEntryArray(map, hashCode, key, value);
 
 	return (MapValue*)NULL;
 }
 
 /**
- * Copies all of the mappings from the specified map to this map
+ * Associates the specified value with the specified key in this map
+ * if the key is not already in the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value to put
+ * @param value the HashMapValue for the key
+ * @return the current value for the key, or NULL for a new entry
+ */
+MapValue* putIfAbsentHashMapEntry(HashMap* map, MapKey key, MapValue* value) {
+	bool isNew;
+	MapEntry* entry = getOrPutHashMapEntry(map, key, &isNew);
+	if (isNew) {
+		entry->value = value;
+		return (MapValue*)NULL;
+	}
+	return entry->value;
+}
+
+/**
+ * Returns the value for the key if it is in the map. Otherwise calls
+ * the callback to compute a value, and adds an entry for the key
+ * unless the callback returns NULL. The callback must not modify
+ * the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value
+ * @param callback called with the key and a NULL value
+ * @param callbackData the callback data
+ * @return the current or computed value for the key
+ */
+MapValue* computeIfAbsentHashMapEntry(HashMap* map, MapKey key,
+	HashMapComputeCallback callback, HashMapComputeData callbackData) {
+	rehashStep(map);
+
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	HashEntryIndex index = isBloomFilterMiss(map, hashCode) ? NO_ENTRY
+		: *findChainLink(map, tableEntryForHashCode(map, hashCode), key, hashCode);
+	if (index != NO_ENTRY) {
+		return map->entries[index].entry.value;
+	}
+
+	MapValue* value = callback(key, (MapValue*)NULL, callbackData);
+	if (value != (MapValue*)NULL) {
+		addEntryToTableEntryArray(map, hashCode, key, value);
+	}
+	return value;
+}
+
+/**
+ * Calls the callback to compute a new value for the key if it is in
+ * the map. The entry is updated with the new value, or removed if the
+ * callback returns NULL. The callback must not modify the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value
+ * @param callback called with the key and its current value
+ * @param callbackData the callback data
+ * @return the new value for the key, or NULL if none
+ */
+MapValue* computeIfPresentHashMapEntry(HashMap* map, MapKey key,
+	HashMapComputeCallback callback, HashMapComputeData callbackData) {
+	rehashStep(map);
+
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	if (isBloomFilterMiss(map, hashCode)) {
+		return (MapValue*)NULL;
+	}
+	HashEntryIndex* link =
+		findChainLink(map, tableEntryForHashCode(map, hashCode), key, hashCode);
+	if (*link == NO_ENTRY) {
+		return (MapValue*)NULL;
+	}
+
+	MapValue* value = callback(key, map->entries[*link].entry.value, callbackData);
+	if (value == (MapValue*)NULL) {
+		removeChainEntry(map, link);
+	} else {
+		map->entries[*link].entry.value = value;
+	}
+	return value;
+}
+
+/**
+ * Returns the entry for the key, adding an entry with a NULL value if
+ * the key is not in the map. The caller can update the value through
+ * the entry without looking up the key again.
+ *
+ * @param map the HashMap
+ * @param key the key for the entry
+ * @param isNew set to true if the entry was added, false otherwise
+ * @return the entry for the key
+ */
+MapEntry* getOrPutHashMapEntry(HashMap* map, MapKey key, bool* isNew) {
+	rehashStep(map);
+
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	HashEntryIndex index = isBloomFilterMiss(map, hashCode) ? NO_ENTRY
+		: *findChainLink(map, tableEntryForHashCode(map, hashCode), key, hashCode);
+	*isNew = (index == NO_ENTRY);
+	if (*isNew) {
+		return &addEntryToTableEntryArray(
+			map, hashCode, key, (MapValue*)NULL)->entry;
+	}
+	return &map->entries[index].entry;
+}
+
+/**
+ * Copies all of the mappings from the specified map to this map.
+ * The map is resized once for all the entries of the other map.
  *
  * @param map the HashMap
  * @param aMap another map whose entries will be added to the map
@@ -351,15 +982,89 @@ MapValue* putHashMapEntry(HashMap* map, MapKey key, MapValue* value) {
  * @todo What happens with values for entries whose keys are duplicates.
  */
 bool putAllHashMapEntries(HashMap* map, HashMap* aMap) {
-	HashMapIterator* itr = createHashMapIterator(aMap);
+	reserveHashMap(map, map->size + aMap->size);
+	HashMapIterator itr;
+	initHashMapIterator(&itr, aMap);
 	bool result = false;
-	while (hasNextHashMapEntry(itr)) {
-		MapEntry* entry = getNextHashMapEntry(itr);
+	while (hasNextHashMapEntry(&itr)) {
+		MapEntry* entry = getNextHashMapEntry(&itr);
 		result |= (putHashMapEntry(map, entry->key, entry->value) == NULL);
 	}
+	finishHashMapIterator(&itr);
 	return result;
 }
 
+/**
+ * Associates each of an array of keys with the corresponding value.
+ * The map is resized at most once before the entries are added.
+ *
+ * @param map the HashMap
+ * @param keys the keys to put
+ * @param values the value for each key
+ * @param nEntries the number of keys and values
+ * @return the number of new entries added to the map
+ */
+size_t loadHashMapEntries(HashMap* map,
+	const MapKey keys[], MapValue* const values[], size_t nEntries) {
+	size_t oldSize = map->size;
+	reserveHashMap(map, map->size + nEntries);
+	for (size_t i = 0; i < nEntries; i++) {
+		putHashMapEntry(map, keys[i], values[i]);
+	}
+	return map->size - oldSize;
+}
+
+/**
+ * Resizes the table and entry array if necessary so that the map can
+ * hold the specified number of entries without being resized again.
+ * Entries are linked into the larger table incrementally, as when the
+ * map grows by itself.
+ *
+ * @param map the HashMap
+ * @param nEntries the number of entries to make room for
+ */
+void reserveHashMap(HashMap* map, size_t nEntries) {
+	if (nEntries > map->size) {
+		reserveEntryArray(map, nEntries - map->size);
+	}
+	size_t newCapacity = capacityForEntries(map, nEntries);
+	if (newCapacity > map->capacity) {
+		resizeTableEntryArray(map, newCapacity);
+		if (map->size == 0) {
+			completeHashMapRehash(map);  // no entries to move
+		}
+	}
+}
+
+/**
+ * Releases memory that the map no longer needs after entries have been
+ * deleted. Deleted entries are removed from the entry array, the array
+ * is reduced to the number of entries, and the table is replaced by the
+ * smallest table that holds them. Unlike other operations this takes
+ * time proportional to the size of the map, and it must not be called
+ * while the map is being iterated.
+ *
+ * @param map the HashMap
+ */
+void shrinkHashMap(HashMap* map) {
+	compactEntryArray(map, capacityForEntries(map, map->size));
+	if (map->keyArena != (MapKeyArena*)NULL) {
+		// copy the remaining keys into a new arena to drop deleted ones
+		MapKeyArena* keyArena = createMapKeyArena();
+		for (size_t i = 0; i < map->entryCount; i++) {
+			MapKey key = map->entries[i].entry.key;
+			map->entries[i].entry.key =
+				copyMapKeyToArena(keyArena, key, getArenaMapKeyLength(key));
+		}
+		deleteMapKeyArena(map->keyArena);
+		map->keyArena = keyArena;
+		if (map->sortedKeys != (SortedKeyView*)NULL) {
+			invalidateSortedKeyView(map->sortedKeys);
+		}
+	}
+	resizeEntryArray(map, map->size);
+}
+
 /**
  * Removes the mapping for a key from this map if it is present
  *
@@ -368,35 +1073,119 @@ bool putAllHashMapEntries(HashMap* map, HashMap* aMap) {
  * @return the value of the entry that was removed
  */
 MapValue* deleteHashMapEntryForKey(HashMap* map, MapKey key) {
-	int hashCode = getMapEntryKeyHashCode(key);
-	int entryIndex = indexForTableEntryArray(hashCode, map->capacity);
-
-	HashChainEntry* listEntry = map->hashTable[entryIndex].hashChain;
-	HashChainEntry* prevListEntry = (HashChainEntry*)NULL;
-
-	while (listEntry != (HashChainEntry*)NULL) {
-		if (hashCode == listEntry->hashCode &&
-			compareMapKey(key, listEntry->entry.key) == 0) {
-			// splice out node from list
-			HashChainEntry* nextListEntry = listEntry->nextEntry;
-			if (prevListEntry == (HashChainEntry*)NULL) {
-				map->hashTable[entryIndex].hashChain = nextListEntry;
-			} else {
-				prevListEntry->nextEntry = nextListEntry;
+	rehashStep(map);
+
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	if (isBloomFilterMiss(map, hashCode)) {
+		return (MapValue*)NULL;
+	}
+	HashEntryIndex* link =
+		findChainLink(map, tableEntryForHashCode(map, hashCode), key, hashCode);
+	if (*link == NO_ENTRY) {
+		return (MapValue*)NULL;
+	}
+	return removeChainEntry(map, link);
+}
+
+/**
+ * Removes each entry of this map for which the callback returns true.
+ * The callback must not add or delete entries itself. Entries are
+ * visited in the entry array and unlinked from their chains by index,
+ * so no key is hashed or compared.
+ *
+ * @param map the HashMap
+ * @param callback returns true for an entry to remove
+ * @param callbackData the callback data
+ * @return the number of entries removed
+ */
+size_t deleteHashMapEntriesIf(HashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData) {
+	size_t nDeleted = 0;
+	for (size_t i = 0; i < map->entryCount; i++) {
+		HashChainEntry* chainEntry = &map->entries[i];
+		if (   !isDeletedEntry(map, i)
+			&& callback(&chainEntry->entry, callbackData)) {
+			HashEntryIndex* link =
+				&tableEntryForHashCode(map, chainEntry->hashCode)->hashChain;
+			while (*link != i) {
+				link = &map->entries[*link].nextEntry;
 			}
+			removeChainEntry(map, link);
+			nDeleted++;
+		}
+	}
+	return nDeleted;
+}
+
+/**
+ * Keeps a Bloom filter of the keys of this map, so that most lookups
+ * and puts of keys that are not in the map skip searching the table.
+ * The filter is sized for the capacity of the table and rebuilt when
+ * the table is resized. Deleted keys stay in the filter until it is
+ * rebuilt, so call rebuildHashMapBloomFilter() after many deletes.
+ * Batched lookups do not use the filter.
+ *
+ * @param map the HashMap
+ */
+void enableHashMapBloomFilter(HashMap* map) {
+	if (map->bloomFilter == (BloomFilter*)NULL) {
+		map->bloomFilter = createBloomFilter(maxEntriesForCapacity(map, map->capacity));
+		rebuildHashMapBloomFilter(map);
+	}
+}
 
-			// free the node
-			MapValue* value = listEntry->entry.value;
-			listEntry->nextEntry = (HashChainEntry*)NULL;
-			free(listEntry);
+/**
+ * Stops keeping a Bloom filter of the keys of this map, and frees it.
+ *
+ * @param map the HashMap
+ */
+void disableHashMapBloomFilter(HashMap* map) {
+	if (map->bloomFilter != (BloomFilter*)NULL) {
+		deleteBloomFilter(map->bloomFilter);
+		map->bloomFilter = (BloomFilter*)NULL;
+	}
+}
 
-			map->size--;
-			return value;
+/**
+ * Rebuilds the Bloom filter of this map from its current keys, which
+ * removes deleted keys from the filter. Does nothing if the map does
+ * not keep a filter. The hash codes are read from the entry array, so
+ * this does not rehash any keys.
+ *
+ * @param map the HashMap
+ */
+void rebuildHashMapBloomFilter(HashMap* map) {
+	if (map->bloomFilter == (BloomFilter*)NULL) {
+		return;
+	}
+	resetBloomFilter(map->bloomFilter, maxEntriesForCapacity(map, map->capacity));
+	for (size_t i = 0; i < map->entryCount; i++) {
+		if (!isDeletedEntry(map, i)) {
+			addBloomFilterHashCode(map->bloomFilter, map->entries[i].hashCode);
 		}
-		prevListEntry = listEntry;
-		listEntry = listEntry->nextEntry;
 	}
-	return (MapValue*)NULL;
+}
+
+/**
+ * Finishes moving entries to a resized table now rather than
+ * incrementally during later operations. Use when a pause is acceptable.
+ *
+ * @param map the HashMap
+ */
+void completeHashMapRehash(HashMap* map) {
+	if (map->oldHashTable != (HashTableEntry*)NULL) {
+		transferTableEntries(map, map->oldCapacity);
+	}
+}
+
+/**
+ * Returns true if entries are still being moved to a resized table.
+ *
+ * @param map the HashMap
+ * @return true if the map is being rehashed, false otherwise
+ */
+bool isHashMapRehashing(HashMap* map) {
+	return map->oldHashTable != (HashTableEntry*)NULL;
 }
 
 /**
@@ -408,3 +1197,80 @@ MapValue* deleteHashMapEntryForKey(HashMap* map, MapKey key) {
 int getHashMapSize(HashMap* map) {
 	return map->size;
 }
+
+/**
+ * Counts the length of each chain of a table in the statistics.
+ *
+ * @param map the map
+ * @param table the table
+ * @param first the index of the first chain to count
+ * @param capacity the capacity of the table
+ * @param stats the statistics
+ */
+static void countChainLengths(HashMap* map, HashTableEntry* table,
+	size_t first, size_t capacity, HashMapStats* stats) {
+	for (size_t i = first; i < capacity; i++) {
+		size_t length = 0;
+		for (HashEntryIndex index = table[i].hashChain; index != NO_ENTRY;
+			 index = map->entries[index].nextEntry) {
+			length++;
+		}
+		stats->chainLengths[(length < HASH_MAP_STATS_CHAIN_LENGTHS)
+							? length : HASH_MAP_STATS_CHAIN_LENGTHS-1]++;
+		if (length > stats->maxChainLength) {
+			stats->maxChainLength = length;
+		}
+	}
+}
+
+/**
+ * Gets statistics of this map. The chain lengths and sizes are found
+ * by scanning the table, in time proportional to its capacity. The
+ * search, probe and resize counts are only kept if the map was built
+ * with HASH_MAP_STATS defined, and are 0 otherwise. While the map is
+ * being rehashed, the chains of the old table that have not yet been
+ * moved are counted as well.
+ *
+ * @param map the HashMap
+ * @param stats set to the statistics of the map
+ */
+void getHashMapStats(HashMap* map, HashMapStats* stats) {
+	memset(stats, 0, sizeof(HashMapStats));
+	stats->size = map->size;
+	stats->capacity = map->capacity;
+	countChainLengths(map, map->hashTable, 0, map->capacity, stats);
+	if (map->oldHashTable != (HashTableEntry*)NULL) {
+		countChainLengths(map, map->oldHashTable, map->rehashIndex, map->oldCapacity, stats);
+	}
+	stats->tableBytes = (map->capacity + map->oldCapacity) * sizeof(HashTableEntry);
+	stats->entryBytes = map->entryCapacity * sizeof(HashChainEntry);
+	if (map->bloomFilter != (BloomFilter*)NULL) {
+		stats->filterBytes =
+			map->bloomFilter->nBlocks * BLOOM_FILTER_BLOCK_WORDS * sizeof(uint64_t);
+	}
+#ifdef HASH_MAP_STATS
+	stats->hitCount = map->counters.hitCount;
+	stats->missCount = map->counters.missCount;
+	if (map->counters.hitCount > 0) {
+		stats->probesPerHit = (double)map->counters.hitProbes / map->counters.hitCount;
+	}
+	if (map->counters.missCount > 0) {
+		stats->probesPerMiss = (double)map->counters.missProbes / map->counters.missCount;
+	}
+	stats->resizeCount = map->counters.resizeCount;
+	stats->resizeMillis = map->counters.resizeNanos / 1e6;
+#endif
+}
+
+/**
+ * Resets the search, probe and resize counts of this map to 0.
+ *
+ * @param map the HashMap
+ */
+void resetHashMapStats(HashMap* map) {
+#ifdef HASH_MAP_STATS
+	memset(&map->counters, 0, sizeof(HashMapCounters));
+#endif
+}
+
+#endif /* HASH_MAP_OPEN_ADDRESSING */
@@ -4,6 +4,19 @@
  * This file provides the structures and function declarations of a HashMap,
  * which is a Map that is backed by a HashTable.
  *
+ * Two implementations are available. By default the entries are kept
+ * in an array in the order they were added, and the table is an array
+ * of hash chains that link the entries by index. Defining
+ * HASH_MAP_OPEN_ADDRESSING at build time selects an open-addressed
+ * table whose slots are probed in groups of 16 using a control byte per
+ * slot (see hash_map_open.c).
+ *
+ * Defining HASH_MAP_STATS at build time makes each map count its
+ * searches, probes and resizes for getHashMapStats(). All files must
+ * be built with the same setting, since it changes the HashMap type.
+ * The counters are not atomic, so peekHashMapValue() does not count its
+ * search and stays safe for several threads at once.
+ *
  * @since 2017-03-22
  * @author philip gust
  *
@@ -12,33 +25,135 @@
 #ifndef HASH_MAP_H_
 #define HASH_MAP_H_
 #include "map_entry.h"
+#include "map_key_arena.h"
+#include "bloom_filter.h"
+#include "hash_map_stats.h"
+#include "sorted_key_view.h"
+
+#ifdef HASH_MAP_OPEN_ADDRESSING
 
 /**
- * Entry in the hash chain for a hash table entry
+ * A slot in the open-addressed hash table. Whether the slot is in use
+ * is recorded in the control byte array of the HashMap, not the slot.
  */
-typedef struct _HashChainEntry {
+typedef struct {
 	MapEntry entry;						// entry key/value pair
-	int hashCode;						// hash code for the entry key
-	struct _HashChainEntry* nextEntry;  // pointer to next entry in chain
+	uint64_t hashCode;					// hash code for the entry key
+} HashSlot;
+
+/**
+ * The hash table. Slots are probed a group of 16 control bytes at a
+ * time; a control byte holds 7 bits of the slot's hash code, or marks
+ * the slot as empty or deleted. MapEntry pointers into the table are
+ * only valid until the next put or delete.
+ */
+typedef struct {
+	signed char* control;				// control byte for each slot
+	HashSlot* slots;					// the hash table slots
+	size_t capacity;						// the current size of the hash table
+	size_t size;							// number of entries in table
+	size_t growthLeft;					// entries left before table is rehashed
+	float loadFactor;					// % full before resizing table
+	uint64_t seed;						// hash seed for keys of this map
+	MapKeyArena* keyArena;				// copies of the keys, or NULL if not owned
+	BloomFilter* bloomFilter;			// filter of key hash codes, or NULL
+	SortedKeyView* sortedKeys;			// keys in order, or NULL
+#ifdef HASH_MAP_STATS
+	HashMapCounters counters;			// counts for getHashMapStats()
+#endif
+} HashMap;
+
+#else /* chained hash table */
+
+#ifndef SMALL_MAP_ENTRIES
+#define SMALL_MAP_ENTRIES 4		// entries of a map that are kept inline
+#endif
+
+/**
+ * Index of an entry in the entry array of a HashMap
+ */
+typedef uint32_t HashEntryIndex;
+
+/**
+ * Entry in the entry array. Entries for the same hash table entry
+ * are linked into a hash chain by their entry array indexes.
+ */
+typedef struct {
+	MapEntry entry;						// entry key/value pair, NULL key if deleted
+	uint64_t hashCode;					// hash code for the entry key
+	HashEntryIndex nextEntry;			// index of next entry in chain
 } HashChainEntry;
 
 /**
  * An entry in the hash table array.
  */
 typedef struct {
-  HashChainEntry* hashChain;			// list of hash chain entries
+  HashEntryIndex hashChain;				// index of first entry in chain
 } HashTableEntry;
 
 /**
- * The hash table
+ * The hash table. Entries are added to the end of the entry array, so
+ * they are iterated in the order they were added. Deleted entries are
+ * left in the array until it is full, and then are removed by moving
+ * the entries that follow them down. MapEntry pointers into the entry
+ * array are only valid until the next put or delete.
+ *
+ * When the table grows, entries are linked into the new table a few
+ * old table entries at a time by each put, get and delete, so no single
+ * operation rehashes the whole table.
+ *
+ * A map of up to SMALL_MAP_ENTRIES entries needs no allocations besides
+ * the map itself: its table is a single chain, and its entry array,
+ * both kept in the map. They are replaced by allocated arrays when the
+ * map grows past that size. The inline arrays stay in every map, so
+ * SMALL_MAP_ENTRIES is kept small: with 4 entries they add 128 bytes.
  */
 typedef struct {
 	HashTableEntry* hashTable;			// the hash table
 	size_t capacity;						// the current size of the hash table
 	size_t size;							// number of entries in table
 	float loadFactor;					// % full before resizing table
+	HashTableEntry smallTable[1];		// the table of a small map
+	uint64_t seed;						// hash seed for keys of this map
+	HashTableEntry* oldHashTable;		// table being rehashed, or NULL
+	size_t oldCapacity;					// size of old table, or 0
+	size_t rehashIndex;					// next old table entry to rehash
+	HashChainEntry* entries;			// entries in the order added
+	size_t entryCount;					// entries used, including deleted
+	size_t entryCapacity;				// size of the entry array
+	MapKeyArena* keyArena;				// copies of the keys, or NULL if not owned
+	BloomFilter* bloomFilter;			// filter of key hash codes, or NULL
+	SortedKeyView* sortedKeys;			// keys in order, or NULL
+#ifdef HASH_MAP_STATS
+	HashMapCounters counters;			// counts for getHashMapStats()
+#endif
+	HashChainEntry smallEntries[SMALL_MAP_ENTRIES];	// entry array of a small map
 } HashMap;
 
+#endif /* HASH_MAP_OPEN_ADDRESSING */
+
+/**
+ * Definition covers void* compute callback data
+ */
+typedef void* HashMapComputeData;
+
+/**
+ * Definition of callback that computes a value for a key from its
+ * current value, or from NULL if the key has no value.
+ */
+typedef MapValue* (*HashMapComputeCallback)
+	(MapKey, MapValue*, HashMapComputeData);
+
+/**
+ * Definition covers void* for-each callback data
+ */
+typedef void* HashMapForEachData;
+
+/**
+ * Definition of for-each callback. Returns true to continue
+ * with the next entry, false to stop.
+ */
+typedef bool (*HashMapForEachCallback)(MapEntry*, HashMapForEachData);
 
 /**
  * Create new empty HashMap.
@@ -47,6 +162,27 @@ typedef struct {
  */
 HashMap* createHashMap(void);
 
+/**
+ * Create new empty HashMap whose table can hold the specified
+ * number of entries without being resized.
+ *
+ * @param nEntries the expected number of entries
+ * @return new HashMap
+ */
+HashMap* createHashMapWithCapacity(size_t nEntries);
+
+/**
+ * Create new empty HashMap that owns its keys. A put that adds an
+ * entry copies the key into an arena of the map, so callers need not
+ * keep keys alive. The copies are freed all at once by clearHashMap(),
+ * shrinkHashMap() and deleteHashMap(); until then copies of deleted
+ * keys remain in the arena.
+ *
+ * @param nEntries the expected number of entries, or 0
+ * @return new HashMap
+ */
+HashMap* createHashMapWithOwnedKeys(size_t nEntries);
+
 /**
  * Frees a HashMap.
  *
@@ -81,12 +217,28 @@ bool containsHashMapValue(HashMap* map, MapValue* value);
 /**
  * Returns an null-terminated array of pointers to MapEntry mappings
  * contained in this map. Caller is responsible for freeing allocated array.
+ * Use forEachHashMapEntry() or a HashMapIterator to visit the entries
+ * without allocating an array.
  *
  * @param map the map
  * @return null-terminated array of pointers to MapEntry mappings for the map
  */
 MapEntry** getHashMapEntries(HashMap* map);
 
+/**
+ * Calls the callback for each entry in the map until the callback
+ * returns false. The callback may change the value of the entry,
+ * but must not add or delete entries.
+ *
+ * @param map the HashMap
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all entries were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachHashMapEntry(HashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData);
+
 /**
  * Returns the entry to which the specified key is mapped, or null if
  * this map contains no mapping for the key.
@@ -107,6 +259,34 @@ MapEntry* getHashMapEntry(HashMap* map, MapKey key);
  */
 MapValue* getHashMapValue(HashMap* map, MapKey key);
 
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key. Unlike getHashMapValue(),
+ * this does not move entries of a map that is being rehashed, so it
+ * does not modify the map and can be called by several threads at
+ * once while no thread is modifying the map. Its search is not counted
+ * in the statistics kept with HASH_MAP_STATS.
+ *
+ * @param map the HashMap
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* peekHashMapValue(HashMap* map, MapKey key);
+
+/**
+ * Gets the values for an array of keys. The keys are looked up together
+ * so that the memory accesses for different keys overlap, which is
+ * faster than calling getHashMapValue() for each key in large maps.
+ *
+ * @param map the HashMap
+ * @param keys the keys for the values to get
+ * @param nKeys the number of keys
+ * @param values set to the value for each key, or NULL if no mapping
+ * @return the number of keys that have a mapping
+ */
+size_t getHashMapValuesBatch(
+	HashMap* map, const MapKey keys[], size_t nKeys, MapValue* values[]);
+
 /**
  * Returns an null-terminated array of pointers to MapValue entries contained
  * in this map. Caller is responsible for freeing allocated array.
@@ -133,6 +313,31 @@ bool isHashMapEmpty(HashMap* map);
  */
 MapKey** getHashMapKeys(HashMap* map);
 
+/**
+ * Returns the keys of this map in increasing order. The first call
+ * sorts the keys into a view that the map keeps from then on: a key
+ * pointer per key, and a change record for each later put or delete.
+ * Later calls merge in the changes with O(k log n) comparisons for k
+ * changes, but also scan and move every key, so each refresh is O(n)
+ * rather than the O(n log n) of sorting a copy of getHashMapKeys().
+ *
+ * @param map the HashMap
+ * @return the getHashMapSize() keys of the map in strcmp() order,
+ *   valid until the map is changed
+ */
+MapKey* getSortedHashMapKeys(HashMap* map);
+
+/**
+ * Returns the position in getSortedHashMapKeys() of the first key of
+ * this map that is not less than the specified key.
+ *
+ * @param map the HashMap
+ * @param key the key
+ * @return the index of the key, or the size of the map if all keys
+ *   are less than the key
+ */
+size_t findHashMapLowerBound(HashMap* map, MapKey key);
+
 /**
  * Associates the specified value with the specified key in this map
  *
@@ -144,7 +349,61 @@ MapKey** getHashMapKeys(HashMap* map);
 MapValue* putHashMapEntry(HashMap* map, MapKey key, MapValue* value);
 
 /**
- * Copies all of the mappings from the specified map to this map
+ * Associates the specified value with the specified key in this map
+ * if the key is not already in the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value to put
+ * @param value the HashMapValue for the key
+ * @return the current value for the key, or NULL for a new entry
+ */
+MapValue* putIfAbsentHashMapEntry(HashMap* map, MapKey key, MapValue* value);
+
+/**
+ * Returns the value for the key if it is in the map. Otherwise calls
+ * the callback to compute a value, and adds an entry for the key
+ * unless the callback returns NULL. The callback must not modify
+ * the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value
+ * @param callback called with the key and a NULL value
+ * @param callbackData the callback data
+ * @return the current or computed value for the key
+ */
+MapValue* computeIfAbsentHashMapEntry(HashMap* map, MapKey key,
+	HashMapComputeCallback callback, HashMapComputeData callbackData);
+
+/**
+ * Calls the callback to compute a new value for the key if it is in
+ * the map. The entry is updated with the new value, or removed if the
+ * callback returns NULL. The callback must not modify the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value
+ * @param callback called with the key and its current value
+ * @param callbackData the callback data
+ * @return the new value for the key, or NULL if none
+ */
+MapValue* computeIfPresentHashMapEntry(HashMap* map, MapKey key,
+	HashMapComputeCallback callback, HashMapComputeData callbackData);
+
+/**
+ * Returns the entry for the key, adding an entry with a NULL value if
+ * the key is not in the map. The caller can update the value through
+ * the entry without looking up the key again. The entry is valid
+ * until the next put or delete on the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the entry
+ * @param isNew set to true if the entry was added, false otherwise
+ * @return the entry for the key
+ */
+MapEntry* getOrPutHashMapEntry(HashMap* map, MapKey key, bool* isNew);
+
+/**
+ * Copies all of the mappings from the specified map to this map.
+ * The map is resized once for all the entries of the other map.
  *
  * @param map the HashMap
  * @param aMap another map whose entries will be added to the map
@@ -152,6 +411,38 @@ MapValue* putHashMapEntry(HashMap* map, MapKey key, MapValue* value);
  */
 bool putAllHashMapEntries(HashMap* map, HashMap* aMap);
 
+/**
+ * Associates each of an array of keys with the corresponding value.
+ * The map is resized at most once before the entries are added.
+ *
+ * @param map the HashMap
+ * @param keys the keys to put
+ * @param values the value for each key
+ * @param nEntries the number of keys and values
+ * @return the number of new entries added to the map
+ */
+size_t loadHashMapEntries(HashMap* map,
+	const MapKey keys[], MapValue* const values[], size_t nEntries);
+
+/**
+ * Resizes the table if necessary so that the map can hold the specified
+ * number of entries without being resized again.
+ *
+ * @param map the HashMap
+ * @param nEntries the number of entries to make room for
+ */
+void reserveHashMap(HashMap* map, size_t nEntries);
+
+/**
+ * Releases memory that the map no longer needs after entries have been
+ * deleted, by replacing the table with the smallest one that holds the
+ * current entries. Takes time proportional to the size of the map, and
+ * must not be called while the map is being iterated.
+ *
+ * @param map the HashMap
+ */
+void shrinkHashMap(HashMap* map);
+
 /**
  * Removes the mapping for a key from this map if it is present
  *
@@ -161,6 +452,64 @@ bool putAllHashMapEntries(HashMap* map, HashMap* aMap);
  */
 MapValue* deleteHashMapEntryForKey(HashMap* map, MapKey key);
 
+/**
+ * Removes each entry of this map for which the callback returns true.
+ * The callback must not add or delete entries itself.
+ *
+ * @param map the HashMap
+ * @param callback returns true for an entry to remove
+ * @param callbackData the callback data
+ * @return the number of entries removed
+ */
+size_t deleteHashMapEntriesIf(HashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData);
+
+/**
+ * Keeps a Bloom filter of the keys of this map, so that most lookups
+ * and puts of keys that are not in the map skip searching the table.
+ * The filter is sized for the capacity of the table and rebuilt when
+ * the table is resized. Deleted keys stay in the filter until it is
+ * rebuilt, so call rebuildHashMapBloomFilter() after many deletes.
+ * Batched lookups do not use the filter. The open-addressed table
+ * already rejects most misses by reading one group of control bytes,
+ * so the filter mainly speeds up the chained table.
+ *
+ * @param map the HashMap
+ */
+void enableHashMapBloomFilter(HashMap* map);
+
+/**
+ * Stops keeping a Bloom filter of the keys of this map, and frees it.
+ *
+ * @param map the HashMap
+ */
+void disableHashMapBloomFilter(HashMap* map);
+
+/**
+ * Rebuilds the Bloom filter of this map from its current keys, which
+ * removes deleted keys from the filter. Does nothing if the map does
+ * not keep a filter.
+ *
+ * @param map the HashMap
+ */
+void rebuildHashMapBloomFilter(HashMap* map);
+
+/**
+ * Finishes moving entries to a resized table now rather than
+ * incrementally during later operations. Use when a pause is acceptable.
+ *
+ * @param map the HashMap
+ */
+void completeHashMapRehash(HashMap* map);
+
+/**
+ * Returns true if entries are still being moved to a resized table.
+ *
+ * @param map the HashMap
+ * @return true if the map is being rehashed, false otherwise
+ */
+bool isHashMapRehashing(HashMap* map);
+
 /**
  * Returns the number of key-value mappings in this map.
  *
@@ -169,4 +518,22 @@ MapValue* deleteHashMapEntryForKey(HashMap* map, MapKey key);
  */
 int getHashMapSize(HashMap* map);
 
+/**
+ * Gets statistics of this map. The chain lengths and sizes are found
+ * by scanning the table, in time proportional to its capacity. The
+ * search, probe and resize counts are only kept if the map was built
+ * with HASH_MAP_STATS defined, and are 0 otherwise.
+ *
+ * @param map the HashMap
+ * @param stats set to the statistics of the map
+ */
+void getHashMapStats(HashMap* map, HashMapStats* stats);
+
+/**
+ * Resets the search, probe and resize counts of this map to 0.
+ *
+ * @param map the HashMap
+ */
+void resetHashMapStats(HashMap* map);
+
 #endif /* HASH_MAP_H_ */
@@ -0,0 +1,816 @@
+/*
+ * hash_map_bench_main.c
+ *
+ * This file provides a benchmark of HashMap and the maps and sets
+ * built on it. It times:
+ *
+ * - puts, gets and deletes, and puts into a map created with enough
+ *   capacity for all the keys
+ * - batched lookups with getHashMapValuesBatch(), compared with a loop
+ *   of getHashMapEntry() calls
+ * - iterating over a map
+ * - puts and hits in a map that owns its keys
+ * - many maps of a few entries each
+ * - integer ID keys in a UInt64HashMap, compared with the same IDs
+ *   formatted as string keys
+ * - rebuilding a map, compared with opening a saved snapshot
+ * - lookups in a map, compared with lookups in a FrozenHashMap of it
+ * - an LRUCache that is smaller than its working set
+ * - lookups that mostly miss, with and without a Bloom filter
+ * - a DiskHashMap with page caches of several sizes relative to its file
+ * - the memory and speed of a HashSet, compared with a HashMap of the
+ *   same keys
+ * - building a HashSet on several threads from keys with duplicates
+ * - counting distinct keys with a HyperLogLog instead of a HashSet
+ * - keeping the keys of a map sorted after a few changes
+ *
+ * It is excluded from the project build; build it once for each
+ * HashMap implementation and compare the results:
+ *
+ *   SRCS="src/bloom_filter.c src/disk_hash_map.c src/frozen_hash_map.c \
+ *         src/hash_map.c src/hash_map_iterator.c src/hash_map_open.c \
+ *         src/hash_map_open_iterator.c src/hash_map_snapshot.c \
+ *         src/hash_set.c src/hash_set_iterator.c src/hyper_log_log.c \
+ *         src/int_hash_map.c src/lru_cache.c src/map_entry.c \
+ *         src/map_key_arena.c src/sorted_key_view.c"
+ *   gcc -O2 -pthread -o bench_chained src/hash_map_bench_main.c $SRCS -lm
+ *   gcc -O2 -pthread -DHASH_MAP_OPEN_ADDRESSING -o bench_open \
+ *       src/hash_map_bench_main.c $SRCS -lm
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "hash_map.h"
+#include "hash_map_iterator.h"
+#include "int_hash_map.h"
+#include "hash_map_snapshot.h"
+#include "frozen_hash_map.h"
+#include "lru_cache.h"
+#include "disk_hash_map.h"
+#include "hash_set.h"
+#include "hyper_log_log.h"
+
+/**
+ * Returns the current time in nanoseconds.
+ *
+ * @return the current monotonic time in nanoseconds
+ */
+static double nanoTime(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Make an array of distinct keys "key0", "key1", ...
+ *
+ * @param prefix the key prefix
+ * @param nKeys the number of keys
+ * @return the array of keys
+ */
+static char** makeKeys(const char* prefix, int nKeys) {
+	char** keys = (char**)malloc(nKeys * sizeof(char*));
+	for (int i = 0; i < nKeys; i++) {
+		keys[i] = (char*)malloc(32);
+		snprintf(keys[i], 32, "%s%d", prefix, i);
+	}
+	return keys;
+}
+
+/**
+ * Free an array of keys.
+ *
+ * @param keys the array of keys
+ * @param nKeys the number of keys
+ */
+static void deleteKeys(char** keys, int nKeys) {
+	for (int i = 0; i < nKeys; i++) {
+		free(keys[i]);
+	}
+	free(keys);
+}
+
+/** Number of keys looked up per getHashMapValuesBatch() call */
+#define BATCH_SIZE 1024
+
+/**
+ * Time put, hit, miss and delete operations for a map of nKeys entries.
+ *
+ * @param nKeys the number of keys
+ */
+static void benchHashMap(int nKeys) {
+	static MapValue value = { "value" };
+	char** keys = makeKeys("key", nKeys);
+	char** missingKeys = makeKeys("missing", nKeys);
+	MapKey* lookupKeys = (MapKey*)malloc(nKeys * sizeof(MapKey));
+	MapValue** values = (MapValue**)malloc(BATCH_SIZE * sizeof(MapValue*));
+	HashMap* map = createHashMap();
+	long found = 0;
+	long batchFound = 0;
+
+	double start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(map, keys[i], &value);
+	}
+	double putTime = nanoTime() - start;
+
+	HashMap* sizedMap = createHashMapWithCapacity(nKeys);
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(sizedMap, keys[i], &value);
+	}
+	double sizedPutTime = nanoTime() - start;
+	deleteHashMap(sizedMap);
+
+	HashMap* ownedMap = createHashMapWithOwnedKeys(0);
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(ownedMap, keys[i], &value);
+	}
+	double ownedPutTime = nanoTime() - start;
+
+	for (int i = 0; i < nKeys; i++) {
+		lookupKeys[i] = keys[(i * 7919L) % nKeys];  // scattered order
+	}
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getHashMapEntry(map, lookupKeys[i]) != NULL);
+	}
+	double hitTime = nanoTime() - start;
+
+	long ownedFound = 0;
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		ownedFound += (getHashMapEntry(ownedMap, lookupKeys[i]) != NULL);
+	}
+	double ownedHitTime = nanoTime() - start;
+	deleteHashMap(ownedMap);
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i += BATCH_SIZE) {
+		size_t nBatch = (nKeys - i < BATCH_SIZE) ? nKeys - i : BATCH_SIZE;
+		batchFound += getHashMapValuesBatch(map, &lookupKeys[i], nBatch, values);
+	}
+	double batchTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getHashMapEntry(map, missingKeys[i]) != NULL);
+	}
+	double missTime = nanoTime() - start;
+
+	start = nanoTime();
+	HashMapIterator itr;
+	initHashMapIterator(&itr, map);
+	while (hasNextHashMapEntry(&itr)) {
+		found -= (getNextHashMapEntry(&itr) == NULL);
+	}
+	finishHashMapIterator(&itr);
+	double iterateTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		deleteHashMapEntryForKey(map, keys[i]);
+	}
+	double deleteTime = nanoTime() - start;
+
+	printf("%10d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %s\n",
+		   nKeys, putTime/nKeys, sizedPutTime/nKeys, hitTime/nKeys, batchTime/nKeys,
+		   missTime/nKeys, iterateTime/nKeys, deleteTime/nKeys,
+		   ownedPutTime/nKeys, ownedHitTime/nKeys,
+		   (found == nKeys && batchFound == nKeys && ownedFound == nKeys)
+		   ? "" : "(lookup error)");
+
+	deleteHashMap(map);
+	free(lookupKeys);
+	free(values);
+	deleteKeys(keys, nKeys);
+	deleteKeys(missingKeys, nKeys);
+}
+
+/**
+ * Time puts and hits of nKeys integer IDs in a UInt64HashMap, and of
+ * the same IDs formatted as strings in a HashMap.
+ *
+ * @param nKeys the number of keys
+ */
+static void benchIntHashMap(int nKeys) {
+	static MapValue value = { "value" };
+	uint64_t* ids = (uint64_t*)malloc(nKeys * sizeof(uint64_t));
+	char** keys = (char**)malloc(nKeys * sizeof(char*));
+	for (int i = 0; i < nKeys; i++) {
+		ids[i] = i * 0x9E3779B97F4A7C15ULL;  // scattered 64-bit IDs
+		keys[i] = (char*)malloc(32);
+	}
+	long found = 0;
+
+	HashMap* map = createHashMap();
+	double start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		snprintf(keys[i], 32, "%llu", (unsigned long long)ids[i]);
+		putHashMapEntry(map, keys[i], &value);
+	}
+	double putTime = nanoTime() - start;
+
+	// the ID must be formatted for each lookup too
+	char key[32];
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		snprintf(key, sizeof key, "%llu", (unsigned long long)ids[(i * 7919L) % nKeys]);
+		found += (getHashMapValue(map, key) != NULL);
+	}
+	double hitTime = nanoTime() - start;
+	deleteHashMap(map);
+
+	UInt64HashMap* intMap = createUInt64HashMap();
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		putUInt64HashMapEntry(intMap, ids[i], &value);
+	}
+	double intPutTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getUInt64HashMapValue(intMap, ids[(i * 7919L) % nKeys]) != NULL);
+	}
+	double intHitTime = nanoTime() - start;
+	deleteUInt64HashMap(intMap);
+
+	printf("%10d %10.1f %10.1f %10.1f %10.1f %s\n", nKeys,
+		   putTime/nKeys, hitTime/nKeys, intPutTime/nKeys, intHitTime/nKeys,
+		   (found == 2L*nKeys) ? "" : "(lookup error)");
+
+	for (int i = 0; i < nKeys; i++) {
+		free(keys[i]);
+	}
+	free(keys);
+	free(ids);
+}
+
+/** Number of maps created by benchSmallHashMaps */
+#define N_SMALL_MAPS 100000
+
+/**
+ * Time creating, filling, searching and freeing many maps that
+ * each have a few entries.
+ *
+ * @param nKeys the number of keys in each map
+ */
+static void benchSmallHashMaps(int nKeys) {
+	static MapValue value = { "value" };
+	char** keys = makeKeys("key", nKeys);
+	HashMap** maps = (HashMap**)malloc(N_SMALL_MAPS * sizeof(HashMap*));
+	long found = 0;
+
+	double start = nanoTime();
+	for (int m = 0; m < N_SMALL_MAPS; m++) {
+		maps[m] = createHashMap();
+		for (int i = 0; i < nKeys; i++) {
+			putHashMapEntry(maps[m], keys[i], &value);
+		}
+	}
+	double createTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int m = 0; m < N_SMALL_MAPS; m++) {
+		for (int i = 0; i < nKeys; i++) {
+			found += (getHashMapValue(maps[m], keys[i]) != NULL);
+		}
+	}
+	double hitTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int m = 0; m < N_SMALL_MAPS; m++) {
+		deleteHashMap(maps[m]);
+	}
+	double deleteTime = nanoTime() - start;
+
+	printf("%10d %10.1f %10.1f %10.1f %s\n", nKeys,
+		   createTime/N_SMALL_MAPS, hitTime/N_SMALL_MAPS/nKeys,
+		   deleteTime/N_SMALL_MAPS,
+		   (found == (long)N_SMALL_MAPS*nKeys) ? "" : "(lookup error)");
+
+	free(maps);
+	deleteKeys(keys, nKeys);
+}
+
+/**
+ * Time rebuilding a map by putting its entries, compared with saving
+ * it as a snapshot and opening the snapshot, and time hits in each.
+ *
+ * @param nKeys the number of keys in the map
+ */
+static void benchHashMapSnapshot(int nKeys) {
+	static MapValue value = { "value" };
+	static const char* path = "/tmp/hash_map_bench.snapshot";
+	char** keys = makeKeys("key", nKeys);
+	long found = 0;
+
+	double start = nanoTime();
+	HashMap* map = createHashMap();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(map, keys[i], &value);
+	}
+	double buildTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getHashMapValue(map, keys[i]) != NULL);
+	}
+	double hitTime = nanoTime() - start;
+
+	start = nanoTime();
+	bool saved = saveHashMapSnapshot(map, path);
+	double saveTime = nanoTime() - start;
+	deleteHashMap(map);
+
+	start = nanoTime();
+	HashMapSnapshot* snapshot = saved ? openHashMapSnapshot(path) : NULL;
+	double openTime = nanoTime() - start;
+
+	double snapshotHitTime = 0;
+	if (snapshot != NULL) {
+		MapValue snapshotValue;
+		start = nanoTime();
+		for (int i = 0; i < nKeys; i++) {
+			found += (getHashMapSnapshotValue(snapshot, keys[i], &snapshotValue) != NULL);
+		}
+		snapshotHitTime = nanoTime() - start;
+		closeHashMapSnapshot(snapshot);
+	}
+	remove(path);
+
+	printf("%10d %10.2f %10.2f %10.3f %10.1f %10.1f %s\n", nKeys,
+		   buildTime/1e6, saveTime/1e6, openTime/1e6,
+		   hitTime/nKeys, snapshotHitTime/nKeys,
+		   (found == 2L*nKeys) ? "" : "(lookup error)");
+
+	deleteKeys(keys, nKeys);
+}
+
+/**
+ * Time freezing a map, and compare hits and misses in the map with
+ * hits and misses in the FrozenHashMap.
+ *
+ * @param nKeys the number of keys in the map
+ */
+static void benchFrozenHashMap(int nKeys) {
+	static MapValue value = { "value" };
+	char** keys = makeKeys("key", nKeys);
+	char** missingKeys = makeKeys("missing", nKeys);
+	long found = 0;
+
+	HashMap* map = createHashMap();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(map, keys[i], &value);
+	}
+	double start = nanoTime();
+	FrozenHashMap* frozenMap = freezeHashMap(map);
+	double freezeTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getHashMapValue(map, keys[i]) != NULL);
+	}
+	double hitTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getHashMapValue(map, missingKeys[i]) != NULL);
+	}
+	double missTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getFrozenHashMapValue(frozenMap, keys[i]) != NULL);
+	}
+	double frozenHitTime = nanoTime() - start;
+
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += (getFrozenHashMapValue(frozenMap, missingKeys[i]) != NULL);
+	}
+	double frozenMissTime = nanoTime() - start;
+
+	printf("%10d %10.1f %10.1f %10.1f %10.1f %10.1f %s\n", nKeys,
+		   freezeTime/nKeys, hitTime/nKeys, frozenHitTime/nKeys,
+		   missTime/nKeys, frozenMissTime/nKeys,
+		   (found == 2L*nKeys) ? "" : "(lookup error)");
+
+	deleteFrozenHashMap(frozenMap);
+	deleteHashMap(map);
+	deleteKeys(missingKeys, nKeys);
+	deleteKeys(keys, nKeys);
+}
+
+/** Number of lookups made by benchLRUCache */
+#define N_LRU_OPS 10000000
+
+/**
+ * Time an LRUCache that holds half of the keys that are looked up.
+ * Each lookup that misses puts its key, evicting the least recently
+ * used entry.
+ *
+ * @param nKeys the number of entries in the cache
+ */
+static void benchLRUCache(int nKeys) {
+	static MapValue value = { "value" };
+	char** keys = makeKeys("key", 2*nKeys);
+	LRUCache* cache = createLRUCache(nKeys, 0, NULL, NULL);
+	uint64_t state = 1;
+
+	double start = nanoTime();
+	for (int i = 0; i < N_LRU_OPS; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		char* key = keys[state % (2*nKeys)];
+		if (getLRUCacheValue(cache, key) == NULL) {
+			putLRUCacheEntry(cache, key, &value);
+		}
+	}
+	double time = nanoTime() - start;
+
+	printf("%10d %10.1f %10.1f%% %10zu\n", nKeys, time/N_LRU_OPS,
+		   100.0*getLRUCacheHitCount(cache)/N_LRU_OPS, getLRUCacheEvictionCount(cache));
+
+	deleteLRUCache(cache);
+	deleteKeys(keys, 2*nKeys);
+}
+
+/**
+ * Time a stream of lookups of which 90% miss, in a map without and
+ * with a Bloom filter of its keys.
+ *
+ * @param nKeys the number of keys in the map
+ */
+static void benchHashMapBloomFilter(int nKeys) {
+	static MapValue value = { "value" };
+	char** keys = makeKeys("key", nKeys);
+	char** missingKeys = makeKeys("missing", nKeys);
+	HashMap* map = createHashMap();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(map, keys[i], &value);
+	}
+
+	double times[2];
+	long found = 0;
+	for (int pass = 0; pass < 2; pass++) {
+		if (pass == 1) {
+			enableHashMapBloomFilter(map);
+		}
+		double start = nanoTime();
+		for (int i = 0; i < nKeys; i++) {
+			MapKey key = (i % 10 == 0) ? keys[i] : missingKeys[i];
+			found += containsHashMapKey(map, key);
+		}
+		times[pass] = nanoTime() - start;
+	}
+
+	printf("%10d %10.1f %10.1f %s\n", nKeys, times[0]/nKeys, times[1]/nKeys,
+		   (found == 2L*((nKeys+9)/10)) ? "" : "(lookup error)");
+
+	deleteHashMap(map);
+	deleteKeys(missingKeys, nKeys);
+	deleteKeys(keys, nKeys);
+}
+
+/**
+ * Time puts, random gets and a scan of a DiskHashMap whose page cache
+ * holds the specified fraction of the pages that the entries need.
+ *
+ * @param nKeys the number of keys in the map
+ * @param cacheShare the cached pages are 1/cacheShare of the pages
+ */
+static void benchDiskHashMap(int nKeys, int cacheShare) {
+	static MapValue value = { "value" };
+	static const char* path = "/tmp/hash_map_bench.pages";
+	char** keys = makeKeys("key", nKeys);
+	// about 48 page bytes per entry, at 75% load
+	size_t nPages = (size_t)nKeys * 48 / (DISK_HASH_MAP_PAGE_SIZE * 3/4) + 1;
+	DiskHashMap* map = createDiskHashMap(path, nPages / cacheShare);
+
+	double start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		putDiskHashMapEntry(map, keys[i], &value);
+	}
+	double putTime = nanoTime() - start;
+
+	uint64_t state = 1;
+	long found = 0;
+	size_t pageReads = map->pageReads;
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		found += containsDiskHashMapKey(map, keys[state % nKeys]);
+	}
+	double getTime = nanoTime() - start;
+	double readsPerGet = (double)(map->pageReads - pageReads) / nKeys;
+
+	DiskHashMapIterator itr;
+	initDiskHashMapIterator(&itr, map);
+	start = nanoTime();
+	while (getNextDiskHashMapEntry(&itr) != NULL) {
+		found++;
+	}
+	double scanTime = nanoTime() - start;
+
+	printf("%10d %10d %10.1f %10.1f %10.2f %10.1f %10u %s\n", nKeys, cacheShare,
+		   putTime/nKeys, getTime/nKeys, readsPerGet, scanTime/nKeys, map->nPages,
+		   (found == 2L*nKeys && !hasDiskHashMapFailed(map)) ? "" : "(lookup error)");
+
+	deleteDiskHashMap(map);
+	deleteKeys(keys, nKeys);
+}
+
+/**
+ * Compare the bytes per key and the add and contains times of a HashSet
+ * with those of a HashMap that maps the same keys to NULL.
+ *
+ * @param nKeys the number of keys
+ */
+static void benchHashSet(int nKeys) {
+	char** keys = makeKeys("key", nKeys);
+
+	double start = nanoTime();
+	HashMap* map = createHashMap();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(map, keys[i], NULL);
+	}
+	double mapPutTime = nanoTime() - start;
+	long found = 0;
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += containsHashMapKey(map, keys[i]);
+	}
+	double mapHitTime = nanoTime() - start;
+	HashMapStats stats;
+	getHashMapStats(map, &stats);
+	size_t mapBytes = stats.tableBytes + stats.entryBytes;
+
+	start = nanoTime();
+	HashSet* set = createHashSet();
+	for (int i = 0; i < nKeys; i++) {
+		addHashSetKey(set, keys[i]);
+	}
+	double setAddTime = nanoTime() - start;
+	start = nanoTime();
+	for (int i = 0; i < nKeys; i++) {
+		found += containsHashSetKey(set, keys[i]);
+	}
+	double setHitTime = nanoTime() - start;
+	size_t setBytes = set->capacity * sizeof(HashSetIndex)
+					+ set->entryCapacity * sizeof(HashSetEntry);
+
+	printf("%10d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %s\n", nKeys,
+		   (double)mapBytes/nKeys, (double)setBytes/nKeys,
+		   mapPutTime/nKeys, setAddTime/nKeys, mapHitTime/nKeys, setHitTime/nKeys,
+		   (found == 2L*nKeys) ? "" : "(lookup error)");
+
+	deleteHashSet(set);
+	deleteHashMap(map);
+	deleteKeys(keys, nKeys);
+}
+
+/** Most threads to build a HashSet with */
+#define MAX_BUILD_THREADS 32
+
+/**
+ * Time building a HashSet from an array of keys in which each key
+ * appears twice, by adding the keys one at a time and with
+ * createHashSetFromKeys() on 1 to MAX_BUILD_THREADS threads.
+ *
+ * @param nKeys the number of distinct keys
+ */
+static void benchHashSetFromKeys(int nKeys) {
+	char** keys = makeKeys("key", nKeys);
+	MapKey* allKeys = (MapKey*)malloc(2 * nKeys * sizeof(MapKey));
+	for (int i = 0; i < nKeys; i++) {
+		allKeys[i] = keys[i];
+		allKeys[nKeys + i] = keys[(i * 7919L) % nKeys];
+	}
+
+	double start = nanoTime();
+	HashSet* set = createHashSet();
+	for (int i = 0; i < 2 * nKeys; i++) {
+		addHashSetKey(set, allKeys[i]);
+	}
+	printf("%10d %10.1f", nKeys, (nanoTime() - start) / (2 * nKeys));
+	bool isCorrect = (getHashSetSize(set) == nKeys);
+	deleteHashSet(set);
+
+	for (int nThreads = 1; nThreads <= MAX_BUILD_THREADS; nThreads *= 2) {
+		start = nanoTime();
+		set = createHashSetFromKeys(allKeys, 2 * nKeys, nThreads);
+		printf(" %10.1f", (nanoTime() - start) / (2 * nKeys));
+		isCorrect = isCorrect && (getHashSetSize(set) == nKeys);
+		deleteHashSet(set);
+	}
+	printf(" %s\n", isCorrect ? "" : "(size error)");
+
+	free(allKeys);
+	deleteKeys(keys, nKeys);
+}
+
+/**
+ * Compare counting the distinct keys of a stream in which each key
+ * appears twice with a HashSet and with a HyperLogLog of the default
+ * precision: time per key, bytes, and error of the count.
+ *
+ * @param nKeys the number of distinct keys
+ */
+static void benchHyperLogLog(int nKeys) {
+	char** keys = makeKeys("key", nKeys);
+
+	double start = nanoTime();
+	HashSet* set = createHashSet();
+	for (int i = 0; i < 2 * nKeys; i++) {
+		addHashSetKey(set, keys[i % nKeys]);
+	}
+	double setTime = nanoTime() - start;
+	size_t setBytes = set->capacity * sizeof(HashSetIndex)
+					+ set->entryCapacity * sizeof(HashSetEntry);
+	double setError = (double)getHashSetSize(set) / nKeys - 1;
+	deleteHashSet(set);
+
+	start = nanoTime();
+	HyperLogLog* hll = createHyperLogLog(HYPER_LOG_LOG_DEFAULT_PRECISION);
+	for (int i = 0; i < 2 * nKeys; i++) {
+		addHyperLogLogKey(hll, keys[i % nKeys]);
+	}
+	double estimate = getHyperLogLogEstimate(hll);
+	double hllTime = nanoTime() - start;
+	size_t hllBytes = hll->nRegisters;
+	deleteHyperLogLog(hll);
+
+	printf("%10d %10.1f %10.1f %10zu %10zu %9.2f%% %9.2f%%\n", nKeys,
+		   setTime/(2 * nKeys), hllTime/(2 * nKeys), setBytes, hllBytes,
+		   100 * setError, 100 * (estimate / nKeys - 1));
+	deleteKeys(keys, nKeys);
+}
+
+/**
+ * Compares two key pointers for qsort().
+ *
+ * @param key1 the first pointer to a key
+ * @param key2 the second pointer to a key
+ * @return <0, 0 or >0 as the first key is less than, equal to or
+ *   greater than the second
+ */
+static int compareKeyPointers(const void* key1, const void* key2) {
+	return strcmp(**(MapKey* const*)key1, **(MapKey* const*)key2);
+}
+
+/**
+ * Time getting the keys of a map in order after each batch of
+ * nChanges changes, by sorting a copy of getHashMapKeys() and with
+ * getSortedHashMapKeys().
+ *
+ * @param nKeys the number of keys in the map
+ * @param nChanges the number of keys deleted and added between sorts
+ */
+static void benchSortedKeys(int nKeys, int nChanges) {
+	static const int nRounds = 10;
+	char** keys = makeKeys("key", 2 * nKeys);
+	HashMap* map = createHashMap();
+	for (int i = 0; i < nKeys; i++) {
+		putHashMapEntry(map, keys[i], NULL);
+	}
+
+	double times[2] = { 0, 0 };
+	bool isSorted = true;
+	getSortedHashMapKeys(map);
+	for (int round = 0; round < nRounds; round++) {
+		// delete the oldest keys and add new ones
+		for (int i = 0; i < nChanges; i++) {
+			deleteHashMapEntryForKey(map, keys[round*nChanges + i]);
+			putHashMapEntry(map, keys[nKeys + round*nChanges + i], NULL);
+		}
+
+		double start = nanoTime();
+		MapKey** copy = getHashMapKeys(map);
+		qsort(copy, getHashMapSize(map), sizeof(MapKey*), compareKeyPointers);
+		times[0] += nanoTime() - start;
+
+		start = nanoTime();
+		MapKey* sorted = getSortedHashMapKeys(map);
+		times[1] += nanoTime() - start;
+		for (int i = 0; i < getHashMapSize(map); i++) {
+			isSorted = isSorted && (*copy[i] == sorted[i]);
+		}
+		free(copy);
+	}
+
+	printf("%10d %10d %10.1f %10.1f %s\n", nKeys, nChanges,
+		   times[0] / nRounds / 1e3, times[1] / nRounds / 1e3,
+		   isSorted ? "" : "(order error)");
+	deleteHashMap(map);
+	deleteKeys(keys, 2 * nKeys);
+}
+
+/**
+ * Main program to run the benchmark
+ *
+ * @return the exit status of the program
+ */
+int main(void) {
+#ifdef HASH_MAP_OPEN_ADDRESSING
+	printf("open-addressed HashMap (ns/op)\n");
+#else
+	printf("chained HashMap (ns/op)\n");
+#endif
+	printf("%10s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+		   "keys", "put", "put sized", "get hit", "batch hit",
+		   "get miss", "iterate", "delete", "owned put", "owned hit");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchHashMap(nKeys);
+	}
+
+	printf("\n%d small maps (ns/map, ns/get)\n", N_SMALL_MAPS);
+	printf("%10s %10s %10s %10s\n", "keys", "fill", "get hit", "delete");
+	for (int nKeys = 1; nKeys <= 16; nKeys *= 2) {
+		benchSmallHashMaps(nKeys);
+	}
+
+	printf("\nID keys (ns/op)\n");
+	printf("%10s %10s %10s %10s %10s\n",
+		   "keys", "str put", "str hit", "uint64 put", "uint64 hit");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchIntHashMap(nKeys);
+	}
+
+	printf("\nsnapshots (ms, ns/get)\n");
+	printf("%10s %10s %10s %10s %10s %10s\n",
+		   "keys", "rebuild", "save", "open", "map hit", "snap hit");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchHashMapSnapshot(nKeys);
+	}
+
+	printf("\nfrozen maps (ns/key, ns/get)\n");
+	printf("%10s %10s %10s %10s %10s %10s\n",
+		   "keys", "freeze", "map hit", "frozen hit", "map miss", "frozen miss");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchFrozenHashMap(nKeys);
+	}
+
+	printf("\nLRU cache of half the keys, %d gets (ns/get)\n", N_LRU_OPS);
+	printf("%10s %10s %11s %10s\n", "entries", "get/put", "hits", "evictions");
+	for (int nKeys = 1000; nKeys <= 1000000; nKeys *= 10) {
+		benchLRUCache(nKeys);
+	}
+
+	printf("\n90%% misses (ns/contains)\n");
+	printf("%10s %10s %10s\n", "keys", "no filter", "filter");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchHashMapBloomFilter(nKeys);
+	}
+
+	printf("\nDiskHashMap with 1/share of its pages cached (ns/op)\n");
+	printf("%10s %10s %10s %10s %10s %10s %10s\n", "keys", "share",
+		   "put", "get", "reads/get", "scan", "pages");
+	for (int nKeys = 100000; nKeys <= 10000000; nKeys *= 10) {
+		for (int cacheShare = 1; cacheShare <= 64; cacheShare *= 8) {
+			benchDiskHashMap(nKeys, cacheShare);
+		}
+	}
+
+	printf("\nHashSet compared with HashMap (bytes/key, ns/op)\n");
+	printf("%10s %10s %10s %10s %10s %10s %10s\n", "keys", "map bytes",
+		   "set bytes", "map put", "set add", "map hit", "set hit");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchHashSet(nKeys);
+	}
+
+	printf("\nHashSet of keys that each appear twice (ns/key)\n");
+	printf("%10s %10s", "keys", "add");
+	for (int nThreads = 1; nThreads <= MAX_BUILD_THREADS; nThreads *= 2) {
+		printf(" %7d thr", nThreads);
+	}
+	printf("\n");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchHashSetFromKeys(nKeys);
+	}
+
+	printf("\ndistinct keys of keys that each appear twice (ns/key, bytes)\n");
+	printf("%10s %10s %10s %10s %10s %10s %10s\n", "keys", "set add",
+		   "hll add", "set bytes", "hll bytes", "set error", "hll error");
+	for (int nKeys = 1000; nKeys <= 10000000; nKeys *= 10) {
+		benchHyperLogLog(nKeys);
+	}
+
+	printf("\nsorted keys after each batch of changes (us/sort)\n");
+	printf("%10s %10s %10s %10s\n", "keys", "changes", "qsort copy", "view");
+	for (int nKeys = 10000; nKeys <= 1000000; nKeys *= 10) {
+		for (int nChanges = 10; nChanges <= nKeys / 10; nChanges *= 100) {
+			benchSortedKeys(nKeys, nChanges);
+		}
+	}
+	return EXIT_SUCCESS;
+}
@@ -2,7 +2,8 @@
  * hash_map_iterator.c
  *
  * This file provides the implementations of a HashMapIterator that
- * iterates over a HashMap.
+ * iterates over a HashMap. Entries are visited in the order they were
+ * added to the map by scanning its entry array.
  *
  * @since 2017-03-22
  * @author philip gust
@@ -12,6 +13,8 @@
 #include <stdbool.h>
 #include "hash_map_iterator.h"
 
+// chained table; see hash_map_open_iterator.c for the open-addressed table
+#ifndef HASH_MAP_OPEN_ADDRESSING
 
 /**
  * Create and initialize a new HashMapIterator
@@ -21,8 +24,7 @@
  */
 HashMapIterator* createHashMapIterator(HashMap* map) {
 	HashMapIterator* itr = (HashMapIterator*)malloc(sizeof(HashMapIterator));
- 	itr->map = map;
-	resetHashMapIterator(itr);
+	initHashMapIterator(itr, map);
 	return itr;
 }
 
@@ -32,11 +34,31 @@ HashMapIterator* createHashMapIterator(HashMap* map) {
  * @param itr the HashMapIterator to delete
  */
 void deleteHashMapIterator(HashMapIterator* itr) {
+	finishHashMapIterator(itr);
+	free(itr);
+}
+
+/**
+ * Initialize a HashMapIterator that the caller has allocated, such as
+ * one on the stack.
+ *
+ * @param itr the HashMapIterator to initialize
+ * @param map the map
+ */
+void initHashMapIterator(HashMapIterator* itr, HashMap* map) {
+ 	itr->map = map;
+	resetHashMapIterator(itr);
+}
+
+/**
+ * Finish with a HashMapIterator initialized by initHashMapIterator().
+ *
+ * @param itr the HashMapIterator
+ */
+void finishHashMapIterator(HashMapIterator* itr) {
 	itr->map = (HashMap*)NULL;
 	itr->hashTableIndex = 0;
-	itr->hashChainEntry = (HashChainEntry*)NULL;
 	itr->count = 0;
-	free(itr);
 }
 
 /**
@@ -50,27 +72,13 @@ MapEntry* getNextHashMapEntry(HashMapIterator* itr) {
 		return (MapEntry*)NULL;
 	}
 
-	if (itr->hashChainEntry == (HashChainEntry*)NULL) {
-		// pointing off end of entry chain, so need to
-		// search forward in next table entries
-		for (itr->hashTableIndex++;
-			 itr->hashTableIndex < itr->map->capacity; itr->hashTableIndex++) {
-			// get head of table list entry chain
-			HashChainEntry* hashChainHead =
-				itr->map->hashTable[itr->hashTableIndex].hashChain;
-			// if chain exists, point to head of chain and return head
-			if (hashChainHead != (HashChainEntry*)NULL) {
-				itr->hashChainEntry = hashChainHead;
-				break;
-			}
-		}
+	// hashTableIndex is the entry after the last entry returned
+	HashChainEntry* entries = itr->map->entries;
+	while (entries[itr->hashTableIndex].entry.key == (MapKey)NULL) {
+		itr->hashTableIndex++;
 	}
-
-	// return current entry and advance listEntry to next one
-	MapEntry* entry = &itr->hashChainEntry->entry;
-	itr->hashChainEntry = itr->hashChainEntry->nextEntry;
 	itr->count++;
-	return entry;
+	return &entries[itr->hashTableIndex++].entry;
 }
 
 /**
@@ -93,35 +101,14 @@ MapEntry* getPrevHashMapEntry(HashMapIterator* itr) {
 	if (!hasPrevHashMapEntry(itr)) {
 		return (MapEntry*)NULL;
 	}
-	HashTableEntry* hashTable = itr->map->hashTable;
-	if (itr->hashChainEntry == hashTable[itr->hashTableIndex].hashChain) {
-		// pointing to start of entry chain for current entry,
-		// so need to search back in previous table entries
-		while (itr->hashTableIndex > 0) {
-			// see if previous table entry has a list
-			HashChainEntry* listEntry =
-				hashTable[--itr->hashTableIndex].hashChain;
-			if (listEntry != (HashChainEntry*)NULL) {
-				while (listEntry->nextEntry != (HashChainEntry*)NULL) {
-					listEntry = listEntry->nextEntry;
-				}
-				itr->hashChainEntry = listEntry;
-				itr->count--;
-				return &listEntry->entry;
-			}
-		}
-		return (MapEntry*)NULL;  // should not happen
-
-	} else {
-		// find previous TableListEntry for this key
-		HashChainEntry* listEntry = hashTable[itr->hashTableIndex].hashChain;
-		while (listEntry->nextEntry != itr->hashChainEntry) {
-			listEntry = listEntry->nextEntry;
-		}
-		itr->hashChainEntry = listEntry;
-		itr->count--;
-		return &listEntry->entry;
-	}
+
+	// search back from the last entry returned
+	HashChainEntry* entries = itr->map->entries;
+	do {
+		itr->hashTableIndex--;
+	} while (entries[itr->hashTableIndex].entry.key == (MapKey)NULL);
+	itr->count--;
+	return &entries[itr->hashTableIndex].entry;
 }
 
 /**
@@ -142,7 +129,6 @@ bool hasPrevHashMapEntry(HashMapIterator* itr) {
  */
 bool resetHashMapIterator(HashMapIterator* itr) {
  	itr->hashTableIndex = 0;
- 	itr->hashChainEntry = itr->map->hashTable[itr->hashTableIndex].hashChain;
  	itr->count = 0;
  	return true;
 }
@@ -167,3 +153,4 @@ size_t getHashMapIteratorAvailable(HashMapIterator* itr) {
 	return itr->map->size - itr->count;
 }
 
+#endif /* HASH_MAP_OPEN_ADDRESSING */
@@ -19,8 +19,7 @@
  */
 typedef struct {
  	HashMap* map;						// the hash map
- 	size_t hashTableIndex;				// current hash table index
- 	HashChainEntry* hashChainEntry;		// current hash chain entry
+ 	size_t hashTableIndex;				// current table slot or entry index
  	size_t count;						// count of entries returned
 } HashMapIterator;
 
@@ -39,6 +38,22 @@ HashMapIterator* createHashMapIterator(HashMap* map);
  */
 void deleteHashMapIterator(HashMapIterator* itr);
 
+/**
+ * Initialize a HashMapIterator that the caller has allocated, such as
+ * one on the stack. Call finishHashMapIterator() when done with it.
+ *
+ * @param itr the HashMapIterator to initialize
+ * @param map the map
+ */
+void initHashMapIterator(HashMapIterator* itr, HashMap* map);
+
+/**
+ * Finish with a HashMapIterator initialized by initHashMapIterator().
+ *
+ * @param itr the HashMapIterator
+ */
+void finishHashMapIterator(HashMapIterator* itr);
+
 /**
  * Gets next link entry in the map
  *
@@ -0,0 +1,1076 @@
+/*
+ * hash_map_open.c
+ *
+ * This file provides the implementation of a HashMap that is backed by
+ * an open-addressed hash table. It is selected by defining the symbol
+ * HASH_MAP_OPEN_ADDRESSING at build time.
+ *
+ * Each slot has a control byte that is either EMPTY, DELETED, or holds
+ * the low 7 bits of the hash code of the slot's key. The table is
+ * divided into groups of 16 slots, and a probe compares all 16 control
+ * bytes of a group with the key's 7 hash bits at once (using SSE2 where
+ * available), so most lookups touch a single group and one key.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "hash_map.h"
+#include "hash_map_iterator.h"
+
+#ifdef HASH_MAP_OPEN_ADDRESSING
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef DEFAULT_LOADING_FACTOR
+#define DEFAULT_LOADING_FACTOR 0.75f;
+#endif
+
+#ifndef DEFAULT_CAPACITY
+#define DEFAULT_CAPACITY 16
+#endif
+
+/** Number of slots probed together; capacity is a multiple of this */
+#define GROUP_WIDTH 16
+
+#ifndef BATCH_GROUP_SIZE
+#define BATCH_GROUP_SIZE 16		// keys whose lookups are overlapped
+#endif
+
+/** Control byte for a slot that has never been used */
+#define CONTROL_EMPTY ((signed char)-128)
+
+/** Control byte for a slot whose entry was deleted */
+#define CONTROL_DELETED ((signed char)-2)
+
+/**
+ * Get the control byte for a hash code.
+ *
+ * @param hashCode the hash code
+ * @return the control byte (0-127)
+ */
+static inline signed char controlForHash(uint64_t hashCode) {
+	return (signed char)(hashCode & 0x7f);
+}
+
+/**
+ * Get the first group to probe for a hash code.
+ *
+ * @param hashCode the hash code
+ * @param capacity the capacity of the table
+ * @return the index of the first group
+ */
+static inline size_t groupForHash(uint64_t hashCode, size_t capacity) {
+	return (hashCode >> 7) & (capacity/GROUP_WIDTH - 1);
+}
+
+/**
+ * Returns a bit mask of the slots in a group whose control byte
+ * equals the specified control byte.
+ *
+ * @param group the control bytes of the group
+ * @param control the control byte to match
+ * @return bit i set if group[i] == control
+ */
+static inline unsigned matchGroup(const signed char* group, signed char control) {
+#ifdef __SSE2__
+	__m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+	return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(control)));
+#else
+	unsigned mask = 0;
+	for (int i = 0; i < GROUP_WIDTH; i++) {
+		mask |= (unsigned)(group[i] == control) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * Returns a bit mask of the slots in a group that are empty or deleted.
+ *
+ * @param group the control bytes of the group
+ * @return bit i set if group[i] is EMPTY or DELETED
+ */
+static inline unsigned matchGroupFree(const signed char* group) {
+#ifdef __SSE2__
+	// EMPTY and DELETED are the only negative control bytes
+	__m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+	return (unsigned)_mm_movemask_epi8(ctrl);
+#else
+	unsigned mask = 0;
+	for (int i = 0; i < GROUP_WIDTH; i++) {
+		mask |= (unsigned)(group[i] < 0) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * Returns the number of entries a table of a given capacity can hold
+ * before it must be rehashed.
+ *
+ * @param map the map
+ * @param capacity the capacity of the table
+ * @return the maximum number of entries
+ */
+static size_t maxEntriesForCapacity(HashMap* map, size_t capacity) {
+	size_t maxEntries = (size_t)(capacity * map->loadFactor);
+	return (maxEntries < capacity) ? maxEntries : capacity - 1;
+}
+
+/**
+ * Returns the smallest table capacity that can hold the specified
+ * number of entries without being rehashed.
+ *
+ * @param map the map
+ * @param nEntries the number of entries
+ * @return the capacity, a power of two >= DEFAULT_CAPACITY
+ */
+static size_t capacityForEntries(HashMap* map, size_t nEntries) {
+	size_t capacity = DEFAULT_CAPACITY;
+	while (nEntries > maxEntriesForCapacity(map, capacity)) {
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+/**
+ * Allocate the control bytes and slots for a table of a given capacity.
+ *
+ * @param map the map
+ * @param capacity the capacity, a power of two >= GROUP_WIDTH
+ */
+static void allocateSlotArray(HashMap* map, size_t capacity) {
+	map->control = (signed char*)malloc(capacity);
+	memset(map->control, CONTROL_EMPTY, capacity);
+	map->slots = (HashSlot*)malloc(capacity * sizeof(HashSlot));
+	map->capacity = capacity;
+}
+
+/**
+ * Returns true if the map keeps a Bloom filter that shows that no key
+ * with the hash code is in the map.
+ *
+ * @param map the map
+ * @param hashCode the hash code
+ * @return true if the key is not in the map, false if it may be
+ */
+static inline bool isBloomFilterMiss(HashMap* map, uint64_t hashCode) {
+	return map->bloomFilter != (BloomFilter*)NULL
+		&& !mayContainBloomFilterHashCode(map->bloomFilter, hashCode);
+}
+
+/**
+ * Find the slot for the key with the specified hash code, without
+ * counting the search.
+ *
+ * @param map the map
+ * @param key the key
+ * @param hashCode the hash code of the key
+ * @param nProbes set to the number of groups probed
+ * @return the slot index, or capacity if the key is not in the map
+ */
+static size_t searchSlot(HashMap* map, MapKey key, uint64_t hashCode, size_t* nProbes) {
+	size_t groupMask = map->capacity/GROUP_WIDTH - 1;
+	size_t group = groupForHash(hashCode, map->capacity);
+	signed char control = controlForHash(hashCode);
+	size_t keyLength = SIZE_MAX;
+
+	for (size_t step = 1; ; step++) {
+		const signed char* groupControl = &map->control[group*GROUP_WIDTH];
+		for (unsigned match = matchGroup(groupControl, control);
+			 match != 0; match &= match - 1) {
+			size_t slot = group*GROUP_WIDTH + __builtin_ctz(match);
+			if (   map->slots[slot].hashCode == hashCode
+				&& isEqualMapEntryKey(map->keyArena, key, &keyLength,
+									  map->slots[slot].entry.key)) {
+				*nProbes = step;
+				return slot;
+			}
+		}
+		// key would have been placed in the first group with an empty slot
+		if (matchGroup(groupControl, CONTROL_EMPTY) != 0 || step > groupMask) {
+			*nProbes = step;
+			return map->capacity;
+		}
+		group = (group + step) & groupMask;  // triangular probe visits all groups
+	}
+}
+
+/**
+ * Find the slot for the key with the specified hash code.
+ *
+ * @param map the map
+ * @param key the key
+ * @param hashCode the hash code of the key
+ * @return the slot index, or capacity if the key is not in the map
+ */
+static size_t findSlot(HashMap* map, MapKey key, uint64_t hashCode) {
+	size_t nProbes;
+	size_t slot = searchSlot(map, key, hashCode, &nProbes);
+	HASH_MAP_COUNT_SEARCH(map, slot != map->capacity, nProbes);
+	return slot;
+}
+
+/**
+ * Find the first empty or deleted slot in the probe sequence for a hash code.
+ *
+ * @param map the map
+ * @param hashCode the hash code
+ * @return the slot index
+ */
+static size_t findFreeSlot(HashMap* map, uint64_t hashCode) {
+	size_t groupMask = map->capacity/GROUP_WIDTH - 1;
+	size_t group = groupForHash(hashCode, map->capacity);
+
+	for (size_t step = 1; ; step++) {
+		unsigned match = matchGroupFree(&map->control[group*GROUP_WIDTH]);
+		if (match != 0) {
+			return group*GROUP_WIDTH + __builtin_ctz(match);
+		}
+		group = (group + step) & groupMask;
+	}
+}
+
+/**
+ * Replace the table with a table of the specified capacity and move all
+ * entries into it. Deleted slots are discarded in the process.
+ *
+ * @param map the map
+ * @param newCapacity the new capacity, a power of two that can hold
+ *  all the entries of the map.
+ */
+static void rehashSlotArray(HashMap* map, size_t newCapacity) {
+	HASH_MAP_START_TIMER(start);
+	signed char* oldControl = map->control;
+	HashSlot* oldSlots = map->slots;
+	size_t oldCapacity = map->capacity;
+	if (newCapacity != oldCapacity) {
+		HASH_MAP_COUNT_RESIZE(map);
+	}
+
+	allocateSlotArray(map, newCapacity);
+	for (size_t i = 0; i < oldCapacity; i++) {
+		if (oldControl[i] >= 0) {
+			size_t slot = findFreeSlot(map, oldSlots[i].hashCode);
+			map->control[slot] = controlForHash(oldSlots[i].hashCode);
+			map->slots[slot] = oldSlots[i];
+		}
+	}
+	map->growthLeft = maxEntriesForCapacity(map, newCapacity) - map->size;
+
+	free(oldControl);
+	free(oldSlots);
+	rebuildHashMapBloomFilter(map);
+	HASH_MAP_STOP_TIMER(map, start);
+}
+
+/**
+ * Create new empty HashMap.
+ *
+ * @return new HashMap
+ */
+HashMap* createHashMap(void) {
+	return createHashMapWithCapacity(0);
+}
+
+/**
+ * Create new empty HashMap whose table can hold the specified
+ * number of entries without being rehashed.
+ *
+ * @param nEntries the expected number of entries
+ * @return new HashMap
+ */
+HashMap* createHashMapWithCapacity(size_t nEntries) {
+	// create and initialize the map
+	HashMap* map = (HashMap*)malloc(sizeof(HashMap));
+	map->size = 0;
+	map->loadFactor = DEFAULT_LOADING_FACTOR;
+	map->seed = createMapEntryKeyHashSeed();
+	map->keyArena = (MapKeyArena*)NULL;
+	map->bloomFilter = (BloomFilter*)NULL;
+	map->sortedKeys = (SortedKeyView*)NULL;
+	resetHashMapStats(map);
+	allocateSlotArray(map, capacityForEntries(map, nEntries));
+	map->growthLeft = maxEntriesForCapacity(map, map->capacity);
+	return map;
+}
+
+/**
+ * Create new empty HashMap that owns its keys. A put that adds an
+ * entry copies the key into an arena of the map, so callers need not
+ * keep keys alive. The copies are freed all at once by clearHashMap(),
+ * shrinkHashMap() and deleteHashMap(); until then copies of deleted
+ * keys remain in the arena.
+ *
+ * @param nEntries the expected number of entries, or 0
+ * @return new HashMap
+ */
+HashMap* createHashMapWithOwnedKeys(size_t nEntries) {
+	HashMap* map = createHashMapWithCapacity(nEntries);
+	map->keyArena = createMapKeyArena();
+	return map;
+}
+
+/**
+ * Frees a HashMap.
+ *
+ * @param map the HashMap to free
+ */
+void deleteHashMap(HashMap* map) {
+	free(map->control);
+	map->control = (signed char*)NULL;
+	free(map->slots);
+	map->slots = (HashSlot*)NULL;
+	if (map->keyArena != (MapKeyArena*)NULL) {
+		deleteMapKeyArena(map->keyArena);
+		map->keyArena = (MapKeyArena*)NULL;
+	}
+	disableHashMapBloomFilter(map);
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		deleteSortedKeyView(map->sortedKeys);
+	}
+	free(map);
+}
+
+/**
+ * Removes all of the mappings from this map.
+ *
+ * @param map the HashMap
+ */
+void clearHashMap(HashMap* map) {
+	memset(map->control, CONTROL_EMPTY, map->capacity);
+	map->size = 0;
+	map->growthLeft = maxEntriesForCapacity(map, map->capacity);
+	if (map->keyArena != (MapKeyArena*)NULL) {
+		clearMapKeyArena(map->keyArena);
+	}
+	rebuildHashMapBloomFilter(map);
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		clearSortedKeyView(map->sortedKeys);
+	}
+}
+
+/**
+ * Returns true if this map contains a mapping for the specified key.
+ *
+ * @param map the HashMap
+ * @param key the entry key to check
+ */
+bool containsHashMapKey(HashMap* map, MapKey key) {
+	return getHashMapEntry(map, key) != (MapEntry*)NULL;
+}
+
+/**
+ * Returns true if this map maps one or more keys to the specified value.
+ *
+ * @param map the HashMap
+ * @param value the entry value to check
+ */
+bool containsHashMapValue(HashMap* map, MapValue* value) {
+	for (size_t i = 0; i < map->capacity; i++) {
+		if (map->control[i] >= 0 &&
+			compareMapValue(map->slots[i].entry.value, value) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns an null-terminated array of pointers to MapEntry mappings
+ * contained in this map. Caller is responsible for freeing allocated array.
+ *
+ * @param map the map
+ * @return null-terminated array of pointers to MapEntry mappings for the map
+ */
+MapEntry** getHashMapEntries(HashMap* map) {
+	MapEntry** mapEntrySet = (MapEntry**)malloc((map->size+1)*sizeof(MapEntry*));
+	int i = 0;
+	for (size_t slot = 0; slot < map->capacity; slot++) {
+		if (map->control[slot] >= 0) {
+			mapEntrySet[i++] = &map->slots[slot].entry;
+		}
+	}
+	mapEntrySet[i] = (MapEntry*)NULL; // NULL terminated array
+	return mapEntrySet;
+}
+
+/**
+ * Calls the callback for each entry in the map until the callback
+ * returns false. The callback may change the value of the entry,
+ * but must not add or delete entries.
+ *
+ * @param map the HashMap
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all entries were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachHashMapEntry(HashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData) {
+	for (size_t slot = 0; slot < map->capacity; slot++) {
+		if (   map->control[slot] >= 0
+			&& !callback(&map->slots[slot].entry, callbackData)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Returns the entry to which the specified key is mapped, or null if
+ * this map contains no mapping for the key.
+ *
+ * @param map the HashMap
+ * @param key the entry key for the value to get
+ * @return the MapEntry for the given key
+ */
+MapEntry* getHashMapEntry(HashMap* map, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	if (isBloomFilterMiss(map, hashCode)) {
+		return (MapEntry*)NULL;
+	}
+	size_t slot = findSlot(map, key, hashCode);
+	return (slot == map->capacity) ? (MapEntry*)NULL : &map->slots[slot].entry;
+}
+
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key.
+ *
+ * @param map the HashMap
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* getHashMapValue(HashMap* map, MapKey key) {
+	MapEntry* entry = getHashMapEntry(map, key);
+	return (entry == (MapEntry*)NULL) ? (MapValue*)NULL : entry->value;
+}
+
+/**
+ * Returns the value to which the specified key is mapped, or null if
+ * this map contains no mapping for the key. Lookups in the
+ * open-addressed table never modify it, so this is the same as
+ * getHashMapValue() except that its search is not counted in the
+ * statistics kept with HASH_MAP_STATS; it can be called by several
+ * threads at once while no thread is modifying the map.
+ *
+ * @param map the HashMap
+ * @param key the entry key for the value to get
+ * @return the value for the given key
+ */
+MapValue* peekHashMapValue(HashMap* map, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	if (isBloomFilterMiss(map, hashCode)) {
+		return (MapValue*)NULL;
+	}
+	// the search is not counted, since the statistics counters may not
+	// be updated by several threads at once
+	size_t nProbes;
+	size_t slot = searchSlot(map, key, hashCode, &nProbes);
+	return (slot == map->capacity) ? (MapValue*)NULL : map->slots[slot].entry.value;
+}
+
+/**
+ * Gets the values for an array of keys. The keys are looked up together
+ * so that the memory accesses for different keys overlap, which is
+ * faster than calling getHashMapValue() for each key in large maps.
+ *
+ * @param map the HashMap
+ * @param keys the keys for the values to get
+ * @param nKeys the number of keys
+ * @param values set to the value for each key, or NULL if no mapping
+ * @return the number of keys that have a mapping
+ */
+size_t getHashMapValuesBatch(
+	HashMap* map, const MapKey keys[], size_t nKeys, MapValue* values[]) {
+	uint64_t hashCodes[BATCH_GROUP_SIZE];
+	size_t nFound = 0;
+
+	for (size_t group = 0; group < nKeys; group += BATCH_GROUP_SIZE) {
+		size_t groupSize = (nKeys - group < BATCH_GROUP_SIZE)
+			? nKeys - group : BATCH_GROUP_SIZE;
+
+		// hash the keys and prefetch the control bytes of the
+		// first group each key probes
+		for (size_t i = 0; i < groupSize; i++) {
+			hashCodes[i] = getMapEntryKeyHashCode(keys[group+i], map->seed);
+			size_t slot = groupForHash(hashCodes[i], map->capacity) * GROUP_WIDTH;
+			__builtin_prefetch(&map->control[slot]);
+		}
+
+		// prefetch the first slot in the group whose control byte matches
+		for (size_t i = 0; i < groupSize; i++) {
+			size_t slot = groupForHash(hashCodes[i], map->capacity) * GROUP_WIDTH;
+			unsigned match =
+				matchGroup(&map->control[slot], controlForHash(hashCodes[i]));
+			if (match != 0) {
+				__builtin_prefetch(&map->slots[slot + __builtin_ctz(match)]);
+			}
+		}
+
+		// probe for the keys
+		for (size_t i = 0; i < groupSize; i++) {
+			size_t slot = findSlot(map, keys[group+i], hashCodes[i]);
+			if (slot == map->capacity) {
+				values[group+i] = (MapValue*)NULL;
+			} else {
+				values[group+i] = map->slots[slot].entry.value;
+				nFound++;
+			}
+		}
+	}
+	return nFound;
+}
+
+/**
+ * Returns an null-terminated array of pointers to MapValue entries contained
+ * in this map. Caller is responsible for freeing allocated array.
+ *
+ * @param map the map
+ * @return null-terminated array of pointers to KeyMap keys for this map
+ */
+MapValue** getHashMapValues(HashMap* map) {
+	MapValue** valueSet = (MapValue**)malloc((map->size+1)*sizeof(MapValue*));
+	int i = 0;
+	for (size_t slot = 0; slot < map->capacity; slot++) {
+		if (map->control[slot] >= 0) {
+			valueSet[i++] = map->slots[slot].entry.value;
+		}
+	}
+	valueSet[i] = (MapValue*)NULL; // NULL terminated array
+	return valueSet;
+}
+
+/**
+ * Returns true if this map contains no key-value mappings.
+ *
+ * @param map the HashMap
+ * @return true of the map is entry, false otherwise
+ */
+bool isHashMapEmpty(HashMap* map) {
+	return map->size == 0;
+}
+
+/**
+ * Returns an null-terminated array of pointers to MapKey keys contained
+ * in this map. Caller is responsible for freeing allocated array.
+ *
+ * @param map the map
+ * @return null-terminated array of pointers to KeyMap keys for this map
+ */
+MapKey** getHashMapKeys(HashMap* map) {
+	MapKey** keySet = (MapKey**)malloc((map->size+1)*sizeof(MapKey*));
+	int i = 0;
+	for (size_t slot = 0; slot < map->capacity; slot++) {
+		if (map->control[slot] >= 0) {
+			keySet[i++] = &map->slots[slot].entry.key;
+		}
+	}
+	keySet[i] = (MapKey*)NULL; // NULL terminated array
+	return keySet;
+}
+
+/**
+ * Returns the keys of this map in increasing order. The first call
+ * sorts the keys into a view that the map keeps from then on: a key
+ * pointer per key, and a change record for each later put or delete.
+ * Later calls merge in the changes with O(k log n) comparisons for k
+ * changes, but also scan and move every key, so each refresh is O(n)
+ * rather than the O(n log n) of sorting a copy of getHashMapKeys().
+ *
+ * @param map the HashMap
+ * @return the getHashMapSize() keys of the map in strcmp() order,
+ *   valid until the map is changed
+ */
+MapKey* getSortedHashMapKeys(HashMap* map) {
+	if (map->sortedKeys == (SortedKeyView*)NULL) {
+		map->sortedKeys = createSortedKeyView();
+	}
+	SortedKeyView* view = map->sortedKeys;
+	if (view->isStale) {
+		MapKey* keys = prepareSortedKeyView(view, map->size);
+		size_t count = 0;
+		for (size_t slot = 0; slot < map->capacity; slot++) {
+			if (map->control[slot] >= 0) {
+				keys[count++] = map->slots[slot].entry.key;
+			}
+		}
+		sortSortedKeyView(view);
+	} else {
+		updateSortedKeyView(view);
+	}
+	return view->keys;
+}
+
+/**
+ * Returns the position in getSortedHashMapKeys() of the first key of
+ * this map that is not less than the specified key.
+ *
+ * @param map the HashMap
+ * @param key the key
+ * @return the index of the key, or the size of the map if all keys
+ *   are less than the key
+ */
+size_t findHashMapLowerBound(HashMap* map, MapKey key) {
+	getSortedHashMapKeys(map);
+	return findSortedKeyViewLowerBound(map->sortedKeys, key);
+}
+
+/**
+ * Adds a new entry with the key, value and hash code to the map,
+ * and rehashes the table if necessary.
+ *
+ * @param map the map
+ * @param hashCode the hash code of the key
+ * @param key the key to add
+ * @param value the value to add
+ * @return the slot of the new entry
+ */
+static size_t addEntryToSlotArray(
+	HashMap* map, uint64_t hashCode, MapKey key, MapValue* value) {
+	size_t slot = findFreeSlot(map, hashCode);
+	if (map->growthLeft == 0 && map->control[slot] == CONTROL_EMPTY) {
+		// grow the table unless enough slots are only held by deleted
+		// entries, in which case rehashing in place reclaims them
+		size_t maxEntries = maxEntriesForCapacity(map, map->capacity);
+		size_t newCapacity =
+			(map->size < maxEntries/2) ? map->capacity : 2*map->capacity;
+		rehashSlotArray(map, newCapacity);
+		slot = findFreeSlot(map, hashCode);
+	}
+
+	if (map->control[slot] == CONTROL_EMPTY) {
+		map->growthLeft--;
+	}
+	map->control[slot] = controlForHash(hashCode);
+	map->slots[slot].entry.key = (map->keyArena == (MapKeyArena*)NULL)
+		? key : copyMapKeyToArena(map->keyArena, key, strlen(key));
+	map->slots[slot].entry.value = value;
+	map->slots[slot].hashCode = hashCode;
+	map->size++;
+	if (map->bloomFilter != (BloomFilter*)NULL) {
+		addBloomFilterHashCode(map->bloomFilter, hashCode);
+	}
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		addSortedKeyViewChange(map->sortedKeys, map->slots[slot].entry.key, true);
+	}
+	return slot;
+}
+
+/**
+ * Removes the entry in a slot from the map.
+ *
+ * @param map the map
+ * @param slot the slot of the entry
+ * @return the value of the removed entry
+ */
+static MapValue* removeSlotEntry(HashMap* map, size_t slot) {
+	if (map->sortedKeys != (SortedKeyView*)NULL) {
+		addSortedKeyViewChange(map->sortedKeys, map->slots[slot].entry.key, false);
+	}
+
+	// a probe stops at a group with an empty slot, so the slot can be
+	// marked empty rather than deleted if its group already has one
+	size_t group = slot / GROUP_WIDTH;
+	if (matchGroup(&map->control[group*GROUP_WIDTH], CONTROL_EMPTY) != 0) {
+		map->control[slot] = CONTROL_EMPTY;
+		map->growthLeft++;
+	} else {
+		map->control[slot] = CONTROL_DELETED;
+	}
+	map->size--;
+	return map->slots[slot].entry.value;
+}
+
+/**
+ * Associates the specified value with the specified key in this map
+ *
+ * @param map the HashMap
+ * @param key the key for the value to put
+ * @param value the HashMapValue for the key
+ * @return the previous value for the key, or NULL for a new entry
+ */
+MapValue* putHashMapEntry(HashMap* map, MapKey key, MapValue* value) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+
+	// replace value of existing entry
+	size_t slot = isBloomFilterMiss(map, hashCode)
+		? map->capacity : findSlot(map, key, hashCode);
+	if (slot != map->capacity) {
+		MapValue* oldValue = map->slots[slot].entry.value;
+		map->slots[slot].entry.value = value;
+		return oldValue;
+	}
+
+	addEntryToSlotArray(map, hashCode, key, value);
+	return (MapValue*)NULL;
+}
+
+/**
+ * Associates the specified value with the specified key in this map
+ * if the key is not already in the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value to put
+ * @param value the HashMapValue for the key
+ * @return the current value for the key, or NULL for a new entry
+ */
+MapValue* putIfAbsentHashMapEntry(HashMap* map, MapKey key, MapValue* value) {
+	bool isNew;
+	MapEntry* entry = getOrPutHashMapEntry(map, key, &isNew);
+	if (isNew) {
+		entry->value = value;
+		return (MapValue*)NULL;
+	}
+	return entry->value;
+}
+
+/**
+ * Returns the value for the key if it is in the map. Otherwise calls
+ * the callback to compute a value, and adds an entry for the key
+ * unless the callback returns NULL. The callback must not modify
+ * the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value
+ * @param callback called with the key and a NULL value
+ * @param callbackData the callback data
+ * @return the current or computed value for the key
+ */
+MapValue* computeIfAbsentHashMapEntry(HashMap* map, MapKey key,
+	HashMapComputeCallback callback, HashMapComputeData callbackData) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	size_t slot = isBloomFilterMiss(map, hashCode)
+		? map->capacity : findSlot(map, key, hashCode);
+	if (slot != map->capacity) {
+		return map->slots[slot].entry.value;
+	}
+
+	MapValue* value = callback(key, (MapValue*)NULL, callbackData);
+	if (value != (MapValue*)NULL) {
+		addEntryToSlotArray(map, hashCode, key, value);
+	}
+	return value;
+}
+
+/**
+ * Calls the callback to compute a new value for the key if it is in
+ * the map. The entry is updated with the new value, or removed if the
+ * callback returns NULL. The callback must not modify the map.
+ *
+ * @param map the HashMap
+ * @param key the key for the value
+ * @param callback called with the key and its current value
+ * @param callbackData the callback data
+ * @return the new value for the key, or NULL if none
+ */
+MapValue* computeIfPresentHashMapEntry(HashMap* map, MapKey key,
+	HashMapComputeCallback callback, HashMapComputeData callbackData) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	size_t slot = isBloomFilterMiss(map, hashCode)
+		? map->capacity : findSlot(map, key, hashCode);
+	if (slot == map->capacity) {
+		return (MapValue*)NULL;
+	}
+
+	MapValue* value = callback(key, map->slots[slot].entry.value, callbackData);
+	if (value == (MapValue*)NULL) {
+		removeSlotEntry(map, slot);
+	} else {
+		map->slots[slot].entry.value = value;
+	}
+	return value;
+}
+
+/**
+ * Returns the entry for the key, adding an entry with a NULL value if
+ * the key is not in the map. The caller can update the value through
+ * the entry without looking up the key again.
+ *
+ * @param map the HashMap
+ * @param key the key for the entry
+ * @param isNew set to true if the entry was added, false otherwise
+ * @return the entry for the key
+ */
+MapEntry* getOrPutHashMapEntry(HashMap* map, MapKey key, bool* isNew) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	size_t slot = isBloomFilterMiss(map, hashCode)
+		? map->capacity : findSlot(map, key, hashCode);
+	*isNew = (slot == map->capacity);
+	if (*isNew) {
+		slot = addEntryToSlotArray(map, hashCode, key, (MapValue*)NULL);
+	}
+	return &map->slots[slot].entry;
+}
+
+/**
+ * Copies all of the mappings from the specified map to this map.
+ * The map is rehashed once for all the entries of the other map.
+ *
+ * @param map the HashMap
+ * @param aMap another map whose entries will be added to the map
+ * @return true if any new mappings were created as a result of this call
+ */
+bool putAllHashMapEntries(HashMap* map, HashMap* aMap) {
+	reserveHashMap(map, map->size + aMap->size);
+	bool result = false;
+	for (size_t slot = 0; slot < aMap->capacity; slot++) {
+		if (aMap->control[slot] >= 0) {
+			MapEntry* entry = &aMap->slots[slot].entry;
+			result |= (putHashMapEntry(map, entry->key, entry->value) == NULL);
+		}
+	}
+	return result;
+}
+
+/**
+ * Associates each of an array of keys with the corresponding value.
+ * The map is rehashed at most once before the entries are added.
+ *
+ * @param map the HashMap
+ * @param keys the keys to put
+ * @param values the value for each key
+ * @param nEntries the number of keys and values
+ * @return the number of new entries added to the map
+ */
+size_t loadHashMapEntries(HashMap* map,
+	const MapKey keys[], MapValue* const values[], size_t nEntries) {
+	size_t oldSize = map->size;
+	reserveHashMap(map, map->size + nEntries);
+	for (size_t i = 0; i < nEntries; i++) {
+		putHashMapEntry(map, keys[i], values[i]);
+	}
+	return map->size - oldSize;
+}
+
+/**
+ * Rehashes the table if necessary so that the map can hold the specified
+ * number of entries without being rehashed again.
+ *
+ * @param map the HashMap
+ * @param nEntries the number of entries to make room for
+ */
+void reserveHashMap(HashMap* map, size_t nEntries) {
+	size_t newCapacity = capacityForEntries(map, nEntries);
+	if (newCapacity > map->capacity) {
+		rehashSlotArray(map, newCapacity);
+	}
+}
+
+/**
+ * Releases memory that the map no longer needs after entries have been
+ * deleted, by rehashing into the smallest table that holds the current
+ * entries. This also discards deleted slots. It must not be called while
+ * the map is being iterated.
+ *
+ * @param map the HashMap
+ */
+void shrinkHashMap(HashMap* map) {
+	rehashSlotArray(map, capacityForEntries(map, map->size));
+	if (map->keyArena != (MapKeyArena*)NULL) {
+		// copy the remaining keys into a new arena to drop deleted ones
+		MapKeyArena* keyArena = createMapKeyArena();
+		for (size_t i = 0; i < map->capacity; i++) {
+			if (map->control[i] >= 0) {
+				MapKey key = map->slots[i].entry.key;
+				map->slots[i].entry.key =
+					copyMapKeyToArena(keyArena, key, getArenaMapKeyLength(key));
+			}
+		}
+		deleteMapKeyArena(map->keyArena);
+		map->keyArena = keyArena;
+		if (map->sortedKeys != (SortedKeyView*)NULL) {
+			invalidateSortedKeyView(map->sortedKeys);
+		}
+	}
+}
+
+/**
+ * Removes the mapping for a key from this map if it is present
+ *
+ * @param map the HashMap
+ * @param key the key for the value to remove
+ * @return the value of the entry that was removed
+ */
+MapValue* deleteHashMapEntryForKey(HashMap* map, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, map->seed);
+	size_t slot = isBloomFilterMiss(map, hashCode)
+		? map->capacity : findSlot(map, key, hashCode);
+	if (slot == map->capacity) {
+		return (MapValue*)NULL;
+	}
+	return removeSlotEntry(map, slot);
+}
+
+/**
+ * Removes each entry of this map for which the callback returns true.
+ * The callback must not add or delete entries itself. Removing an
+ * entry only changes its control byte, so no entries move.
+ *
+ * @param map the HashMap
+ * @param callback returns true for an entry to remove
+ * @param callbackData the callback data
+ * @return the number of entries removed
+ */
+size_t deleteHashMapEntriesIf(HashMap* map,
+	HashMapForEachCallback callback, HashMapForEachData callbackData) {
+	size_t nDeleted = 0;
+	for (size_t slot = 0; slot < map->capacity; slot++) {
+		if (   map->control[slot] >= 0
+			&& callback(&map->slots[slot].entry, callbackData)) {
+			removeSlotEntry(map, slot);
+			nDeleted++;
+		}
+	}
+	return nDeleted;
+}
+
+/**
+ * Keeps a Bloom filter of the keys of this map, so that most lookups
+ * and puts of keys that are not in the map skip probing the table.
+ * The filter is sized for the capacity of the table and rebuilt when
+ * the table is rehashed. Deleted keys stay in the filter until it is
+ * rebuilt, so call rebuildHashMapBloomFilter() after many deletes.
+ * Batched lookups do not use the filter.
+ *
+ * @param map the HashMap
+ */
+void enableHashMapBloomFilter(HashMap* map) {
+	if (map->bloomFilter == (BloomFilter*)NULL) {
+		map->bloomFilter = createBloomFilter(maxEntriesForCapacity(map, map->capacity));
+		rebuildHashMapBloomFilter(map);
+	}
+}
+
+/**
+ * Stops keeping a Bloom filter of the keys of this map, and frees it.
+ *
+ * @param map the HashMap
+ */
+void disableHashMapBloomFilter(HashMap* map) {
+	if (map->bloomFilter != (BloomFilter*)NULL) {
+		deleteBloomFilter(map->bloomFilter);
+		map->bloomFilter = (BloomFilter*)NULL;
+	}
+}
+
+/**
+ * Rebuilds the Bloom filter of this map from its current keys, which
+ * removes deleted keys from the filter. Does nothing if the map does
+ * not keep a filter. The hash codes are read from the slots, so this
+ * does not rehash any keys.
+ *
+ * @param map the HashMap
+ */
+void rebuildHashMapBloomFilter(HashMap* map) {
+	if (map->bloomFilter == (BloomFilter*)NULL) {
+		return;
+	}
+	resetBloomFilter(map->bloomFilter, maxEntriesForCapacity(map, map->capacity));
+	for (size_t i = 0; i < map->capacity; i++) {
+		if (map->control[i] >= 0) {
+			addBloomFilterHashCode(map->bloomFilter, map->slots[i].hashCode);
+		}
+	}
+}
+
+/**
+ * Finishes moving entries to a resized table now rather than
+ * incrementally during later operations. The open-addressed table
+ * is always rehashed all at once, so there is nothing to finish.
+ *
+ * @param map the HashMap
+ */
+void completeHashMapRehash(HashMap* map) {
+}
+
+/**
+ * Returns true if entries are still being moved to a resized table.
+ *
+ * @param map the HashMap
+ * @return false, the open-addressed table is rehashed all at once
+ */
+bool isHashMapRehashing(HashMap* map) {
+	return false;
+}
+
+/**
+ * Returns the number of key-value mappings in this map.
+ *
+ * @param map the HashMap
+ * @return the number of entries in the map
+ */
+int getHashMapSize(HashMap* map) {
+	return map->size;
+}
+
+/**
+ * Gets statistics of this map. The chain length of an entry is the
+ * number of groups probed to find it, which is found by scanning the
+ * table in time proportional to its capacity. The search, probe and
+ * resize counts are only kept if the map was built with HASH_MAP_STATS
+ * defined, and are 0 otherwise.
+ *
+ * @param map the HashMap
+ * @param stats set to the statistics of the map
+ */
+void getHashMapStats(HashMap* map, HashMapStats* stats) {
+	memset(stats, 0, sizeof(HashMapStats));
+	stats->size = map->size;
+	stats->capacity = map->capacity;
+	size_t groupMask = map->capacity/GROUP_WIDTH - 1;
+	for (size_t slot = 0; slot < map->capacity; slot++) {
+		if (map->control[slot] >= 0) {
+			// follow the probe sequence of the entry to its group
+			size_t group = groupForHash(map->slots[slot].hashCode, map->capacity);
+			size_t length = 1;
+			while (group != slot/GROUP_WIDTH) {
+				group = (group + length++) & groupMask;
+			}
+			stats->chainLengths[(length < HASH_MAP_STATS_CHAIN_LENGTHS)
+								? length : HASH_MAP_STATS_CHAIN_LENGTHS-1]++;
+			if (length > stats->maxChainLength) {
+				stats->maxChainLength = length;
+			}
+		}
+	}
+	stats->tableBytes = map->capacity;
+	stats->entryBytes = map->capacity * sizeof(HashSlot);
+	if (map->bloomFilter != (BloomFilter*)NULL) {
+		stats->filterBytes =
+			map->bloomFilter->nBlocks * BLOOM_FILTER_BLOCK_WORDS * sizeof(uint64_t);
+	}
+#ifdef HASH_MAP_STATS
+	stats->hitCount = map->counters.hitCount;
+	stats->missCount = map->counters.missCount;
+	if (map->counters.hitCount > 0) {
+		stats->probesPerHit = (double)map->counters.hitProbes / map->counters.hitCount;
+	}
+	if (map->counters.missCount > 0) {
+		stats->probesPerMiss = (double)map->counters.missProbes / map->counters.missCount;
+	}
+	stats->resizeCount = map->counters.resizeCount;
+	stats->resizeMillis = map->counters.resizeNanos / 1e6;
+#endif
+}
+
+/**
+ * Resets the search, probe and resize counts of this map to 0.
+ *
+ * @param map the HashMap
+ */
+void resetHashMapStats(HashMap* map) {
+#ifdef HASH_MAP_STATS
+	memset(&map->counters, 0, sizeof(HashMapCounters));
+#endif
+}
+
+#endif /* HASH_MAP_OPEN_ADDRESSING */
@@ -0,0 +1,154 @@
+/*
+ * hash_map_open_iterator.c
+ *
+ * This file provides the implementations of a HashMapIterator that
+ * iterates over a HashMap backed by an open-addressed hash table.
+ * It is selected by defining the symbol HASH_MAP_OPEN_ADDRESSING
+ * at build time.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "hash_map_iterator.h"
+
+#ifdef HASH_MAP_OPEN_ADDRESSING
+
+/**
+ * Create and initialize a new HashMapIterator
+ *
+ * @param map the map
+ * @return an iterator for the specified hash map
+ */
+HashMapIterator* createHashMapIterator(HashMap* map) {
+	HashMapIterator* itr = (HashMapIterator*)malloc(sizeof(HashMapIterator));
+	initHashMapIterator(itr, map);
+	return itr;
+}
+
+/**
+ * Freeing iterator storage.
+ *
+ * @param itr the HashMapIterator to delete
+ */
+void deleteHashMapIterator(HashMapIterator* itr) {
+	finishHashMapIterator(itr);
+	free(itr);
+}
+
+/**
+ * Initialize a HashMapIterator that the caller has allocated, such as
+ * one on the stack.
+ *
+ * @param itr the HashMapIterator to initialize
+ * @param map the map
+ */
+void initHashMapIterator(HashMapIterator* itr, HashMap* map) {
+ 	itr->map = map;
+	resetHashMapIterator(itr);
+}
+
+/**
+ * Finish with a HashMapIterator initialized by initHashMapIterator().
+ *
+ * @param itr the HashMapIterator
+ */
+void finishHashMapIterator(HashMapIterator* itr) {
+	itr->map = (HashMap*)NULL;
+	itr->hashTableIndex = 0;
+	itr->count = 0;
+}
+
+/**
+ * Gets next entry in the map.
+ *
+ * @param itr the HashMapIterator
+ * @return the next entry or NULL if iterator is at end the map
+ */
+MapEntry* getNextHashMapEntry(HashMapIterator* itr) {
+	if (!hasNextHashMapEntry(itr)) {
+		return (MapEntry*)NULL;
+	}
+
+	// hashTableIndex is the slot after the last entry returned
+	while (itr->map->control[itr->hashTableIndex] < 0) {
+		itr->hashTableIndex++;
+	}
+	itr->count++;
+	return &itr->map->slots[itr->hashTableIndex++].entry;
+}
+
+/**
+ * Determines whether there is another entry in the map
+ *
+ * @param itr the HashMapIterator
+ * @return true if there is another entry, false otherwise
+ */
+bool hasNextHashMapEntry(HashMapIterator* itr) {
+	return itr->count < itr->map->size;
+}
+
+/**
+ * Gets previous entry in the hash map
+ *
+ * @param itr the HashMapIterator
+ * @return the previous entry or NULL if iterator is at end of list
+ */
+MapEntry* getPrevHashMapEntry(HashMapIterator* itr) {
+	if (!hasPrevHashMapEntry(itr)) {
+		return (MapEntry*)NULL;
+	}
+
+	// search back from the slot of the last entry returned
+	do {
+		itr->hashTableIndex--;
+	} while (itr->map->control[itr->hashTableIndex] < 0);
+	itr->count--;
+	return &itr->map->slots[itr->hashTableIndex].entry;
+}
+
+/**
+ * Determines whether there is a previous entry in the map.
+ *
+ * @param itr the HashMapIterator
+ * @return true if there is a previous entry, false otherwise
+ */
+bool hasPrevHashMapEntry(HashMapIterator* itr) {
+	return itr->count > 0;
+}
+
+/**
+ * Resets the hash map iterator to the beginning of the map.
+ *
+ * @param itr the HashMapIterator
+ * @return true if successful, false if not supported
+ */
+bool resetHashMapIterator(HashMapIterator* itr) {
+ 	itr->hashTableIndex = 0;
+ 	itr->count = 0;
+ 	return true;
+}
+
+/**
+ * Returns the number of entries returned so far.
+ *
+ * @param itr the HashMapIterator
+ * @return the number of entries returned so far
+ */
+size_t getHashMapIteratorCount(HashMapIterator* itr) {
+	return itr->count;
+}
+
+/**
+ * Returns the number of entries available.
+ *
+ * @param itr the HashMapIterator
+ * @return available number of entries or UNAVAILABLE if cannot perform operation.
+ */
+size_t getHashMapIteratorAvailable(HashMapIterator* itr) {
+	return itr->map->size - itr->count;
+}
+
+#endif /* HASH_MAP_OPEN_ADDRESSING */
@@ -0,0 +1,284 @@
+/*
+ * hash_map_snapshot.c
+ *
+ * This file provides the implementation of a HashMapSnapshot, which is
+ * a read-only copy of a HashMap in a file that is used through mmap.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hash_map_snapshot.h"
+
+/** Identifies the snapshot file format and hash function version */
+static const char SNAPSHOT_MAGIC[8] = "HMSNAP1";
+
+/**
+ * An entry collected from the map being saved.
+ */
+typedef struct {
+	MapEntry entry;						// entry key/value pair
+	uint64_t hashCode;					// hash code for the entry key
+} SnapshotSource;
+
+/**
+ * Data for the callback that collects the entries of a map.
+ */
+typedef struct {
+	SnapshotSource* sources;			// the collected entries
+	size_t count;						// number of entries collected
+	uint64_t seed;						// hash seed of the map
+} SnapshotSourceData;
+
+/**
+ * For-each callback that collects an entry and its hash code.
+ *
+ * @param entry the entry
+ * @param data the SnapshotSourceData
+ * @return true to continue
+ */
+static bool collectSnapshotSource(MapEntry* entry, HashMapForEachData data) {
+	SnapshotSourceData* sourceData = (SnapshotSourceData*)data;
+	SnapshotSource* source = &sourceData->sources[sourceData->count++];
+	source->entry = *entry;
+	source->hashCode = getMapEntryKeyHashCode(entry->key, sourceData->seed);
+	return true;
+}
+
+/**
+ * Rounds an offset up to a multiple of 8 bytes.
+ *
+ * @param offset the offset
+ * @return the rounded offset
+ */
+static inline uint64_t alignSnapshotOffset(uint64_t offset) {
+	return (offset + 7) & ~(uint64_t)7;
+}
+
+/**
+ * Saves a snapshot of a map to a file. The value of each entry is
+ * saved as its valuestr string.
+ *
+ * @param map the HashMap
+ * @param path the path of the file
+ * @return true if the snapshot was saved, false if the file could
+ *   not be written
+ */
+bool saveHashMapSnapshot(HashMap* map, const char* path) {
+	size_t size = getHashMapSize(map);
+	uint64_t capacity = 1;
+	while (capacity < size) {
+		capacity *= 2;
+	}
+
+	// collect the entries, and group them by chain with a counting sort
+	SnapshotSourceData sourceData = {
+		(SnapshotSource*)malloc((size+1) * sizeof(SnapshotSource)), 0, map->seed
+	};
+	forEachHashMapEntry(map, collectSnapshotSource, &sourceData);
+	uint32_t* table = (uint32_t*)calloc(capacity+1, sizeof(uint32_t));
+	for (size_t i = 0; i < size; i++) {
+		table[(sourceData.sources[i].hashCode & (capacity-1)) + 1]++;
+	}
+	for (size_t i = 0; i < capacity; i++) {
+		table[i+1] += table[i];
+	}
+	uint32_t* next = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+	memcpy(next, table, capacity * sizeof(uint32_t));
+	SnapshotSource** chainOrder = (SnapshotSource**)malloc((size+1) * sizeof(SnapshotSource*));
+	for (size_t i = 0; i < size; i++) {
+		chainOrder[next[sourceData.sources[i].hashCode & (capacity-1)]++] =
+			&sourceData.sources[i];
+	}
+	free(next);
+
+	// lay out the file; strings follow the entries
+	HashMapSnapshotHeader header;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof header.magic);
+	header.seed = map->seed;
+	header.capacity = capacity;
+	header.size = size;
+	header.tableOffset = sizeof(HashMapSnapshotHeader);
+	header.entriesOffset =
+		alignSnapshotOffset(header.tableOffset + (capacity+1)*sizeof(uint32_t));
+	HashMapSnapshotEntry* entries =
+		(HashMapSnapshotEntry*)calloc(size+1, sizeof(HashMapSnapshotEntry));
+	uint64_t stringOffset = header.entriesOffset + size*sizeof(HashMapSnapshotEntry);
+	for (size_t i = 0; i < size; i++) {
+		MapEntry* entry = &chainOrder[i]->entry;
+		entries[i].hashCode = chainOrder[i]->hashCode;
+		entries[i].keyLength = strlen(entry->key);
+		entries[i].keyOffset = stringOffset;
+		stringOffset += entries[i].keyLength + 1;
+		if (entry->value != (MapValue*)NULL && entry->value->valuestr != (char*)NULL) {
+			entries[i].valueOffset = stringOffset;
+			stringOffset += strlen(entry->value->valuestr) + 1;
+		}
+	}
+	header.fileSize = stringOffset;
+
+	// write the file
+	static const char padding[8];
+	FILE* file = fopen(path, "wb");
+	bool ok = (file != (FILE*)NULL);
+	if (ok) {
+		ok = fwrite(&header, sizeof header, 1, file) == 1
+			&& fwrite(table, sizeof(uint32_t), capacity+1, file) == capacity+1
+			&& fwrite(padding, 1, header.entriesOffset - header.tableOffset
+					  - (capacity+1)*sizeof(uint32_t), file)
+				== header.entriesOffset - header.tableOffset - (capacity+1)*sizeof(uint32_t)
+			&& fwrite(entries, sizeof(HashMapSnapshotEntry), size, file) == size;
+		for (size_t i = 0; ok && i < size; i++) {
+			MapEntry* entry = &chainOrder[i]->entry;
+			ok = fwrite(entry->key, 1, entries[i].keyLength + 1, file)
+				== entries[i].keyLength + 1;
+			if (ok && entries[i].valueOffset != 0) {
+				size_t valueLength = strlen(entry->value->valuestr) + 1;
+				ok = fwrite(entry->value->valuestr, 1, valueLength, file) == valueLength;
+			}
+		}
+		ok = (fclose(file) == 0) && ok;
+	}
+
+	free(entries);
+	free(chainOrder);
+	free(table);
+	free(sourceData.sources);
+	return ok;
+}
+
+/**
+ * Opens a snapshot by mapping its file read-only.
+ *
+ * @param path the path of the file
+ * @return the snapshot, or NULL if the file could not be mapped or
+ *   is not a valid snapshot
+ */
+HashMapSnapshot* openHashMapSnapshot(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return (HashMapSnapshot*)NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < sizeof(HashMapSnapshotHeader)) {
+		close(fd);
+		return (HashMapSnapshot*)NULL;
+	}
+	void* base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);  // the mapping keeps the file open
+	if (base == MAP_FAILED) {
+		return (HashMapSnapshot*)NULL;
+	}
+
+	// check the header and that the table and entries are in the file
+	const HashMapSnapshotHeader* header = (const HashMapSnapshotHeader*)base;
+	const uint32_t* table = (const uint32_t*)((const char*)base + header->tableOffset);
+	bool isValid =
+		   memcmp(header->magic, SNAPSHOT_MAGIC, sizeof header->magic) == 0
+		&& header->fileSize == (uint64_t)st.st_size
+		&& header->capacity != 0
+		&& header->capacity <= header->fileSize
+		&& (header->capacity & (header->capacity-1)) == 0
+		&& header->size <= UINT32_MAX
+		&& header->tableOffset >= sizeof(HashMapSnapshotHeader)
+		&& header->entriesOffset % sizeof(uint64_t) == 0
+		&& header->tableOffset + (header->capacity+1)*sizeof(uint32_t)
+			<= header->entriesOffset
+		&& header->entriesOffset + header->size*sizeof(HashMapSnapshotEntry)
+			<= header->fileSize
+		&& table[header->capacity] == header->size;
+	if (!isValid) {
+		munmap(base, st.st_size);
+		return (HashMapSnapshot*)NULL;
+	}
+
+	HashMapSnapshot* snapshot = (HashMapSnapshot*)malloc(sizeof(HashMapSnapshot));
+	snapshot->base = (const char*)base;
+	snapshot->length = st.st_size;
+	snapshot->header = header;
+	snapshot->table = table;
+	snapshot->entries =
+		(const HashMapSnapshotEntry*)(snapshot->base + header->entriesOffset);
+	return snapshot;
+}
+
+/**
+ * Closes a snapshot, and unmaps its file.
+ *
+ * @param snapshot the snapshot
+ */
+void closeHashMapSnapshot(HashMapSnapshot* snapshot) {
+	munmap((void*)snapshot->base, snapshot->length);
+	free(snapshot);
+}
+
+/**
+ * Finds the entry for a key in a snapshot.
+ *
+ * @param snapshot the snapshot
+ * @param key the key
+ * @return the entry for the key, or NULL if the key is not present
+ */
+static const HashMapSnapshotEntry* findSnapshotEntry(
+	HashMapSnapshot* snapshot, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, snapshot->header->seed);
+	size_t chain = hashCode & (snapshot->header->capacity-1);
+	for (uint32_t i = snapshot->table[chain]; i < snapshot->table[chain+1]; i++) {
+		const HashMapSnapshotEntry* entry = &snapshot->entries[i];
+		if (   entry->hashCode == hashCode
+			&& compareMapKey(key, snapshot->base + entry->keyOffset) == 0) {
+			return entry;
+		}
+	}
+	return (const HashMapSnapshotEntry*)NULL;
+}
+
+/**
+ * Returns true if the snapshot contains a mapping for the specified key.
+ *
+ * @param snapshot the snapshot
+ * @param key the entry key to check
+ * @return true if the snapshot contains the key, false otherwise
+ */
+bool containsHashMapSnapshotKey(HashMapSnapshot* snapshot, MapKey key) {
+	return findSnapshotEntry(snapshot, key) != (const HashMapSnapshotEntry*)NULL;
+}
+
+/**
+ * Gets the value to which the specified key is mapped. The valuestr
+ * of the value points into the mapped file, and is valid until the
+ * snapshot is closed.
+ *
+ * @param snapshot the snapshot
+ * @param key the entry key for the value to get
+ * @param value set to the value for the key
+ * @return value, or NULL if the snapshot contains no mapping for the
+ *   key or the key was mapped to NULL
+ */
+MapValue* getHashMapSnapshotValue(
+	HashMapSnapshot* snapshot, MapKey key, MapValue* value) {
+	const HashMapSnapshotEntry* entry = findSnapshotEntry(snapshot, key);
+	if (entry == (const HashMapSnapshotEntry*)NULL || entry->valueOffset == 0) {
+		return (MapValue*)NULL;
+	}
+	value->valuestr = (char*)(snapshot->base + entry->valueOffset);
+	return value;
+}
+
+/**
+ * Returns the number of key-value mappings in the snapshot.
+ *
+ * @param snapshot the snapshot
+ * @return the number of entries in the snapshot
+ */
+size_t getHashMapSnapshotSize(HashMapSnapshot* snapshot) {
+	return snapshot->header->size;
+}
@@ -0,0 +1,124 @@
+/*
+ * hash_map_snapshot.h
+ *
+ * This file provides the structures and function declarations of a
+ * HashMapSnapshot, which is a read-only copy of a HashMap in a file
+ * that is used in place through mmap. Opening a snapshot maps the file
+ * and checks its header; lookups then read the mapped table directly,
+ * with no rehashing or allocation per entry.
+ *
+ * The file holds a header, a table of chain start indexes, the entries
+ * grouped by chain, and the key and value strings. All positions are
+ * offsets from the start of the file, so it can be mapped at any
+ * address. Values are saved as their valuestr strings. Numbers are in
+ * the byte order of the machine that saved the snapshot. Opening checks
+ * the header and table bounds but not each entry, so snapshot files
+ * must come from a trusted source.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef HASH_MAP_SNAPSHOT_H_
+#define HASH_MAP_SNAPSHOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hash_map.h"
+
+/**
+ * The header at the start of a snapshot file.
+ */
+typedef struct {
+	char magic[8];						// identifies the file format
+	uint64_t seed;						// hash seed of the keys
+	uint64_t capacity;					// number of chains, a power of two
+	uint64_t size;						// number of entries
+	uint64_t tableOffset;				// offset of chain start indexes
+	uint64_t entriesOffset;				// offset of entries
+	uint64_t fileSize;					// size of the file
+} HashMapSnapshotHeader;
+
+/**
+ * An entry of a snapshot. The entries of a chain are adjacent.
+ */
+typedef struct {
+	uint64_t hashCode;					// hash code for the entry key
+	uint64_t keyOffset;					// offset of the key string
+	uint64_t valueOffset;				// offset of the value string, or 0
+										// for a NULL value
+	uint32_t keyLength;					// length of the key
+	uint32_t reserved;					// unused, 0
+} HashMapSnapshotEntry;
+
+/**
+ * An open snapshot.
+ */
+typedef struct {
+	const char* base;					// start of the mapped file
+	size_t length;						// length of the mapping
+	const HashMapSnapshotHeader* header;	// the header
+	const uint32_t* table;				// start index of each chain, and
+										// the number of entries at the end
+	const HashMapSnapshotEntry* entries;	// the entries
+} HashMapSnapshot;
+
+/**
+ * Saves a snapshot of a map to a file. The value of each entry is
+ * saved as its valuestr string.
+ *
+ * @param map the HashMap
+ * @param path the path of the file
+ * @return true if the snapshot was saved, false if the file could
+ *   not be written
+ */
+bool saveHashMapSnapshot(HashMap* map, const char* path);
+
+/**
+ * Opens a snapshot by mapping its file read-only.
+ *
+ * @param path the path of the file
+ * @return the snapshot, or NULL if the file could not be mapped or
+ *   is not a valid snapshot
+ */
+HashMapSnapshot* openHashMapSnapshot(const char* path);
+
+/**
+ * Closes a snapshot, and unmaps its file.
+ *
+ * @param snapshot the snapshot
+ */
+void closeHashMapSnapshot(HashMapSnapshot* snapshot);
+
+/**
+ * Returns true if the snapshot contains a mapping for the specified key.
+ *
+ * @param snapshot the snapshot
+ * @param key the entry key to check
+ * @return true if the snapshot contains the key, false otherwise
+ */
+bool containsHashMapSnapshotKey(HashMapSnapshot* snapshot, MapKey key);
+
+/**
+ * Gets the value to which the specified key is mapped. The valuestr
+ * of the value points into the mapped file, and is valid until the
+ * snapshot is closed.
+ *
+ * @param snapshot the snapshot
+ * @param key the entry key for the value to get
+ * @param value set to the value for the key
+ * @return value, or NULL if the snapshot contains no mapping for the
+ *   key or the key was mapped to NULL
+ */
+MapValue* getHashMapSnapshotValue(
+	HashMapSnapshot* snapshot, MapKey key, MapValue* value);
+
+/**
+ * Returns the number of key-value mappings in the snapshot.
+ *
+ * @param snapshot the snapshot
+ * @return the number of entries in the snapshot
+ */
+size_t getHashMapSnapshotSize(HashMapSnapshot* snapshot);
+
+#endif /* HASH_MAP_SNAPSHOT_H_ */
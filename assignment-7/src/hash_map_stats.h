@@ -0,0 +1,114 @@
+/*
+ * hash_map_stats.h
+ *
+ * This file provides the structure that reports statistics of a
+ * HashMap, and the counters that a HashMap keeps for them when it is
+ * built with HASH_MAP_STATS defined. Without HASH_MAP_STATS the
+ * counters and the code that updates them are compiled out, and only
+ * the statistics that are computed from the table on demand (the chain
+ * lengths and sizes) are reported.
+ *
+ * The counters are updated without atomics, so with HASH_MAP_STATS a
+ * map may be searched by several threads at once only through
+ * peekHashMapValue(), which does not count its search.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef HASH_MAP_STATS_H_
+#define HASH_MAP_STATS_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/** Number of chain lengths in the histogram; the last counts longer chains */
+#define HASH_MAP_STATS_CHAIN_LENGTHS 16
+
+/**
+ * Statistics of a HashMap. For the chained table a chain is the list of
+ * entries of a table entry, and a probe compares the hash code of one
+ * entry. For the open-addressed table a chain is the sequence of groups
+ * probed for an entry, and a probe reads one group of control bytes.
+ */
+typedef struct {
+	size_t size;						// number of entries
+	size_t capacity;					// size of the hash table
+	size_t chainLengths[HASH_MAP_STATS_CHAIN_LENGTHS];	// number of chains
+										// of each length; for the open-
+										// addressed table, number of
+										// entries found after each
+										// number of probes
+	size_t maxChainLength;				// length of the longest chain
+	size_t tableBytes;					// bytes of the chain heads, or of
+										// the control bytes
+	size_t entryBytes;					// bytes of the entry array, or of
+										// the slots
+	size_t filterBytes;					// bytes of the Bloom filter
+	size_t hitCount;					// searches that found their key *
+	size_t missCount;					// searches that did not *
+	double probesPerHit;				// average probes of a hit *
+	double probesPerMiss;				// average probes of a miss *
+	size_t resizeCount;					// number of table resizes *
+	double resizeMillis;				// time rehashing, in milliseconds *
+										// (* only with HASH_MAP_STATS)
+} HashMapStats;
+
+#ifdef HASH_MAP_STATS
+
+/**
+ * The counters that a HashMap keeps for its statistics.
+ */
+typedef struct {
+	size_t hitCount;					// searches that found their key
+	size_t missCount;					// searches that did not
+	size_t hitProbes;					// probes of all hits
+	size_t missProbes;					// probes of all misses
+	size_t resizeCount;					// number of table resizes
+	uint64_t resizeNanos;				// time rehashing, in nanoseconds
+} HashMapCounters;
+
+/**
+ * Returns the current time in nanoseconds.
+ *
+ * @return the current monotonic time in nanoseconds
+ */
+static inline uint64_t getHashMapStatsNanos(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Counts a search of the table that made nProbes probes */
+#define HASH_MAP_COUNT_SEARCH(map, isHit, nProbes)						\
+	do {																\
+		if (isHit) {													\
+			(map)->counters.hitCount++;									\
+			(map)->counters.hitProbes += (nProbes);						\
+		} else {														\
+			(map)->counters.missCount++;								\
+			(map)->counters.missProbes += (nProbes);					\
+		}																\
+	} while (0)
+
+/** Counts a resize of the table */
+#define HASH_MAP_COUNT_RESIZE(map) ((map)->counters.resizeCount++)
+
+/** Starts timing rehash work */
+#define HASH_MAP_START_TIMER(start) uint64_t start = getHashMapStatsNanos()
+
+/** Adds the time since start to the rehash time of the map */
+#define HASH_MAP_STOP_TIMER(map, start)									\
+	((map)->counters.resizeNanos += getHashMapStatsNanos() - (start))
+
+#else
+
+#define HASH_MAP_COUNT_SEARCH(map, isHit, nProbes) ((void)(nProbes))
+#define HASH_MAP_COUNT_RESIZE(map) ((void)0)
+#define HASH_MAP_START_TIMER(start)
+#define HASH_MAP_STOP_TIMER(map, start) ((void)0)
+
+#endif /* HASH_MAP_STATS */
+
+#endif /* HASH_MAP_STATS_H_ */
@@ -0,0 +1,281 @@
+/*
+ * hash_map_template.h
+ *
+ * This file provides macros that generate a HashMap for a key type other
+ * than MapKey. The generated map has the same layout as the chained
+ * HashMap: entries are kept in an array in the order they were added,
+ * and the hash table is an array of chains that link the entries by
+ * index. The key is stored in the entry, and the hash and equality
+ * functions are inlined into the lookups, so keys that are integers
+ * need no string storage, formatting or strcmp.
+ *
+ * DECLARE_HASH_MAP(name, KeyT) declares the types and functions of a
+ * map named name, for use in a header. DEFINE_HASH_MAP(name, KeyT,
+ * hashFn, eqFn) defines the functions in one source file, where
+ *
+ *   uint64_t hashFn(KeyT key, uint64_t seed) hashes a key, and
+ *   bool eqFn(KeyT key1, KeyT key2) returns true for equal keys.
+ *
+ * Unlike the chained HashMap, the table of a generated map is rehashed
+ * all at once when it grows.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef HASH_MAP_TEMPLATE_H_
+#define HASH_MAP_TEMPLATE_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "map_entry.h"
+
+#ifndef TEMPLATE_LOADING_FACTOR
+#define TEMPLATE_LOADING_FACTOR 0.75f
+#endif
+
+#ifndef TEMPLATE_CAPACITY
+#define TEMPLATE_CAPACITY 16
+#endif
+
+/** Index that marks the end of a hash chain of a generated map */
+#define TEMPLATE_NO_ENTRY ((uint32_t)-1)
+
+/** Chain index that marks a deleted entry of a generated map */
+#define TEMPLATE_DELETED_ENTRY ((uint32_t)-2)
+
+/**
+ * Declares the types and functions of a map with keys of type KeyT.
+ *
+ * @param name the name of the map type, e.g. UInt64HashMap
+ * @param KeyT the key type
+ */
+#define DECLARE_HASH_MAP(name, KeyT)										\
+																			\
+/** A key/value pair of the map */											\
+typedef struct {															\
+	KeyT key;							/* the key of the entry */			\
+	MapValue* value;					/* the entry value */				\
+} name##Entry;																\
+																			\
+/** Entry in the entry array, linked into a chain by index */				\
+typedef struct {															\
+	name##Entry entry;					/* entry key/value pair */			\
+	uint64_t hashCode;					/* hash code for the entry key */	\
+	uint32_t nextEntry;					/* index of next entry in chain */	\
+} name##ChainEntry;															\
+																			\
+/** The hash table */														\
+typedef struct {															\
+	uint32_t* hashTable;				/* first entry of each chain */		\
+	size_t capacity;					/* the size of the hash table */	\
+	size_t size;						/* number of entries in table */	\
+	float loadFactor;					/* % full before resizing table */	\
+	uint64_t seed;						/* hash seed for keys of this map */\
+	name##ChainEntry* entries;			/* entries in the order added */	\
+	size_t entryCount;					/* entries used, including deleted */\
+	size_t entryCapacity;				/* size of the entry array */		\
+} name;																		\
+																			\
+/** For-each callback; returns true to continue with the next entry */	\
+typedef bool (*name##ForEachCallback)(name##Entry*, void*);				\
+																			\
+name* create##name(void);													\
+void delete##name(name* map);												\
+void clear##name(name* map);												\
+void reserve##name(name* map, size_t nEntries);							\
+bool contains##name##Key(name* map, KeyT key);								\
+MapValue* get##name##Value(name* map, KeyT key);							\
+MapValue* put##name##Entry(name* map, KeyT key, MapValue* value);			\
+MapValue* delete##name##EntryForKey(name* map, KeyT key);					\
+bool forEach##name##Entry(name* map,										\
+	name##ForEachCallback callback, void* callbackData);					\
+size_t get##name##Size(name* map);
+
+/**
+ * Defines the functions of a map declared with DECLARE_HASH_MAP.
+ *
+ * @param name the name of the map type
+ * @param KeyT the key type
+ * @param hashFn the function or macro that hashes a key with a seed
+ * @param eqFn the function or macro that compares two keys for equality
+ */
+#define DEFINE_HASH_MAP(name, KeyT, hashFn, eqFn)							\
+																			\
+/* Allocates a hash table whose chains are all empty */					\
+static uint32_t* name##AllocTable(size_t capacity) {						\
+	uint32_t* table = (uint32_t*)malloc(capacity*sizeof(uint32_t));		\
+	for (size_t i = 0; i < capacity; i++) {									\
+		table[i] = TEMPLATE_NO_ENTRY;										\
+	}																		\
+	return table;															\
+}																			\
+																			\
+/* Finds the link to the chain entry for the key, or to the end of */	\
+/* its chain if the key is not in the map */								\
+static inline uint32_t* name##FindChainLink(								\
+	name* map, KeyT key, uint64_t hashCode) {								\
+	uint32_t* link = &map->hashTable[hashCode & (map->capacity-1)];		\
+	for ( ; *link != TEMPLATE_NO_ENTRY;										\
+		  link = &map->entries[*link].nextEntry) {							\
+		name##ChainEntry* chainEntry = &map->entries[*link];				\
+		if (chainEntry->hashCode == hashCode								\
+			&& eqFn(key, chainEntry->entry.key)) {							\
+			break;															\
+		}																	\
+	}																		\
+	return link;															\
+}																			\
+																			\
+/* Moves entries that follow deleted entries down in the entry array, */	\
+/* and links all the entries into a new table of the given capacity */	\
+static void name##Rehash(name* map, size_t newCapacity) {					\
+	free(map->hashTable);													\
+	map->hashTable = name##AllocTable(newCapacity);							\
+	map->capacity = newCapacity;											\
+	size_t count = 0;														\
+	for (size_t i = 0; i < map->entryCount; i++) {							\
+		if (map->entries[i].nextEntry != TEMPLATE_DELETED_ENTRY) {			\
+			name##ChainEntry* chainEntry = &map->entries[count];			\
+			*chainEntry = map->entries[i];									\
+			uint32_t* chain =												\
+				&map->hashTable[chainEntry->hashCode & (newCapacity-1)];	\
+			chainEntry->nextEntry = *chain;									\
+			*chain = count++;												\
+		}																	\
+	}																		\
+	map->entryCount = count;												\
+}																			\
+																			\
+name* create##name(void) {													\
+	name* map = (name*)malloc(sizeof(name));								\
+	map->capacity = TEMPLATE_CAPACITY;										\
+	map->size = 0;															\
+	map->loadFactor = TEMPLATE_LOADING_FACTOR;								\
+	map->seed = createMapEntryKeyHashSeed();								\
+	map->hashTable = name##AllocTable(map->capacity);						\
+	map->entries = (name##ChainEntry*)NULL;									\
+	map->entryCount = 0;													\
+	map->entryCapacity = 0;													\
+	return map;																\
+}																			\
+																			\
+void delete##name(name* map) {												\
+	free(map->hashTable);													\
+	free(map->entries);														\
+	free(map);																\
+}																			\
+																			\
+void clear##name(name* map) {												\
+	for (size_t i = 0; i < map->capacity; i++) {							\
+		map->hashTable[i] = TEMPLATE_NO_ENTRY;								\
+	}																		\
+	free(map->entries);														\
+	map->entries = (name##ChainEntry*)NULL;									\
+	map->entryCount = 0;													\
+	map->entryCapacity = 0;													\
+	map->size = 0;															\
+}																			\
+																			\
+void reserve##name(name* map, size_t nEntries) {							\
+	size_t capacity = map->capacity;										\
+	while (nEntries > capacity*map->loadFactor) {							\
+		capacity *= 2;														\
+	}																		\
+	if (capacity > map->capacity) {											\
+		name##Rehash(map, capacity);										\
+	}																		\
+	if (nEntries > map->entryCapacity) {									\
+		map->entries = (name##ChainEntry*)realloc(							\
+			map->entries, nEntries*sizeof(name##ChainEntry));				\
+		map->entryCapacity = nEntries;										\
+	}																		\
+}																			\
+																			\
+bool contains##name##Key(name* map, KeyT key) {								\
+	uint64_t hashCode = hashFn(key, map->seed);								\
+	return *name##FindChainLink(map, key, hashCode) != TEMPLATE_NO_ENTRY;	\
+}																			\
+																			\
+MapValue* get##name##Value(name* map, KeyT key) {							\
+	uint64_t hashCode = hashFn(key, map->seed);								\
+	uint32_t index = *name##FindChainLink(map, key, hashCode);				\
+	return (index == TEMPLATE_NO_ENTRY)										\
+		? (MapValue*)NULL : map->entries[index].entry.value;				\
+}																			\
+																			\
+MapValue* put##name##Entry(name* map, KeyT key, MapValue* value) {		\
+	uint64_t hashCode = hashFn(key, map->seed);								\
+	uint32_t* link = name##FindChainLink(map, key, hashCode);				\
+	if (*link != TEMPLATE_NO_ENTRY) {										\
+		MapValue* oldValue = map->entries[*link].entry.value;				\
+		map->entries[*link].entry.value = value;							\
+		return oldValue;													\
+	}																		\
+																			\
+	/* make room, removing deleted entries if half the array is deleted */	\
+	if (map->entryCount == map->entryCapacity) {							\
+		if (map->entryCount - map->size >= map->entryCount/2				\
+			&& map->size < map->entryCount) {								\
+			name##Rehash(map, map->capacity);								\
+		} else {															\
+			map->entryCapacity = (map->entryCapacity < 8)					\
+				? 8 : 2*map->entryCapacity;									\
+			map->entries = (name##ChainEntry*)realloc(						\
+				map->entries, map->entryCapacity*sizeof(name##ChainEntry));	\
+		}																	\
+	}																		\
+	if (++map->size > map->capacity*map->loadFactor) {						\
+		name##Rehash(map, 2*map->capacity);									\
+	}																		\
+																			\
+	/* splice entry to head of its chain */									\
+	uint32_t* chain = &map->hashTable[hashCode & (map->capacity-1)];		\
+	uint32_t index = map->entryCount++;										\
+	name##ChainEntry* chainEntry = &map->entries[index];					\
+	chainEntry->entry.key = key;											\
+	chainEntry->entry.value = value;										\
+	chainEntry->hashCode = hashCode;										\
+	chainEntry->nextEntry = *chain;											\
+	*chain = index;															\
+	return (MapValue*)NULL;													\
+}																			\
+																			\
+MapValue* delete##name##EntryForKey(name* map, KeyT key) {					\
+	uint64_t hashCode = hashFn(key, map->seed);								\
+	uint32_t* link = name##FindChainLink(map, key, hashCode);				\
+	if (*link == TEMPLATE_NO_ENTRY) {										\
+		return (MapValue*)NULL;												\
+	}																		\
+																			\
+	/* splice out entry from chain and mark it deleted */					\
+	name##ChainEntry* chainEntry = &map->entries[*link];					\
+	*link = chainEntry->nextEntry;											\
+	MapValue* value = chainEntry->entry.value;								\
+	chainEntry->entry.value = (MapValue*)NULL;								\
+	chainEntry->nextEntry = TEMPLATE_DELETED_ENTRY;							\
+	while (map->entryCount > 0 && map->entries[map->entryCount-1].nextEntry	\
+			== TEMPLATE_DELETED_ENTRY) {									\
+		map->entryCount--;													\
+	}																		\
+	map->size--;															\
+	return value;															\
+}																			\
+																			\
+bool forEach##name##Entry(name* map,										\
+	name##ForEachCallback callback, void* callbackData) {					\
+	for (size_t i = 0; i < map->entryCount; i++) {							\
+		if (map->entries[i].nextEntry != TEMPLATE_DELETED_ENTRY				\
+			&& !callback(&map->entries[i].entry, callbackData)) {			\
+			return false;													\
+		}																	\
+	}																		\
+	return true;															\
+}																			\
+																			\
+size_t get##name##Size(name* map) {											\
+	return map->size;														\
+}
+
+#endif /* HASH_MAP_TEMPLATE_H_ */
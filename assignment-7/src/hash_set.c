@@ -2,7 +2,7 @@
  * tree_set.h
  *
  * This file provides the implementations of a HashSet, which is
- * a Set that is backed by a HashMap.
+ * a Set of keys in a chained hash table.
  *
  * @since 2017-03-15
  * @author philip gust
@@ -12,14 +12,164 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
-#include <strings.h>
-#include "hash_map.h"
-#include "hash_set_iterator.h"
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#ifndef DEFAULT_LOADING_FACTOR
+#define DEFAULT_LOADING_FACTOR 0.75f
+#endif
+
+#ifndef DEFAULT_CAPACITY
+#define DEFAULT_CAPACITY 16
+#endif
+
+/** Index that marks the end of a hash chain */
+#define NO_ENTRY ((HashSetIndex)-1)
+
+/** Partitions per thread when building a set on several threads */
+#define BUILD_PARTITIONS_PER_THREAD 4
+
+/**
+ * Returns the hash code of a key. Entries store only its low 32 bits,
+ * but the Bloom filter uses all 64, so that keys whose stored hash
+ * codes are equal are still told apart by the filter.
+ *
+ * @param set the HashSet
+ * @param key the key
+ * @return the key hash code
+ */
+static inline uint64_t getHashSetKeyHashCode(HashSet* set, MapKey key) {
+	return getMapEntryKeyHashCode(key, set->seed);
+}
+
+/**
+ * Allocates a hash table whose chains are all empty.
+ *
+ * @param capacity the capacity of the table
+ * @return the table
+ */
+static HashSetIndex* allocHashSetTable(size_t capacity) {
+	HashSetIndex* table = (HashSetIndex*)malloc(capacity * sizeof(HashSetIndex));
+	memset(table, 0xff, capacity * sizeof(HashSetIndex));	// all NO_ENTRY
+	return table;
+}
+
+/**
+ * Returns the smallest table capacity that can hold the specified
+ * number of keys without being resized.
+ *
+ * @param set the HashSet
+ * @param nKeys the number of keys
+ * @return the capacity, a power of two >= DEFAULT_CAPACITY
+ */
+static size_t capacityForKeys(HashSet* set, size_t nKeys) {
+	size_t capacity = DEFAULT_CAPACITY;
+	while (nKeys > capacity*set->loadFactor) {
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+/**
+ * Finds the link to the entry for a key, or to the end of its chain if
+ * the key is not in the set.
+ *
+ * @param set the HashSet
+ * @param key the key
+ * @param hashCode the hash code of the key
+ * @return the link
+ */
+static HashSetIndex* findHashSetLink(HashSet* set, MapKey key, uint32_t hashCode) {
+	size_t nProbes = 0;
+	HashSetIndex* link = &set->hashTable[hashCode & (set->capacity-1)];
+	for ( ; *link != NO_ENTRY; link = &set->entries[*link].nextEntry) {
+		HashSetEntry* entry = &set->entries[*link];
+		nProbes++;
+		if (entry->hashCode == hashCode && strcmp(entry->key, key) == 0) {
+			break;
+		}
+	}
+	HASH_MAP_COUNT_SEARCH(set, *link != NO_ENTRY, nProbes);
+	return link;
+}
+
+/**
+ * Returns true if the set keeps a Bloom filter that shows that no key
+ * with the hash code is in the set.
+ *
+ * @param set the HashSet
+ * @param hashCode the hash code of the key
+ * @return true if the key is not in the set, false if it may be
+ */
+static inline bool isBloomFilterMiss(HashSet* set, uint64_t hashCode) {
+	return set->bloomFilter != (BloomFilter*)NULL
+		&& !mayContainBloomFilterHashCode(set->bloomFilter, hashCode);
+}
+
+/**
+ * Moves the entries that follow deleted entries down in the entry
+ * array, and links all the entries into a new table of the specified
+ * capacity, using their stored hash codes.
+ *
+ * @param set the HashSet
+ * @param newCapacity the capacity of the new table
+ */
+static void rehashHashSet(HashSet* set, size_t newCapacity) {
+	HASH_MAP_START_TIMER(start);
+	if (newCapacity != set->capacity) {
+		HASH_MAP_COUNT_RESIZE(set);
+	}
+	free(set->hashTable);
+	set->hashTable = allocHashSetTable(newCapacity);
+	set->capacity = newCapacity;
+	size_t count = 0;
+	for (size_t i = 0; i < set->entryCount; i++) {
+		if (set->entries[i].key != (MapKey)NULL) {
+			HashSetEntry* entry = &set->entries[count];
+			*entry = set->entries[i];
+			HashSetIndex* chain = &set->hashTable[entry->hashCode & (newCapacity-1)];
+			entry->nextEntry = *chain;
+			*chain = count++;
+		}
+	}
+	set->entryCount = count;
+	rebuildHashSetBloomFilter(set);
+	HASH_MAP_STOP_TIMER(set, start);
+}
 
 /**
- * The value assigned to all MapEntry value fields
+ * Resizes the entry array.
+ *
+ * @param set the HashSet
+ * @param newCapacity the new number of entries
  */
-static MapValue* ENTRY_VALUE = &(MapValue){};
+static void resizeHashSetEntries(HashSet* set, size_t newCapacity) {
+	set->entries = (HashSetEntry*)realloc(set->entries, newCapacity * sizeof(HashSetEntry));
+	set->entryCapacity = newCapacity;
+}
+
+/**
+ * Removes the entry that a chain link points to from the set. The
+ * entry is marked deleted in the entry array, and dropped from the
+ * array if it is the last one.
+ *
+ * @param set the HashSet
+ * @param link the link to the entry
+ */
+static void removeHashSetEntry(HashSet* set, HashSetIndex* link) {
+	HashSetEntry* entry = &set->entries[*link];
+	*link = entry->nextEntry;
+	if (set->sortedKeys != (SortedKeyView*)NULL) {
+		addSortedKeyViewChange(set->sortedKeys, entry->key, false);
+	}
+	entry->key = (MapKey)NULL;
+	entry->nextEntry = NO_ENTRY;
+	while (set->entryCount > 0 && set->entries[set->entryCount-1].key == (MapKey)NULL) {
+		set->entryCount--;
+	}
+	set->size--;
+}
 
 /**
  * Create new empty HashSet.
@@ -27,8 +177,300 @@ static MapValue* ENTRY_VALUE = &(MapValue){};
  * @return a new HashSet
  */
 HashSet* createHashSet(void) {
+	return createHashSetWithCapacity(0);
+}
+
+/**
+ * Create new empty HashSet that can hold the specified number of keys
+ * without being resized.
+ *
+ * @param nKeys the expected number of keys
+ * @return a new HashSet
+ */
+HashSet* createHashSetWithCapacity(size_t nKeys) {
 	HashSet *set = (HashSet *) malloc(sizeof(HashSet));
-	set->map     = createHashMap();
+	set->loadFactor = DEFAULT_LOADING_FACTOR;
+	set->capacity = capacityForKeys(set, nKeys);
+	set->hashTable = allocHashSetTable(set->capacity);
+	set->size = 0;
+	set->seed = createMapEntryKeyHashSeed();
+	set->entries = (HashSetEntry*)NULL;
+	set->entryCount = 0;
+	set->entryCapacity = 0;
+	set->bloomFilter = (BloomFilter*)NULL;
+	set->sortedKeys = (SortedKeyView*)NULL;
+#ifdef HASH_MAP_STATS
+	memset(&set->counters, 0, sizeof(HashMapCounters));
+#endif
+	if (nKeys > 0) {
+		resizeHashSetEntries(set, nKeys);
+	}
+	return set;
+}
+
+/**
+ * State shared by the threads that build a set from an array of keys.
+ */
+typedef struct {
+	HashSet* set;						// the set being built
+	MapKey* keys;						// the keys
+	size_t nKeys;						// number of keys
+	int nThreads;						// number of threads
+	size_t nParts;						// number of partitions
+	unsigned partShift;					// table index bits below partition
+	uint32_t* hashCodes;				// hash code of each key
+	size_t* partCounts;					// keys of each thread in each
+										// partition, then where the
+										// thread copies its next key
+	HashSetEntry* buffer;				// the keys grouped by partition
+	size_t* partStarts;					// first key of each partition
+	size_t* partSizes;					// distinct keys of each partition
+	size_t* partOffsets;				// first entry of each partition
+	atomic_size_t nextPart;				// next partition to process
+} HashSetBuild;
+
+/**
+ * A thread that builds a set, and the step of the build it performs.
+ */
+typedef struct {
+	HashSetBuild* build;				// the build
+	int thread;							// index of this thread
+	void (*step)(HashSetBuild*, int);	// the step
+} HashSetBuildThread;
+
+/**
+ * Returns the partition of the table entry for a hash code.
+ *
+ * @param build the build
+ * @param hashCode the hash code
+ * @return the partition
+ */
+static inline size_t getBuildPartition(HashSetBuild* build, uint32_t hashCode) {
+	return (hashCode & (build->set->capacity-1)) >> build->partShift;
+}
+
+/**
+ * Build step that hashes the keys in one share of the array, and
+ * counts the keys of the share in each partition.
+ *
+ * @param build the build
+ * @param thread the thread whose share to hash
+ */
+static void hashBuildKeys(HashSetBuild* build, int thread) {
+	size_t end = build->nKeys * (thread+1) / build->nThreads;
+	size_t* counts = &build->partCounts[thread * build->nParts];
+	for (size_t i = build->nKeys * thread / build->nThreads; i < end; i++) {
+		uint32_t hashCode = (uint32_t)getHashSetKeyHashCode(build->set, build->keys[i]);
+		build->hashCodes[i] = hashCode;
+		counts[getBuildPartition(build, hashCode)]++;
+	}
+}
+
+/**
+ * Build step that copies the keys in one share of the array into the
+ * buffer, grouped by partition. The keys of each partition are copied
+ * in array order, since each thread's share follows the last thread's.
+ *
+ * @param build the build
+ * @param thread the thread whose share to copy
+ */
+static void scatterBuildKeys(HashSetBuild* build, int thread) {
+	size_t end = build->nKeys * (thread+1) / build->nThreads;
+	size_t* next = &build->partCounts[thread * build->nParts];
+	for (size_t i = build->nKeys * thread / build->nThreads; i < end; i++) {
+		uint32_t hashCode = build->hashCodes[i];
+		HashSetEntry* entry = &build->buffer[next[getBuildPartition(build, hashCode)]++];
+		entry->key = build->keys[i];
+		entry->hashCode = hashCode;
+		entry->nextEntry = NO_ENTRY;
+	}
+}
+
+/**
+ * Build step that links the keys of partitions into the chains of
+ * their table entries, moving each distinct key down over duplicates.
+ * The chains of a partition hold only its keys, so the threads take
+ * whole partitions in turn.
+ *
+ * @param build the build
+ * @param thread the index of this thread
+ */
+static void linkBuildKeys(HashSetBuild* build, int thread) {
+	HashSet* set = build->set;
+	size_t part;
+	while ((part = atomic_fetch_add(&build->nextPart, 1)) < build->nParts) {
+		size_t count = build->partStarts[part];
+		for (size_t i = count; i < build->partStarts[part+1]; i++) {
+			HashSetEntry* entry = &build->buffer[i];
+			HashSetIndex* chain = &set->hashTable[entry->hashCode & (set->capacity-1)];
+			HashSetIndex index = *chain;
+			while (index != NO_ENTRY
+				   && (build->buffer[index].hashCode != entry->hashCode
+					   || strcmp(build->buffer[index].key, entry->key) != 0)) {
+				index = build->buffer[index].nextEntry;
+			}
+			if (index == NO_ENTRY) {
+				build->buffer[count] = *entry;
+				build->buffer[count].nextEntry = *chain;
+				*chain = count++;
+			}
+		}
+		build->partSizes[part] = count - build->partStarts[part];
+	}
+}
+
+/**
+ * Build step that copies the distinct keys of partitions from the
+ * buffer to the entry array of the set, and moves their links down by
+ * the distance they moved.
+ *
+ * @param build the build
+ * @param thread the index of this thread
+ */
+static void moveBuildKeys(HashSetBuild* build, int thread) {
+	HashSet* set = build->set;
+	size_t tableSlice = set->capacity / build->nParts;
+	size_t part;
+	while ((part = atomic_fetch_add(&build->nextPart, 1)) < build->nParts) {
+		HashSetIndex shift = build->partStarts[part] - build->partOffsets[part];
+		HashSetEntry* entries = &set->entries[build->partOffsets[part]];
+		memcpy(entries, &build->buffer[build->partStarts[part]],
+			   build->partSizes[part] * sizeof(HashSetEntry));
+		for (size_t i = 0; i < build->partSizes[part]; i++) {
+			if (entries[i].nextEntry != NO_ENTRY) {
+				entries[i].nextEntry -= shift;
+			}
+		}
+		HashSetIndex* chains = &set->hashTable[part * tableSlice];
+		for (size_t i = 0; i < tableSlice; i++) {
+			if (chains[i] != NO_ENTRY) {
+				chains[i] -= shift;
+			}
+		}
+	}
+}
+
+/**
+ * Runs the step of a build thread.
+ *
+ * @param arg the HashSetBuildThread
+ * @return NULL
+ */
+static void* runBuildThread(void* arg) {
+	HashSetBuildThread* thread = (HashSetBuildThread*)arg;
+	thread->step(thread->build, thread->thread);
+	return NULL;
+}
+
+/**
+ * Runs a step of a build on each of its threads, including this one,
+ * and waits for them all to finish. The share of a thread that cannot
+ * be started is run on this thread instead.
+ *
+ * @param build the build
+ * @param step the step
+ */
+static void runBuildStep(HashSetBuild* build, void (*step)(HashSetBuild*, int)) {
+	pthread_t threads[build->nThreads];
+	HashSetBuildThread args[build->nThreads];
+	bool isStarted[build->nThreads];
+	atomic_store(&build->nextPart, 0);
+	for (int t = 1; t < build->nThreads; t++) {
+		args[t] = (HashSetBuildThread){ build, t, step };
+		isStarted[t] = (pthread_create(&threads[t], NULL, runBuildThread, &args[t]) == 0);
+		if (!isStarted[t]) {
+			step(build, t);
+		}
+	}
+	step(build, 0);
+	for (int t = 1; t < build->nThreads; t++) {
+		if (isStarted[t]) {
+			pthread_join(threads[t], NULL);
+		}
+	}
+}
+
+/**
+ * Create new HashSet of the keys in an array, using several threads.
+ * The set keeps the first of each group of equal keys. Its keys are
+ * visited by forEachHashSetKey() in the order of their partitions, and
+ * in the order of the array within a partition, rather than in the
+ * order of the array.
+ *
+ * @param keys the keys, which may contain duplicates
+ * @param nKeys the number of keys, less than 2^32-1
+ * @param nThreads the number of threads to use, at least 1
+ * @return a new HashSet of the keys
+ */
+HashSet* createHashSetFromKeys(MapKey* keys, size_t nKeys, int nThreads) {
+	HashSet* set = createHashSetWithCapacity(0);
+	free(set->hashTable);
+	set->capacity = capacityForKeys(set, nKeys);
+	set->hashTable = allocHashSetTable(set->capacity);
+
+	HashSetBuild build;
+	build.set = set;
+	build.keys = keys;
+	build.nKeys = nKeys;
+	build.nThreads = (nThreads < 1) ? 1 : nThreads;
+	build.nParts = 1;
+	build.partShift = 0;
+	while (   build.nParts < (size_t)build.nThreads * BUILD_PARTITIONS_PER_THREAD
+		   && build.nParts < set->capacity) {
+		build.nParts *= 2;
+	}
+	while (((size_t)1 << build.partShift) * build.nParts < set->capacity) {
+		build.partShift++;
+	}
+	build.hashCodes = (uint32_t*)malloc(nKeys * sizeof(uint32_t));
+	build.partCounts = (size_t*)calloc(build.nThreads * build.nParts, sizeof(size_t));
+	build.buffer = (HashSetEntry*)malloc(nKeys * sizeof(HashSetEntry));
+	build.partStarts = (size_t*)malloc((build.nParts+1) * sizeof(size_t));
+	build.partSizes = (size_t*)malloc(build.nParts * sizeof(size_t));
+	build.partOffsets = (size_t*)malloc(build.nParts * sizeof(size_t));
+
+	// hash the keys, and find where each thread copies the keys of each
+	// partition so that the keys of a partition stay in array order
+	runBuildStep(&build, hashBuildKeys);
+	size_t start = 0;
+	for (size_t p = 0; p < build.nParts; p++) {
+		build.partStarts[p] = start;
+		for (int t = 0; t < build.nThreads; t++) {
+			size_t count = build.partCounts[t * build.nParts + p];
+			build.partCounts[t * build.nParts + p] = start;
+			start += count;
+		}
+	}
+	build.partStarts[build.nParts] = start;
+	runBuildStep(&build, scatterBuildKeys);
+	runBuildStep(&build, linkBuildKeys);
+
+	// the distinct keys become the entries; the buffer is already the
+	// entry array if there were no duplicates
+	for (size_t p = 0; p < build.nParts; p++) {
+		build.partOffsets[p] = set->size;
+		set->size += build.partSizes[p];
+	}
+	if (set->size == nKeys) {
+		set->entries = build.buffer;
+		set->entryCapacity = nKeys;
+	} else {
+		resizeHashSetEntries(set, set->size);
+		runBuildStep(&build, moveBuildKeys);
+		free(build.buffer);
+	}
+	set->entryCount = set->size;
+
+	// shrink a table that was sized for duplicates, from the stored hash codes
+	if (capacityForKeys(set, set->size) < set->capacity) {
+		rehashHashSet(set, capacityForKeys(set, set->size));
+	}
+
+	free(build.partOffsets);
+	free(build.partSizes);
+	free(build.partStarts);
+	free(build.partCounts);
+	free(build.hashCodes);
 	return set;
 }
 
@@ -38,8 +480,14 @@ HashSet* createHashSet(void) {
  * @param set the HashSet to free
  */
 void deleteHashSet(HashSet* set) {
-	clearHashSet(set);
-	deleteHashMap(set->map);
+	if (set->bloomFilter != (BloomFilter*)NULL) {
+		deleteBloomFilter(set->bloomFilter);
+	}
+	if (set->sortedKeys != (SortedKeyView*)NULL) {
+		deleteSortedKeyView(set->sortedKeys);
+	}
+	free(set->hashTable);
+	free(set->entries);
 	free(set);
 }
 
@@ -49,7 +497,13 @@ void deleteHashSet(HashSet* set) {
  * @param set the HashSet
  */
 void clearHashSet(HashSet* set) {
-	clearHashMap(set->map);
+	memset(set->hashTable, 0xff, set->capacity * sizeof(HashSetIndex));
+	set->entryCount = 0;
+	set->size = 0;
+	rebuildHashSetBloomFilter(set);
+	if (set->sortedKeys != (SortedKeyView*)NULL) {
+		clearSortedKeyView(set->sortedKeys);
+	}
 }
 
 /**
@@ -60,7 +514,182 @@ void clearHashSet(HashSet* set) {
  * @return true if the key was added, false otherwise
  */
 bool addHashSetKey(HashSet* set, MapKey key) {
-	return putHashMapEntry(set->map, key, ENTRY_VALUE) == NULL;
+	uint64_t hashCode = getHashSetKeyHashCode(set, key);
+	if (   !isBloomFilterMiss(set, hashCode)
+		&& *findHashSetLink(set, key, (uint32_t)hashCode) != NO_ENTRY) {
+		return false;
+	}
+
+	// make room, removing deleted entries if a quarter of the array is deleted
+	if (set->entryCount == set->entryCapacity) {
+		if (set->size < set->entryCount && set->entryCount - set->size >= set->entryCount/4) {
+			rehashHashSet(set, set->capacity);
+		} else {
+			resizeHashSetEntries(set, (set->entryCapacity < 8) ? 8 : 2*set->entryCapacity);
+		}
+	}
+	if (++set->size > set->capacity*set->loadFactor) {
+		rehashHashSet(set, 2*set->capacity);
+	}
+
+	// splice entry to head of its chain
+	HashSetIndex* chain = &set->hashTable[hashCode & (set->capacity-1)];
+	HashSetIndex index = set->entryCount++;
+	HashSetEntry* entry = &set->entries[index];
+	entry->key = key;
+	entry->hashCode = (uint32_t)hashCode;
+	entry->nextEntry = *chain;
+	*chain = index;
+	if (set->bloomFilter != (BloomFilter*)NULL) {
+		addBloomFilterHashCode(set->bloomFilter, hashCode);
+	}
+	if (set->sortedKeys != (SortedKeyView*)NULL) {
+		addSortedKeyViewChange(set->sortedKeys, key, true);
+	}
+	return true;
+}
+
+/**
+ * Data for the callbacks of the set operations.
+ */
+typedef struct {
+	HashSet* set;						// the set to change
+	HashSet* otherSet;					// the set to check keys against
+	size_t count;						// number of keys changed
+} SetOperationData;
+
+/**
+ * For-each callback that adds a key to a set.
+ *
+ * @param key the key of the other set
+ * @param data the SetOperationData
+ * @return true to continue with the next entry
+ */
+static bool addKeyCallback(MapKey key, HashSetForEachData data) {
+	SetOperationData* op = (SetOperationData*)data;
+	op->count += addHashSetKey(op->set, key);
+	return true;
+}
+
+/**
+ * For-each callback that adds a key to a set if it is
+ * in the other set.
+ *
+ * @param key the key
+ * @param data the SetOperationData
+ * @return true to continue with the next entry
+ */
+static bool addSharedKeyCallback(MapKey key, HashSetForEachData data) {
+	SetOperationData* op = (SetOperationData*)data;
+	if (containsHashSetKey(op->otherSet, key)) {
+		op->count += addHashSetKey(op->set, key);
+	}
+	return true;
+}
+
+/**
+ * For-each callback that adds a key to a set if it is
+ * not in the other set.
+ *
+ * @param key the key
+ * @param data the SetOperationData
+ * @return true to continue with the next entry
+ */
+static bool addUnsharedKeyCallback(MapKey key, HashSetForEachData data) {
+	SetOperationData* op = (SetOperationData*)data;
+	if (!containsHashSetKey(op->otherSet, key)) {
+		op->count += addHashSetKey(op->set, key);
+	}
+	return true;
+}
+
+/**
+ * Orders two sets by size.
+ *
+ * @param set the first HashSet
+ * @param otherSet the second HashSet
+ * @param smaller set to the smaller set
+ * @param larger set to the larger set
+ */
+static void orderHashSetsBySize(HashSet* set, HashSet* otherSet,
+	HashSet** smaller, HashSet** larger) {
+	if (getHashSetSize(set) <= getHashSetSize(otherSet)) {
+		*smaller = set;
+		*larger = otherSet;
+	} else {
+		*smaller = otherSet;
+		*larger = set;
+	}
+}
+
+/**
+ * Create new HashSet of the keys that are in either of two sets.
+ *
+ * @param set the first HashSet
+ * @param otherSet the second HashSet
+ * @return a new HashSet of the union of the sets
+ */
+HashSet* createHashSetUnion(HashSet* set, HashSet* otherSet) {
+	HashSet* smaller, *larger;
+	orderHashSetsBySize(set, otherSet, &smaller, &larger);
+	SetOperationData op = {
+		createHashSetWithCapacity(getHashSetSize(larger) + getHashSetSize(smaller)),
+		(HashSet*)NULL, 0
+	};
+	forEachHashSetKey(larger, addKeyCallback, &op);
+	forEachHashSetKey(smaller, addKeyCallback, &op);
+	return op.set;
+}
+
+/**
+ * Create new HashSet of the keys that are in both of two sets. Takes
+ * time proportional to the smaller set.
+ *
+ * @param set the first HashSet
+ * @param otherSet the second HashSet
+ * @return a new HashSet of the intersection of the sets
+ */
+HashSet* createHashSetIntersection(HashSet* set, HashSet* otherSet) {
+	HashSet* smaller, *larger;
+	orderHashSetsBySize(set, otherSet, &smaller, &larger);
+	SetOperationData op = {
+		createHashSetWithCapacity(getHashSetSize(smaller)), larger, 0
+	};
+	forEachHashSetKey(smaller, addSharedKeyCallback, &op);
+	return op.set;
+}
+
+/**
+ * Create new HashSet of the keys of a set that are not in another set.
+ *
+ * @param set the HashSet
+ * @param otherSet the HashSet of keys to leave out
+ * @return a new HashSet of the difference of the sets
+ */
+HashSet* createHashSetDifference(HashSet* set, HashSet* otherSet) {
+	SetOperationData op = {
+		createHashSetWithCapacity(getHashSetSize(set)), otherSet, 0
+	};
+	forEachHashSetKey(set, addUnsharedKeyCallback, &op);
+	return op.set;
+}
+
+/**
+ * Create new HashSet of the keys that are in exactly one of two sets.
+ *
+ * @param set the first HashSet
+ * @param otherSet the second HashSet
+ * @return a new HashSet of the symmetric difference of the sets
+ */
+HashSet* createHashSetSymmetricDifference(HashSet* set, HashSet* otherSet) {
+	SetOperationData op = {
+		createHashSetWithCapacity(getHashSetSize(set) + getHashSetSize(otherSet)),
+		otherSet, 0
+	};
+	forEachHashSetKey(set, addUnsharedKeyCallback, &op);
+	op.otherSet = set;
+	forEachHashSetKey(otherSet, addUnsharedKeyCallback, &op);
+	return op.set;
 }
 
 /**
@@ -71,12 +700,12 @@ bool addHashSetKey(HashSet* set, MapKey key) {
  * @return true if the set was modified as a result of this call
  */
 bool addAllHashSetKeys(HashSet* set, HashSet* otherSet) {
-	size_t otherSetSize   = getHashMapSize(otherSet->map);
-	MapKey **otherSetKeys = getHashMapKeys(otherSet->map);
-	for (int i = 0; i < otherSetSize; i++)
-		if (!addHashSetKey(set, *otherSetKeys[i]))
-			return false;
-	return true;
+	if (set == otherSet) {
+		return false;
+	}
+	SetOperationData op = { set, (HashSet*)NULL, 0 };
+	forEachHashSetKey(otherSet, addKeyCallback, &op);
+	return op.count > 0;
 }
 
 /**
@@ -87,26 +716,57 @@ bool addAllHashSetKeys(HashSet* set, HashSet* otherSet) {
  * @return true if the set contains the key, false otherwise
  */
 bool containsHashSetKey(HashSet* set, MapKey key) {
-	return containsHashMapKey(set->map, key);
+	uint64_t hashCode = getHashSetKeyHashCode(set, key);
+	return !isBloomFilterMiss(set, hashCode)
+		&& *findHashSetLink(set, key, (uint32_t)hashCode) != NO_ENTRY;
+}
+
+/**
+ * Calls the callback for each key in the set until the callback
+ * returns false. The callback must not add or delete keys.
+ *
+ * @param set the HashSet
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all keys were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachHashSetKey(HashSet* set,
+	HashSetForEachCallback callback, HashSetForEachData callbackData) {
+	for (size_t i = 0; i < set->entryCount; i++) {
+		if (   set->entries[i].key != (MapKey)NULL
+			&& !callback(set->entries[i].key, callbackData)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * For-each callback that checks whether a key is in a set.
+ *
+ * @param key the key of the other set
+ * @param set the HashSet to check
+ * @return true to continue if the set contains the key, false to stop
+ */
+static bool containsKeyCallback(MapKey key, HashSetForEachData set) {
+	return containsHashSetKey((HashSet*)set, key);
 }
 
 /**
  * Returns true if this set contains all the keys from the other set.
+ * Takes time proportional to the other set, or none if it is larger.
  *
  * @param set the HashSet
- * @param key the entry key to check
+ * @param otherSet the other HashSet
  * @return true if the set contains all the keys, false otherwise
  */
 bool containsAllHashSetKeys(HashSet* set, HashSet* otherSet) {
-	size_t setSize        = getHashMapSize(set->map);
-	size_t otherSetSize   = getHashMapSize(otherSet->map);
-	if (setSize != otherSetSize) return false;
-	MapKey **setKeys      = getHashMapKeys(set->map);
-	MapKey **otherSetKeys = getHashMapKeys(otherSet->map);
-	for (int i = 0; i < setSize; i++)
-		if (compareMapKey(*setKeys[i], *otherSetKeys[i]) != 0)
-			return false;
-	return true;
+	if (getHashSetSize(otherSet) > getHashSetSize(set)) {
+		return false;
+	}
+	return set == otherSet
+		|| forEachHashSetKey(otherSet, containsKeyCallback, set);
 }
 
 /**
@@ -116,7 +776,7 @@ bool containsAllHashSetKeys(HashSet* set, HashSet* otherSet) {
  * @return the size of the HashSet
  */
 size_t getHashSetSize(HashSet* set) {
-	return getHashMapSize(set->map);
+	return set->size;
 }
 
 /**
@@ -126,7 +786,7 @@ size_t getHashSetSize(HashSet* set) {
  * @return true of the set is entry, false otherwise
  */
 bool isHashSetEmpty(HashSet* set) {
-	return isHashMapEmpty(set->map);
+	return set->size == 0;
 }
 
 /**
@@ -137,40 +797,245 @@ bool isHashSetEmpty(HashSet* set) {
  * @return true if the key was removed, false otherwise
  */
 bool deleteHashSetKey(HashSet* set, MapKey key) {
-	return deleteHashMapEntryForKey(set->map, key) != NULL;
+	uint64_t hashCode = getHashSetKeyHashCode(set, key);
+	if (isBloomFilterMiss(set, hashCode)) {
+		return false;
+	}
+	HashSetIndex* link = findHashSetLink(set, key, (uint32_t)hashCode);
+	if (*link == NO_ENTRY) {
+		return false;
+	}
+	removeHashSetEntry(set, link);
+	return true;
+}
+
+/**
+ * Removes each key of this set for which the callback returns true.
+ * The callback must not add or delete keys itself. Entries are visited
+ * in the entry array and unlinked from their chains by index, so no
+ * key is hashed or compared.
+ *
+ * @param set the HashSet
+ * @param callback returns true for a key to remove
+ * @param callbackData the callback data
+ * @return the number of keys removed
+ */
+size_t deleteHashSetKeysIf(HashSet* set,
+	HashSetForEachCallback callback, HashSetForEachData callbackData) {
+	size_t nDeleted = 0;
+	for (size_t i = 0; i < set->entryCount; i++) {
+		HashSetEntry* entry = &set->entries[i];
+		if (entry->key != (MapKey)NULL && callback(entry->key, callbackData)) {
+			HashSetIndex* link = &set->hashTable[entry->hashCode & (set->capacity-1)];
+			while (*link != i) {
+				link = &set->entries[*link].nextEntry;
+			}
+			removeHashSetEntry(set, link);
+			nDeleted++;
+		}
+	}
+	return nDeleted;
+}
+
+/**
+ * For-each callback that deletes a key from a set.
+ *
+ * @param key the key of the other set
+ * @param data the SetOperationData
+ * @return true to continue with the next entry
+ */
+static bool deleteKeyCallback(MapKey key, HashSetForEachData data) {
+	SetOperationData* op = (SetOperationData*)data;
+	op->count += deleteHashSetKey(op->set, key);
+	return true;
+}
+
+/**
+ * Delete-if callback that selects the keys that are in a set.
+ *
+ * @param key the key
+ * @param set the HashSet to check
+ * @return true to delete the key
+ */
+static bool isSharedKeyCallback(MapKey key, HashSetForEachData set) {
+	return containsHashSetKey((HashSet*)set, key);
+}
+
+/**
+ * Delete-if callback that selects the keys that are not in a set.
+ *
+ * @param key the key
+ * @param set the HashSet to check
+ * @return true to delete the key
+ */
+static bool isUnsharedKeyCallback(MapKey key, HashSetForEachData set) {
+	return !containsHashSetKey((HashSet*)set, key);
 }
 
 /**
  * Removes all elements from this set that are present in the other set.
+ * Takes time proportional to the smaller set.
  *
  * @param set the HashSet
- * @param key the entry key to check
+ * @param otherSet the other HashSet
  * @return true if the set changed as a result of this call
  */
 bool deleteAllHashSetKeys(HashSet* set, HashSet* otherSet) {
-	size_t otherSetSize   = getHashMapSize(otherSet->map);
-	MapKey **otherSetKeys = getHashMapKeys(otherSet->map);
-	for (int i = 0; i < otherSetSize; i++)
-		if (containsHashMapKey(set->map, *otherSetKeys[i]))
-			deleteHashSetKey(set, *otherSetKeys[i]);
-	return true;
+	if (set == otherSet) {
+		bool changed = !isHashSetEmpty(set);
+		clearHashSet(set);
+		return changed;
+	}
+	if (getHashSetSize(otherSet) <= getHashSetSize(set)) {
+		SetOperationData op = { set, (HashSet*)NULL, 0 };
+		forEachHashSetKey(otherSet, deleteKeyCallback, &op);
+		return op.count > 0;
+	}
+	return deleteHashSetKeysIf(set, isSharedKeyCallback, otherSet) > 0;
 }
 
 /**
  * Retains only the elements in this set that are present in the other set.
+ * Takes time proportional to this set, since it may remove any of its keys.
  *
  * @param set the HashSet
- * @param key the entry key to check
+ * @param otherSet the other HashSet
  * @return true if the set changed as a result of this call
  */
 bool retainAllHashSetKeys(HashSet* set, HashSet* otherSet) {
-	HashSet *deleteSet = createHashSet();
-	size_t otherSetSize   = getHashMapSize(otherSet->map);
-	if (otherSetSize == 0) return true;
-	MapKey **otherSetKeys = getHashMapKeys(otherSet->map);
-	for (int i = 0; i < otherSetSize; i++) {
-		if (!containsHashSetKey(set, *otherSetKeys[i]))
-			addHashSetKey(set, *otherSetKeys[i]);
-	}
-	return deleteAllHashSetKeys(set, deleteSet);
+	if (set == otherSet) {
+		return false;
+	}
+	return deleteHashSetKeysIf(set, isUnsharedKeyCallback, otherSet) > 0;
+}
+
+/**
+ * For-each callback that deletes a key from a set if it is present,
+ * and adds it otherwise.
+ *
+ * @param key the key of the other set
+ * @param data the SetOperationData
+ * @return true to continue with the next entry
+ */
+static bool toggleKeyCallback(MapKey key, HashSetForEachData data) {
+	SetOperationData* op = (SetOperationData*)data;
+	if (!deleteHashSetKey(op->set, key)) {
+		addHashSetKey(op->set, key);
+	}
+	op->count++;
+	return true;
+}
+
+/**
+ * Removes the elements of this set that are present in the other set,
+ * and adds the elements of the other set that were not present, which
+ * leaves the symmetric difference of the sets in this set.
+ *
+ * @param set the HashSet
+ * @param otherSet the other HashSet
+ * @return true if the set changed as a result of this call
+ */
+bool toggleAllHashSetKeys(HashSet* set, HashSet* otherSet) {
+	if (set == otherSet) {
+		return deleteAllHashSetKeys(set, otherSet);
+	}
+	SetOperationData op = { set, (HashSet*)NULL, 0 };
+	forEachHashSetKey(otherSet, toggleKeyCallback, &op);
+	return op.count > 0;
+}
+
+/**
+ * Resizes the table if necessary so that the set can hold the specified
+ * number of keys without being resized again.
+ *
+ * @param set the HashSet
+ * @param nKeys the number of keys to make room for
+ */
+void reserveHashSet(HashSet* set, size_t nKeys) {
+	size_t capacity = capacityForKeys(set, nKeys);
+	if (capacity > set->capacity) {
+		rehashHashSet(set, capacity);
+	}
+	if (nKeys > set->entryCapacity) {
+		resizeHashSetEntries(set, nKeys);
+	}
+}
+
+/**
+ * Keeps a Bloom filter of the keys of this set, so that most checks
+ * for keys that are not in the set skip searching its table. Deleted
+ * keys stay in the filter until rebuildHashSetBloomFilter() is called.
+ *
+ * @param set the HashSet
+ */
+void enableHashSetBloomFilter(HashSet* set) {
+	if (set->bloomFilter == (BloomFilter*)NULL) {
+		set->bloomFilter = createBloomFilter(set->capacity*set->loadFactor);
+		rebuildHashSetBloomFilter(set);
+	}
+}
+
+/**
+ * Rebuilds the Bloom filter of this set from its current keys, which
+ * removes deleted keys from the filter. Does nothing if the set does
+ * not keep a filter. The keys are hashed again, since the filter uses
+ * more bits of their hash codes than the entries store.
+ *
+ * @param set the HashSet
+ */
+void rebuildHashSetBloomFilter(HashSet* set) {
+	if (set->bloomFilter != (BloomFilter*)NULL) {
+		resetBloomFilter(set->bloomFilter, set->capacity*set->loadFactor);
+		for (size_t i = 0; i < set->entryCount; i++) {
+			if (set->entries[i].key != (MapKey)NULL) {
+				addBloomFilterHashCode(set->bloomFilter,
+					getHashSetKeyHashCode(set, set->entries[i].key));
+			}
+		}
+	}
+}
+
+/**
+ * Returns the keys of this set in increasing order. The first call
+ * sorts the keys into a view that the set keeps from then on: a key
+ * pointer per key, and a change record for each later add or delete.
+ * Later calls merge in the changes with O(k log n) comparisons for k
+ * changes, but also scan and move every key, so each refresh is O(n).
+ *
+ * @param set the HashSet
+ * @return the getHashSetSize() keys of the set in strcmp() order,
+ *   valid until the set is changed
+ */
+MapKey* getSortedHashSetKeys(HashSet* set) {
+	if (set->sortedKeys == (SortedKeyView*)NULL) {
+		set->sortedKeys = createSortedKeyView();
+	}
+	SortedKeyView* view = set->sortedKeys;
+	if (view->isStale) {
+		MapKey* keys = prepareSortedKeyView(view, set->size);
+		size_t count = 0;
+		for (size_t i = 0; i < set->entryCount; i++) {
+			if (set->entries[i].key != (MapKey)NULL) {
+				keys[count++] = set->entries[i].key;
+			}
+		}
+		sortSortedKeyView(view);
+	} else {
+		updateSortedKeyView(view);
+	}
+	return view->keys;
+}
+
+/**
+ * Returns the position in getSortedHashSetKeys() of the first key of
+ * this set that is not less than the specified key.
+ *
+ * @param set the HashSet
+ * @param key the key
+ * @return the index of the key, or the size of the set if all keys
+ *   are less than the key
+ */
+size_t findHashSetLowerBound(HashSet* set, MapKey key) {
+	getSortedHashSetKeys(set);
+	return findSortedKeyViewLowerBound(set->sortedKeys, key);
 }
@@ -2,7 +2,29 @@
  * Hash_map.h
  *
  * This file provides the structures and function declarations of a HashSet,
- * which is a set that is backed by a HashMap
+ * which is a set of keys in a hash table of its own. The table has the
+ * layout of the chained HashMap, but its entries hold only a key, the
+ * low 32 bits of the key's hash code and the index of the next entry in
+ * the chain: 16 bytes, compared with 32 for a HashMap entry that also
+ * holds a value. When the table grows, the chains are rebuilt from the
+ * stored hash codes, so no key is hashed again. A set that keeps a Bloom
+ * filter hashes its keys again to rebuild the filter, which uses all 64
+ * bits of the hash codes: keys with equal low 32 bits would otherwise
+ * always pass the filter for each other.
+ *
+ * The set operations visit the keys of the smaller set and look them up
+ * in the larger one wherever the result allows it, so combining a small
+ * set with a large one takes time proportional to the small set. They
+ * allocate nothing but the table of a new result set, which is created
+ * with room for all of its keys. A result set shares the keys of its
+ * operands, like a set that the keys were added to.
+ *
+ * createHashSetFromKeys() builds a set from an array of keys on several
+ * threads. The table is divided into partitions of adjacent table
+ * entries, and each key belongs to the partition of its table entry.
+ * The threads hash their share of the keys and copy them into a buffer
+ * grouped by partition; then each thread links and removes duplicates
+ * from whole partitions, which share no chains, so no locks are needed.
  *
  * @since 2017-03-15
  * @author philip gust
@@ -12,21 +34,128 @@
 #define HASH_SET_H_
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
-#include "hash_map.h"
+#include "map_entry.h"
+#include "bloom_filter.h"
+#include "hash_map_stats.h"
+#include "sorted_key_view.h"
+
+/**
+ * Index of an entry in the entry array of a HashSet
+ */
+typedef uint32_t HashSetIndex;
 
 /**
- * Structure that defines a HashSet. All entries are private
+ * Entry in the entry array. Entries for the same hash table entry
+ * are linked into a hash chain by their entry array indexes.
  */
 typedef struct {
-	HashMap* map;
+	MapKey key;							// the key, NULL if deleted
+	uint32_t hashCode;					// low bits of the key hash code
+	HashSetIndex nextEntry;				// index of next entry in chain
+} HashSetEntry;
+
+/**
+ * Structure that defines a HashSet. All entries are private. Keys are
+ * added to the end of the entry array, so forEachHashSetKey() visits
+ * them in the order they were added; a HashSetIterator returns them
+ * in increasing order. Deleted entries are left in the array until
+ * it is full, and then are removed by moving the entries that follow
+ * them down.
+ */
+typedef struct {
+	HashSetIndex* hashTable;			// first entry of each chain
+	size_t capacity;					// the size of the hash table
+	size_t size;						// number of keys in the set
+	float loadFactor;					// % full before resizing table
+	uint64_t seed;						// hash seed for keys of this set
+	HashSetEntry* entries;				// entries in the order added
+	size_t entryCount;					// entries used, including deleted
+	size_t entryCapacity;				// size of the entry array
+	BloomFilter* bloomFilter;			// filter of key hash codes, or NULL
+	SortedKeyView* sortedKeys;			// keys in order, or NULL
+#ifdef HASH_MAP_STATS
+	HashMapCounters counters;			// search and resize counts
+#endif
 } HashSet;
 
+/**
+ * Definition covers void* for-each callback data
+ */
+typedef void* HashSetForEachData;
+
+/**
+ * Definition of for-each callback. Returns true to continue
+ * with the next key, false to stop.
+ */
+typedef bool (*HashSetForEachCallback)(MapKey, HashSetForEachData);
+
 /**
  * Create new empty HashSet.
  */
 HashSet* createHashSet(void);
 
+/**
+ * Create new empty HashSet that can hold the specified number of keys
+ * without being resized.
+ *
+ * @param nKeys the expected number of keys
+ * @return a new HashSet
+ */
+HashSet* createHashSetWithCapacity(size_t nKeys);
+
+/**
+ * Create new HashSet of the keys in an array, using several threads.
+ * The set keeps the first of each group of equal keys. Its keys are
+ * visited by forEachHashSetKey() in the order of their partitions, and
+ * in the order of the array within a partition, rather than in the
+ * order of the array.
+ *
+ * @param keys the keys, which may contain duplicates
+ * @param nKeys the number of keys, less than 2^32-1
+ * @param nThreads the number of threads to use, at least 1
+ * @return a new HashSet of the keys
+ */
+HashSet* createHashSetFromKeys(MapKey* keys, size_t nKeys, int nThreads);
+
+/**
+ * Create new HashSet of the keys that are in either of two sets.
+ *
+ * @param set the first HashSet
+ * @param otherSet the second HashSet
+ * @return a new HashSet of the union of the sets
+ */
+HashSet* createHashSetUnion(HashSet* set, HashSet* otherSet);
+
+/**
+ * Create new HashSet of the keys that are in both of two sets. Takes
+ * time proportional to the smaller set.
+ *
+ * @param set the first HashSet
+ * @param otherSet the second HashSet
+ * @return a new HashSet of the intersection of the sets
+ */
+HashSet* createHashSetIntersection(HashSet* set, HashSet* otherSet);
+
+/**
+ * Create new HashSet of the keys of a set that are not in another set.
+ *
+ * @param set the HashSet
+ * @param otherSet the HashSet of keys to leave out
+ * @return a new HashSet of the difference of the sets
+ */
+HashSet* createHashSetDifference(HashSet* set, HashSet* otherSet);
+
+/**
+ * Create new HashSet of the keys that are in exactly one of two sets.
+ *
+ * @param set the first HashSet
+ * @param otherSet the second HashSet
+ * @return a new HashSet of the symmetric difference of the sets
+ */
+HashSet* createHashSetSymmetricDifference(HashSet* set, HashSet* otherSet);
+
 /**
  * Frees a HashSet.
  *
@@ -70,13 +199,27 @@ bool containsHashSetKey(HashSet* set, MapKey key);
 
 /**
  * Returns true if this set contains all the keys from the other set.
+ * Takes time proportional to the other set, or none if it is larger.
  *
  * @param set the HashSet
- * @param key the entry key to check
+ * @param otherSet the other HashSet
  * @return true if the set contains all the keys, false otherwise
  */
 bool containsAllHashSetKeys(HashSet* set, HashSet* otherSet);
 
+/**
+ * Calls the callback for each key in the set until the callback
+ * returns false. The callback must not add or delete keys.
+ *
+ * @param set the HashSet
+ * @param callback the for-each callback
+ * @param callbackData the callback data
+ * @return true if all keys were visited, false if the callback
+ *   stopped the traversal
+ */
+bool forEachHashSetKey(HashSet* set,
+	HashSetForEachCallback callback, HashSetForEachData callbackData);
+
 /**
  * Returns true if this set contains no keys.
  *
@@ -102,22 +245,99 @@ size_t getHashSetSize(HashSet* set);
  */
 bool deleteHashSetKey(HashSet* set, MapKey key);
 
+/**
+ * Removes each key of this set for which the callback returns true.
+ * The callback must not add or delete keys itself.
+ *
+ * @param set the HashSet
+ * @param callback returns true for a key to remove
+ * @param callbackData the callback data
+ * @return the number of keys removed
+ */
+size_t deleteHashSetKeysIf(HashSet* set,
+	HashSetForEachCallback callback, HashSetForEachData callbackData);
+
 /**
  * Removes all elements from this set that are present in the other set.
+ * Takes time proportional to the smaller set.
  *
  * @param set the HashSet
- * @param key the entry key to check
+ * @param otherSet the other HashSet
  * @return true if the set changed as a result of this call
  */
 bool deleteAllHashSetKeys(HashSet* set, HashSet* otherSet);
 
 /**
  * Retains only the elements in this set that are present in the other set.
+ * Takes time proportional to this set, since it may remove any of its keys.
  *
  * @param set the HashSet
- * @param key the entry key to check
+ * @param otherSet the other HashSet
  * @return true if the set changed as a result of this call
  */
 bool retainAllHashSetKeys(HashSet* set, HashSet* otherSet);
 
+/**
+ * Removes the elements of this set that are present in the other set,
+ * and adds the elements of the other set that were not present, which
+ * leaves the symmetric difference of the sets in this set.
+ *
+ * @param set the HashSet
+ * @param otherSet the other HashSet
+ * @return true if the set changed as a result of this call
+ */
+bool toggleAllHashSetKeys(HashSet* set, HashSet* otherSet);
+
+/**
+ * Resizes the table if necessary so that the set can hold the specified
+ * number of keys without being resized again.
+ *
+ * @param set the HashSet
+ * @param nKeys the number of keys to make room for
+ */
+void reserveHashSet(HashSet* set, size_t nKeys);
+
+/**
+ * Keeps a Bloom filter of the keys of this set, so that most checks
+ * for keys that are not in the set skip searching its table. Deleted
+ * keys stay in the filter until rebuildHashSetBloomFilter() is called.
+ *
+ * @param set the HashSet
+ */
+void enableHashSetBloomFilter(HashSet* set);
+
+/**
+ * Rebuilds the Bloom filter of this set from its current keys, which
+ * removes deleted keys from the filter. Does nothing if the set does
+ * not keep a filter. The keys are hashed again, since the filter uses
+ * more bits of their hash codes than the entries store.
+ *
+ * @param set the HashSet
+ */
+void rebuildHashSetBloomFilter(HashSet* set);
+
+/**
+ * Returns the keys of this set in increasing order. The first call
+ * sorts the keys into a view that the set keeps from then on: a key
+ * pointer per key, and a change record for each later add or delete.
+ * Later calls merge in the changes with O(k log n) comparisons for k
+ * changes, but also scan and move every key, so each refresh is O(n).
+ *
+ * @param set the HashSet
+ * @return the getHashSetSize() keys of the set in strcmp() order,
+ *   valid until the set is changed
+ */
+MapKey* getSortedHashSetKeys(HashSet* set);
+
+/**
+ * Returns the position in getSortedHashSetKeys() of the first key of
+ * this set that is not less than the specified key.
+ *
+ * @param set the HashSet
+ * @param key the key
+ * @return the index of the key, or the size of the set if all keys
+ *   are less than the key
+ */
+size_t findHashSetLowerBound(HashSet* set, MapKey key);
+
 #endif /* HASH_SET_H_ */
@@ -2,7 +2,7 @@
  * tree_map_iterator.c
  *
  * This file provides the implementations of a HashSetIterator that
- * iterates over the keys of a HashSet.
+ * iterates over the keys of a HashSet in increasing order.
  *
  * @since 2017-03-15
  * @author philip gust
@@ -10,8 +10,20 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include "hash_set_iterator.h"
 
+/**
+ * Compares two keys for qsort().
+ *
+ * @param key1 pointer to the first key
+ * @param key2 pointer to the second key
+ * @return <0, 0 or >0 as the first key is less than, equal to or greater
+ *   than the second
+ */
+static int compareHashSetKeys(const void* key1, const void* key2) {
+	return strcmp(*(const MapKey*)key1, *(const MapKey*)key2);
+}
 
 /**
  * Create and initialize a new HashSetIterator
@@ -21,7 +33,15 @@
  */
 HashSetIterator* createHashSetIterator(HashSet* set) {
 	HashSetIterator* itr = (HashSetIterator*)malloc(sizeof(HashSetIterator));
- 	itr->mapIterator = createHashMapIterator(set->map);
+ 	itr->set = set;
+	itr->keys = (MapKey*)malloc((set->size + 1) * sizeof(MapKey));
+	size_t count = 0;
+	for (size_t i = 0; i < set->entryCount; i++) {
+		if (set->entries[i].key != (MapKey)NULL) {
+			itr->keys[count++] = set->entries[i].key;
+		}
+	}
+	qsort(itr->keys, count, sizeof(MapKey), compareHashSetKeys);
  	resetHashSetIterator(itr);
 	return itr;
 }
@@ -32,8 +52,9 @@ HashSetIterator* createHashSetIterator(HashSet* set) {
  * @param itr the HashSetIterator to delete
  */
 void deleteHashSetIterator(HashSetIterator* itr) {
-	deleteHashMapIterator(itr->mapIterator);
-	itr->mapIterator = (HashMapIterator*)NULL;
+	free(itr->keys);
+	itr->keys = (MapKey*)NULL;
+	itr->set = (HashSet*)NULL;
 	free(itr);
 }
 
@@ -44,7 +65,10 @@ void deleteHashSetIterator(HashSetIterator* itr) {
  * @return the next key or NULL if iterator is at end the set
  */
 MapKey* getNextHashSetKey(HashSetIterator* itr) {
-	return &getNextHashMapEntry(itr->mapIterator)->key;
+	if (!hasNextHashSetKey(itr)) {
+		return (MapKey*)NULL;
+	}
+	return &itr->keys[itr->count++];
 }
 
 /**
@@ -54,7 +78,7 @@ MapKey* getNextHashSetKey(HashSetIterator* itr) {
  * @return true if there is another key, false otherwise
  */
 bool hasNextHashSetKey(HashSetIterator* itr) {
-	return hasNextHashMapEntry(itr->mapIterator);
+	return itr->count < itr->set->size;
 }
 
 /**
@@ -64,7 +88,10 @@ bool hasNextHashSetKey(HashSetIterator* itr) {
  * @return the previous key or NULL if iterator is at end of list
  */
 MapKey* getPrevHashSetKey(HashSetIterator* itr) {
-	return &getPrevHashMapEntry(itr->mapIterator)->key;
+	if (!hasPrevHashSetKey(itr)) {
+		return (MapKey*)NULL;
+	}
+	return &itr->keys[--itr->count];
 }
 
 /**
@@ -74,7 +101,7 @@ MapKey* getPrevHashSetKey(HashSetIterator* itr) {
  * @return the previous key or NULL if iterator is at beginning of the set
  */
 bool hasPrevHashSetKey(HashSetIterator* itr) {
-	return hasPrevHashMapEntry(itr->mapIterator);
+	return itr->count > 0;
 }
 
 /**
@@ -84,7 +111,8 @@ bool hasPrevHashSetKey(HashSetIterator* itr) {
  * @return true if successful, false if not supported
  */
 bool resetHashSetIterator(HashSetIterator* itr) {
-	return resetHashMapIterator(itr->mapIterator);
+	itr->count = 0;
+	return true;
 }
 
 /**
@@ -94,7 +122,7 @@ bool resetHashSetIterator(HashSetIterator* itr) {
  * @return the number of keys returned so far
  */
 size_t getHashSetIteratorCount(HashSetIterator* itr) {
-	return getHashMapIteratorCount(itr->mapIterator);
+	return itr->count;
 }
 
 /**
@@ -104,5 +132,5 @@ size_t getHashSetIteratorCount(HashSetIterator* itr) {
  * @return available number of keys or UNAVAILABLE if cannot perform operation.
  */
 size_t getHashSetIteratorAvailable(HashSetIterator* itr) {
-	return getHashMapIteratorAvailable(itr->mapIterator);
+	return itr->set->size - itr->count;
 }
@@ -2,7 +2,11 @@
  * tree_set_iterator.h
  *
  * This file provides the structures and function declarations of a
- * HashSetIterator that iterates over the entries of a HashSet.
+ * HashSetIterator that iterates over the entries of a HashSet in
+ * increasing order of their keys. The iterator sorts its own copy of
+ * the keys, which it frees when it is deleted, so iterating does not
+ * attach a sorted view to the set. The set must not be changed while
+ * it is being iterated.
  *
  * @since 2017-02-15
  * @author philip gust
@@ -14,13 +18,14 @@
 #include <stdbool.h>
 
 #include "hash_set.h"
-#include "hash_map_iterator.h"
 
 /**
  * An iterator for a HashSet
  */
 typedef struct {
-  HashMapIterator* mapIterator;
+	HashSet* set;						// the set
+	MapKey* keys;						// sorted copy of the keys of the set
+	size_t count;						// count of keys returned
 } HashSetIterator;
 
 /**
@@ -10,10 +10,24 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "CUnit/CUnit.h"
 #include "CUnit/Basic.h"
+#include "hash_map_iterator.h"
 #include "hash_set.h"
 #include "hash_set_iterator.h"
+#include "concurrent_hash_map.h"
+#include "epoch_hash_map.h"
+#include "int_hash_map.h"
+#include "hash_map_snapshot.h"
+#include "frozen_hash_map.h"
+#include "lru_cache.h"
+#include "disk_hash_map.h"
+#include "hyper_log_log.h"
 
 HashSet* makeHashSet(char** entries, int nEntries) {
 	HashSet* set = createHashSet();
@@ -57,8 +71,9 @@ static void testHashSet(void) {
 	}
 	CU_ASSERT_EQUAL(getHashSetIteratorCount(itr), nEntries);
 	CU_ASSERT_EQUAL(getHashSetIteratorAvailable(itr), 0);
+	CU_ASSERT_PTR_NULL(set->sortedKeys);	// iterator sorts its own copy
 	deleteHashSetIterator(itr);
-	CU_ASSERT_PTR_NULL(itr->mapIterator);   // dicey
+	CU_ASSERT_PTR_NULL(itr->set);   // dicey
 
 	// test putAllHashSetEntries() replacing values
 	char* entries2[] = {
@@ -102,6 +117,1618 @@ static void testHashSet(void) {
 	CU_ASSERT_EQUAL(getHashSetSize(set3), 0);
 }
 
+/**
+ * Returns true if a set holds exactly the keys "key<i>" for i from
+ * first to last that are multiples of step.
+ *
+ * @param set the HashSet
+ * @param keys the keys
+ * @param first the first index
+ * @param last the index after the last one
+ * @param step the step between indexes
+ * @return true if the set holds exactly those keys
+ */
+static bool hasHashSetKeys(HashSet* set, char keys[][16], int first, int last, int step) {
+	int nKeys = 0;
+	for (int i = first; i < last; i += step) {
+		if (!containsHashSetKey(set, keys[i])) {
+			return false;
+		}
+		nKeys++;
+	}
+	return getHashSetSize(set) == nKeys;
+}
+
+/**
+ * Test of HashSet union, intersection and differences
+ */
+static void testHashSetAlgebra(void) {
+	static char keys[10000][16];
+	for (int i = 0; i < 10000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+	}
+	HashSet* large = createHashSet();		// keys 0..9999
+	HashSet* evens = createHashSet();		// even keys 0..199
+	HashSet* small = createHashSet();		// keys 9995..9999 and the next 5
+	char extra[5][16];
+	for (int i = 0; i < 10000; i++) {
+		addHashSetKey(large, keys[i]);
+	}
+	for (int i = 0; i < 200; i += 2) {
+		addHashSetKey(evens, keys[i]);
+	}
+	for (int i = 0; i < 5; i++) {
+		addHashSetKey(small, keys[9995 + i]);
+		snprintf(extra[i], sizeof extra[i], "extra%d", i);
+		addHashSetKey(small, extra[i]);
+	}
+
+	HashSet* result = createHashSetUnion(evens, small);
+	CU_ASSERT_EQUAL(getHashSetSize(result), 110);
+	CU_ASSERT_TRUE(containsAllHashSetKeys(result, evens));
+	CU_ASSERT_TRUE(containsAllHashSetKeys(result, small));
+	deleteHashSet(result);
+
+	// intersecting probes the larger set once per key of the smaller one
+#ifdef HASH_MAP_STATS
+	memset(&large->counters, 0, sizeof(HashMapCounters));
+#endif
+	result = createHashSetIntersection(large, small);
+	CU_ASSERT_TRUE(hasHashSetKeys(result, keys, 9995, 10000, 1));
+#ifdef HASH_MAP_STATS
+	CU_ASSERT_EQUAL(large->counters.hitCount + large->counters.missCount, 10);
+#endif
+	deleteHashSet(result);
+	result = createHashSetIntersection(evens, large);
+	CU_ASSERT_TRUE(hasHashSetKeys(result, keys, 0, 200, 2));
+	deleteHashSet(result);
+
+	result = createHashSetDifference(small, large);
+	CU_ASSERT_EQUAL(getHashSetSize(result), 5);
+	CU_ASSERT_TRUE(containsHashSetKey(result, "extra0"));
+	CU_ASSERT_FALSE(containsHashSetKey(result, keys[9995]));
+	deleteHashSet(result);
+	result = createHashSetDifference(large, evens);
+	CU_ASSERT_EQUAL(getHashSetSize(result), 9900);
+	CU_ASSERT_FALSE(containsHashSetKey(result, keys[0]));
+	CU_ASSERT_TRUE(containsHashSetKey(result, keys[1]));
+	deleteHashSet(result);
+
+	result = createHashSetSymmetricDifference(small, large);
+	CU_ASSERT_EQUAL(getHashSetSize(result), 9995 + 5);
+	CU_ASSERT_TRUE(containsHashSetKey(result, "extra4"));
+	CU_ASSERT_FALSE(containsHashSetKey(result, keys[9999]));
+	CU_ASSERT_TRUE(containsHashSetKey(result, keys[0]));
+
+	// in place: toggling the same keys back restores the set
+	CU_ASSERT_TRUE(toggleAllHashSetKeys(result, small));
+	CU_ASSERT_TRUE(hasHashSetKeys(result, keys, 0, 10000, 1));
+	CU_ASSERT_FALSE(containsAllHashSetKeys(evens, result));
+	CU_ASSERT_TRUE(containsAllHashSetKeys(result, evens));
+	CU_ASSERT_TRUE(deleteAllHashSetKeys(result, evens));	// iterates evens
+	CU_ASSERT_EQUAL(getHashSetSize(result), 9900);
+	CU_ASSERT_FALSE(deleteAllHashSetKeys(result, evens));
+	CU_ASSERT_FALSE(deleteAllHashSetKeys(evens, result));	// iterates evens
+	CU_ASSERT_EQUAL(getHashSetSize(evens), 100);
+	CU_ASSERT_TRUE(deleteAllHashSetKeys(evens, large));
+	CU_ASSERT_TRUE(isHashSetEmpty(evens));
+	CU_ASSERT_TRUE(retainAllHashSetKeys(result, small));
+	CU_ASSERT_TRUE(hasHashSetKeys(result, keys, 9995, 10000, 1));
+	CU_ASSERT_FALSE(retainAllHashSetKeys(result, large));
+	CU_ASSERT_TRUE(addAllHashSetKeys(result, small));
+	CU_ASSERT_EQUAL(getHashSetSize(result), 10);
+	CU_ASSERT_FALSE(addAllHashSetKeys(result, small));
+
+	// a set combined with itself
+	CU_ASSERT_TRUE(containsAllHashSetKeys(result, result));
+	CU_ASSERT_FALSE(addAllHashSetKeys(result, result));
+	CU_ASSERT_FALSE(retainAllHashSetKeys(result, result));
+	CU_ASSERT_TRUE(toggleAllHashSetKeys(result, result));
+	CU_ASSERT_TRUE(isHashSetEmpty(result));
+	CU_ASSERT_FALSE(deleteAllHashSetKeys(result, result));
+	deleteHashSet(result);
+
+	deleteHashSet(small);
+	deleteHashSet(evens);
+	deleteHashSet(large);
+}
+
+/**
+ * Callback that selects keys whose number is odd.
+ *
+ * @param key the key
+ * @param data unused
+ * @return true if the key number is odd
+ */
+static bool isOddHashSetKey(MapKey key, HashSetForEachData data) {
+	return atoi(key + 3) % 2 != 0;
+}
+
+/**
+ * Test of the key-only HashSet table across resizes and deletes
+ */
+static void testHashSetStorage(void) {
+	static char keys[5000][16];
+	for (int i = 0; i < 5000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+	}
+
+	// an entry is a key, its hash code, and the index of the next entry
+	CU_ASSERT_EQUAL(sizeof(HashSetEntry), 16);
+
+	// reserving avoids rehashing as the keys are added
+	HashSet* set = createHashSet();
+	reserveHashSet(set, 5000);
+	size_t capacity = set->capacity;
+	HashSetEntry* entries = set->entries;
+	for (int i = 0; i < 5000; i++) {
+		CU_ASSERT_TRUE(addHashSetKey(set, keys[i]));
+	}
+	CU_ASSERT_FALSE(addHashSetKey(set, keys[0]));
+	CU_ASSERT_EQUAL(set->capacity, capacity);
+	CU_ASSERT_PTR_EQUAL(set->entries, entries);
+	CU_ASSERT_TRUE(hasHashSetKeys(set, keys, 0, 5000, 1));
+
+	// deleting the odd keys leaves holes that the iterator does not return
+	CU_ASSERT_EQUAL(deleteHashSetKeysIf(set, isOddHashSetKey, NULL), 2500);
+	CU_ASSERT_TRUE(hasHashSetKeys(set, keys, 0, 5000, 2));
+	HashSetIterator* itr = createHashSetIterator(set);
+	int nKeys = 0;
+	while (hasNextHashSetKey(itr)) {
+		CU_ASSERT_FALSE(isOddHashSetKey(*getNextHashSetKey(itr), NULL));
+		nKeys++;
+	}
+	CU_ASSERT_EQUAL(nKeys, 2500);
+	CU_ASSERT_PTR_NULL(getNextHashSetKey(itr));
+	while (hasPrevHashSetKey(itr)) {
+		CU_ASSERT_FALSE(isOddHashSetKey(*getPrevHashSetKey(itr), NULL));
+		nKeys--;
+	}
+	CU_ASSERT_EQUAL(nKeys, 0);
+	deleteHashSetIterator(itr);
+
+	// adding past the end of the entries reuses the holes
+	for (int i = 1; i < 5000; i += 2) {
+		CU_ASSERT_TRUE(addHashSetKey(set, keys[i]));
+	}
+	CU_ASSERT_TRUE(hasHashSetKeys(set, keys, 0, 5000, 1));
+	CU_ASSERT_TRUE(set->entryCount <= set->entryCapacity);
+	CU_ASSERT_TRUE(set->entryCapacity < 2 * 5000);
+
+	// deleting the last keys trims the entries
+	for (int i = 4999; i >= 4000; i--) {
+		CU_ASSERT_TRUE(deleteHashSetKey(set, keys[i]));
+	}
+	CU_ASSERT_FALSE(deleteHashSetKey(set, keys[4999]));
+	CU_ASSERT_EQUAL(getHashSetSize(set), 4000);
+
+	clearHashSet(set);
+	CU_ASSERT_TRUE(isHashSetEmpty(set));
+	CU_ASSERT_EQUAL(set->entryCount, 0);
+	CU_ASSERT_FALSE(containsHashSetKey(set, keys[0]));
+	CU_ASSERT_TRUE(addHashSetKey(set, keys[0]));
+	CU_ASSERT_TRUE(containsHashSetKey(set, keys[0]));
+	deleteHashSet(set);
+}
+
+/**
+ * Test of building a HashSet from an array of keys on several threads
+ */
+static void testHashSetFromKeys(void) {
+	// 20000 keys: 5000 distinct keys, then three copies of each
+	static char distinctKeys[5000][16];
+	static char copies[15000][16];
+	static MapKey keys[20000];
+	for (int i = 0; i < 5000; i++) {
+		snprintf(distinctKeys[i], sizeof distinctKeys[i], "key%d", i);
+		keys[i] = distinctKeys[i];
+	}
+	for (int i = 0; i < 15000; i++) {
+		snprintf(copies[i], sizeof copies[i], "key%d", (i * 7) % 5000);
+		keys[5000 + i] = copies[i];
+	}
+
+	HashSet* added = createHashSet();
+	for (int i = 0; i < 20000; i++) {
+		addHashSetKey(added, keys[i]);
+	}
+	for (int nThreads = 1; nThreads <= 8; nThreads++) {
+		HashSet* set = createHashSetFromKeys(keys, 20000, nThreads);
+		CU_ASSERT_TRUE(hasHashSetKeys(set, distinctKeys, 0, 5000, 1));
+		CU_ASSERT_EQUAL(set->capacity, added->capacity);	// sized for distinct keys
+
+		// the first of each group of equal keys is kept
+		HashSetIterator* itr = createHashSetIterator(set);
+		int nFirst = 0;
+		while (hasNextHashSetKey(itr)) {
+			MapKey key = *getNextHashSetKey(itr);
+			nFirst += (   (uintptr_t)key >= (uintptr_t)distinctKeys[0]
+					   && (uintptr_t)key <= (uintptr_t)distinctKeys[4999]);
+		}
+		CU_ASSERT_EQUAL(nFirst, 5000);
+		deleteHashSetIterator(itr);
+
+		// the set grows and shrinks like any other
+		CU_ASSERT_FALSE(addHashSetKey(set, "key0"));
+		CU_ASSERT_TRUE(addHashSetKey(set, "key5000"));
+		CU_ASSERT_TRUE(deleteHashSetKey(set, "key17"));
+		CU_ASSERT_FALSE(containsHashSetKey(set, "key17"));
+		CU_ASSERT_EQUAL(getHashSetSize(set), 5000);
+		deleteHashSet(set);
+	}
+	deleteHashSet(added);
+
+	// distinct keys become the entries in place
+	HashSet* set = createHashSetFromKeys(keys, 5000, 4);
+	CU_ASSERT_TRUE(hasHashSetKeys(set, distinctKeys, 0, 5000, 1));
+	deleteHashSet(set);
+	set = createHashSetFromKeys(keys, 0, 4);
+	CU_ASSERT_TRUE(isHashSetEmpty(set));
+	CU_ASSERT_TRUE(addHashSetKey(set, "key0"));
+	deleteHashSet(set);
+}
+
+/**
+ * Test of HyperLogLog estimates, merges and files
+ */
+static void testHyperLogLog(void) {
+	CU_ASSERT_PTR_NULL(createHyperLogLog(HYPER_LOG_LOG_MIN_PRECISION - 1));
+	CU_ASSERT_PTR_NULL(createHyperLogLog(HYPER_LOG_LOG_MAX_PRECISION + 1));
+
+	// 100000 distinct keys, each added twice, half to each of two sketches
+	HyperLogLog* all = createHyperLogLog(HYPER_LOG_LOG_DEFAULT_PRECISION);
+	HyperLogLog* evens = createHyperLogLog(HYPER_LOG_LOG_DEFAULT_PRECISION);
+	HyperLogLog* odds = createHyperLogLog(HYPER_LOG_LOG_DEFAULT_PRECISION);
+	CU_ASSERT_EQUAL(getHyperLogLogEstimate(all), 0.0);
+	char key[16];
+	for (int i = 0; i < 200000; i++) {
+		snprintf(key, sizeof key, "key%d", i % 100000);
+		addHyperLogLogKey(all, key);
+		addHyperLogLogKey((i % 2 == 0) ? evens : odds, key);
+		if (i == 9) {
+			CU_ASSERT_EQUAL(round(getHyperLogLogEstimate(all)), 10);
+		}
+	}
+	CU_ASSERT_DOUBLE_EQUAL(getHyperLogLogEstimate(all), 100000, 2500);
+	CU_ASSERT_DOUBLE_EQUAL(getHyperLogLogEstimate(evens), 50000, 1250);
+
+	// merging the halves gives the sketch of all the keys
+	CU_ASSERT_TRUE(mergeHyperLogLog(evens, odds));
+	CU_ASSERT_EQUAL(memcmp(evens->registers, all->registers, all->nRegisters), 0);
+	HyperLogLog* coarse = createHyperLogLog(10);
+	CU_ASSERT_FALSE(mergeHyperLogLog(coarse, all));
+	deleteHyperLogLog(coarse);
+
+	// a saved sketch merges with one built later
+	char path[] = "/tmp/hyper_log_log_XXXXXX";
+	close(mkstemp(path));
+	CU_ASSERT_TRUE(saveHyperLogLog(odds, path));
+	HyperLogLog* opened = openHyperLogLog(path);
+	CU_ASSERT_PTR_NOT_NULL(opened);
+	if (opened != NULL) {
+		CU_ASSERT_EQUAL(opened->precision, HYPER_LOG_LOG_DEFAULT_PRECISION);
+		clearHyperLogLog(evens);
+		for (int i = 0; i < 100000; i += 2) {
+			snprintf(key, sizeof key, "key%d", i);
+			addHyperLogLogKey(evens, key);
+		}
+		CU_ASSERT_TRUE(mergeHyperLogLog(opened, evens));
+		CU_ASSERT_EQUAL(getHyperLogLogEstimate(opened), getHyperLogLogEstimate(all));
+		deleteHyperLogLog(opened);
+	}
+	FILE* file = fopen(path, "ab");
+	fputc(0, file);
+	fclose(file);
+	CU_ASSERT_PTR_NULL(openHyperLogLog(path));
+	unlink(path);
+	CU_ASSERT_PTR_NULL(openHyperLogLog(path));
+
+	deleteHyperLogLog(odds);
+	deleteHyperLogLog(evens);
+	deleteHyperLogLog(all);
+}
+
+/**
+ * Returns true if keys are in strictly increasing order, and are the
+ * keys "key<i>" of a set or map for i from first to last that are
+ * multiples of step, other than those in skip.
+ *
+ * @param keys the sorted keys
+ * @param nKeys the number of keys
+ * @param first the first index
+ * @param last the index after the last one
+ * @param step the step between indexes
+ * @param skip the index to leave out, or -1
+ * @return true if the keys are sorted and the expected ones
+ */
+static bool hasSortedKeys(MapKey* keys, size_t nKeys, int first, int last, int step, int skip) {
+	size_t count = 0;
+	for (int i = first; i < last; i += step) {
+		count += (i != skip);
+	}
+	if (count != nKeys) {
+		return false;
+	}
+	for (size_t i = 0; i < nKeys; i++) {
+		int n = atoi(keys[i] + 3);
+		if (   strncmp(keys[i], "key", 3) != 0 || n < first || n >= last
+			|| (n - first) % step != 0 || n == skip
+			|| (i > 0 && strcmp(keys[i-1], keys[i]) >= 0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Callback that selects entries whose key number is at least 900.
+ *
+ * @param entry the entry
+ * @param data unused
+ * @return true if the key number is at least 900
+ */
+static bool isHighKeyEntry(MapEntry* entry, HashMapForEachData data) {
+	return atoi(entry->key + 3) >= 900;
+}
+
+/**
+ * Test of the sorted views of HashSet and HashMap keys across changes
+ */
+static void testSortedKeys(void) {
+	static char keys[2000][16];
+	for (int i = 0; i < 2000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", (i * 7919) % 2000);
+	}
+
+	// a set: sorted once, then kept up to date with a few changes
+	HashSet* set = createHashSet();
+	for (int i = 0; i < 500; i++) {
+		addHashSetKey(set, keys[i]);
+	}
+	MapKey* sorted = getSortedHashSetKeys(set);
+	CU_ASSERT_STRING_EQUAL(sorted[0], "key0");
+	for (size_t i = 1; i < getHashSetSize(set); i++) {
+		CU_ASSERT_TRUE(strcmp(sorted[i-1], sorted[i]) < 0);
+	}
+	CU_ASSERT_EQUAL(findHashSetLowerBound(set, "key"), 0);
+	CU_ASSERT_EQUAL(findHashSetLowerBound(set, "key~"), getHashSetSize(set));
+	size_t index = findHashSetLowerBound(set, keys[10]);
+	CU_ASSERT_STRING_EQUAL(getSortedHashSetKeys(set)[index], keys[10]);
+
+	CU_ASSERT_TRUE(deleteHashSetKey(set, keys[10]));
+	CU_ASSERT_TRUE(addHashSetKey(set, keys[1500]));
+	CU_ASSERT_TRUE(deleteHashSetKey(set, keys[1500]));
+	CU_ASSERT_TRUE(addHashSetKey(set, keys[1500]));
+	CU_ASSERT_TRUE(addHashSetKey(set, keys[1501]));
+	CU_ASSERT_FALSE(set->sortedKeys->isStale);
+	sorted = getSortedHashSetKeys(set);
+	CU_ASSERT_EQUAL(set->sortedKeys->size, getHashSetSize(set));
+	for (size_t i = 1; i < getHashSetSize(set); i++) {
+		CU_ASSERT_TRUE(strcmp(sorted[i-1], sorted[i]) < 0);
+	}
+	CU_ASSERT_STRING_NOT_EQUAL(sorted[findHashSetLowerBound(set, keys[10])], keys[10]);
+	CU_ASSERT_STRING_EQUAL(sorted[findHashSetLowerBound(set, keys[1501])], keys[1501]);
+
+	// more changes than keys sort the view again
+	for (int i = 500; i < 2000; i++) {
+		addHashSetKey(set, keys[i]);
+	}
+	CU_ASSERT_TRUE(set->sortedKeys->isStale);
+	CU_ASSERT_TRUE(hasSortedKeys(getSortedHashSetKeys(set), getHashSetSize(set),
+								 0, 2000, 1, atoi(keys[10] + 3)));
+	clearHashSet(set);
+	CU_ASSERT_PTR_EQUAL(getSortedHashSetKeys(set), set->sortedKeys->keys);
+	CU_ASSERT_EQUAL(set->sortedKeys->size, 0);
+	CU_ASSERT_EQUAL(findHashSetLowerBound(set, "key0"), 0);
+	deleteHashSet(set);
+
+	// a map that owns its keys, so deleted keys are reused or moved
+	HashMap* map = createHashMapWithOwnedKeys(0);
+	char key[16];
+	for (int i = 0; i < 1000; i += 2) {
+		snprintf(key, sizeof key, "key%d", i);
+		putHashMapEntry(map, key, NULL);
+	}
+	CU_ASSERT_TRUE(hasSortedKeys(getSortedHashMapKeys(map), getHashMapSize(map), 0, 1000, 2, -1));
+	deleteHashMapEntryForKey(map, "key500");
+	putHashMapEntry(map, "key501", NULL);
+	putHashMapEntry(map, "key500", NULL);
+	deleteHashMapEntryForKey(map, "key501");
+	putHashMapEntry(map, "key0", NULL);
+	deleteHashMapEntryForKey(map, "key998");
+	CU_ASSERT_FALSE(map->sortedKeys->isStale);
+	CU_ASSERT_TRUE(hasSortedKeys(getSortedHashMapKeys(map), getHashMapSize(map), 0, 1000, 2, 998));
+	CU_ASSERT_EQUAL(findHashMapLowerBound(map, "key997"), getHashMapSize(map));
+	CU_ASSERT_STRING_EQUAL(getSortedHashMapKeys(map)[findHashMapLowerBound(map, "key4999")], "key50");
+
+	// the sorted keys are those of getHashMapKeys()
+	shrinkHashMap(map);
+	MapKey** mapKeys = getHashMapKeys(map);
+	sorted = getSortedHashMapKeys(map);
+	for (int i = 0; mapKeys[i] != NULL; i++) {
+		size_t index = findHashMapLowerBound(map, *mapKeys[i]);
+		CU_ASSERT_PTR_EQUAL(sorted[index], *mapKeys[i]);
+	}
+	free(mapKeys);
+	deleteHashMapEntriesIf(map, isHighKeyEntry, NULL);
+	CU_ASSERT_TRUE(hasSortedKeys(getSortedHashMapKeys(map), getHashMapSize(map), 0, 900, 2, -1));
+	clearHashMap(map);
+	CU_ASSERT_EQUAL(findHashMapLowerBound(map, "key0"), 0);
+	deleteHashMap(map);
+}
+
+/**
+ * Test of HashMap put, get, delete and iteration across table resizes
+ */
+static void testHashMap(void) {
+	static char keys[1000][16];
+	static MapValue values[2] = { { "value0" }, { "value1" } };
+	int nKeys = 1000;
+	HashMap* map = createHashMap();
+
+	for (int i = 0; i < nKeys; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		CU_ASSERT_PTR_NULL(putHashMapEntry(map, keys[i], &values[0]));
+	}
+	CU_ASSERT_EQUAL(getHashMapSize(map), nKeys);
+
+	// replace values of the even keys
+	for (int i = 0; i < nKeys; i += 2) {
+		CU_ASSERT_PTR_EQUAL(putHashMapEntry(map, keys[i], &values[1]), &values[0]);
+	}
+	CU_ASSERT_EQUAL(getHashMapSize(map), nKeys);
+	for (int i = 0; i < nKeys; i++) {
+		CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[i]), &values[i % 2 == 0 ? 1 : 0]);
+	}
+	CU_ASSERT_PTR_NULL(getHashMapEntry(map, "unknownKey"));
+
+	// delete the odd keys
+	for (int i = 1; i < nKeys; i += 2) {
+		CU_ASSERT_PTR_EQUAL(deleteHashMapEntryForKey(map, keys[i]), &values[0]);
+	}
+	CU_ASSERT_PTR_NULL(deleteHashMapEntryForKey(map, keys[1]));
+	CU_ASSERT_EQUAL(getHashMapSize(map), nKeys/2);
+	for (int i = 0; i < nKeys; i++) {
+		CU_ASSERT_EQUAL(containsHashMapKey(map, keys[i]), i % 2 == 0);
+	}
+
+	// re-add and delete the odd keys to reuse the deleted entries
+	for (int i = 1; i < nKeys; i += 2) {
+		CU_ASSERT_PTR_NULL(putHashMapEntry(map, keys[i], &values[0]));
+	}
+	CU_ASSERT_EQUAL(getHashMapSize(map), nKeys);
+	for (int i = 1; i < nKeys; i += 2) {
+		CU_ASSERT_PTR_EQUAL(deleteHashMapEntryForKey(map, keys[i]), &values[0]);
+	}
+	CU_ASSERT_EQUAL(getHashMapSize(map), nKeys/2);
+
+	// iterate forward then back over the remaining entries
+	HashMapIterator* itr = createHashMapIterator(map);
+	int count = 0;
+	while (hasNextHashMapEntry(itr)) {
+		MapEntry* entry = getNextHashMapEntry(itr);
+		CU_ASSERT_PTR_EQUAL(entry->value, &values[1]);
+		count++;
+	}
+	CU_ASSERT_EQUAL(count, nKeys/2);
+	while (hasPrevHashMapEntry(itr)) {
+		CU_ASSERT_PTR_NOT_NULL(getPrevHashMapEntry(itr));
+		count--;
+	}
+	CU_ASSERT_EQUAL(count, 0);
+	deleteHashMapIterator(itr);
+
+	clearHashMap(map);
+	CU_ASSERT_TRUE(isHashMapEmpty(map));
+	CU_ASSERT_FALSE(containsHashMapKey(map, keys[0]));
+	deleteHashMap(map);
+}
+
+/**
+ * Test of HashMap lookups and iteration while the table is being resized
+ */
+static void testHashMapRehash(void) {
+	static char keys[100][16];
+	static MapValue value = { "value" };
+	HashMap* map = createHashMap();
+
+	// fill map until entries are being moved to a resized table
+	int nKeys = 0;
+	do {
+		snprintf(keys[nKeys], sizeof keys[nKeys], "key%d", nKeys);
+		putHashMapEntry(map, keys[nKeys++], &value);
+	} while (!isHashMapRehashing(map) && nKeys < 100);
+#ifndef HASH_MAP_OPEN_ADDRESSING
+	CU_ASSERT_TRUE(isHashMapRehashing(map));
+#endif
+
+	// iterator must see entries in both tables
+	HashMapIterator* itr = createHashMapIterator(map);
+	int count = 0;
+	while (hasNextHashMapEntry(itr)) {
+		CU_ASSERT_PTR_NOT_NULL(getNextHashMapEntry(itr));
+		count++;
+	}
+	CU_ASSERT_EQUAL(count, nKeys);
+	deleteHashMapIterator(itr);
+
+	// lookups move entries, and must find them in either table
+	for (int i = 0; i < nKeys; i++) {
+		CU_ASSERT_TRUE(containsHashMapKey(map, keys[i]));
+	}
+	completeHashMapRehash(map);
+	CU_ASSERT_FALSE(isHashMapRehashing(map));
+	CU_ASSERT_EQUAL(getHashMapSize(map), nKeys);
+	for (int i = 0; i < nKeys; i++) {
+		CU_ASSERT_PTR_EQUAL(deleteHashMapEntryForKey(map, keys[i]), &value);
+	}
+	CU_ASSERT_TRUE(isHashMapEmpty(map));
+	deleteHashMap(map);
+}
+
+/**
+ * Compute callback that counts its calls and returns the value
+ * in the callback data.
+ */
+static int computeCount = 0;
+static MapValue* computeValue(MapKey key, MapValue* value, HashMapComputeData data) {
+	computeCount++;
+	return (MapValue*)data;
+}
+
+/**
+ * Test of HashMap single-lookup put and compute functions
+ */
+static void testHashMapCompute(void) {
+	static MapValue values[3] = { { "value0" }, { "value1" }, { "value2" } };
+	HashMap* map = createHashMap();
+
+	CU_ASSERT_PTR_NULL(putIfAbsentHashMapEntry(map, "key1", &values[0]));
+	CU_ASSERT_PTR_EQUAL(putIfAbsentHashMapEntry(map, "key1", &values[1]), &values[0]);
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(map, "key1"), &values[0]);
+
+	// callback only called for absent key, and NULL adds no entry
+	computeCount = 0;
+	CU_ASSERT_PTR_EQUAL(computeIfAbsentHashMapEntry(map, "key1", computeValue, &values[1]), &values[0]);
+	CU_ASSERT_EQUAL(computeCount, 0);
+	CU_ASSERT_PTR_EQUAL(computeIfAbsentHashMapEntry(map, "key2", computeValue, &values[1]), &values[1]);
+	CU_ASSERT_PTR_NULL(computeIfAbsentHashMapEntry(map, "key3", computeValue, NULL));
+	CU_ASSERT_EQUAL(computeCount, 2);
+	CU_ASSERT_EQUAL(getHashMapSize(map), 2);
+
+	// callback only called for present key, and NULL removes entry
+	computeCount = 0;
+	CU_ASSERT_PTR_NULL(computeIfPresentHashMapEntry(map, "key3", computeValue, &values[2]));
+	CU_ASSERT_EQUAL(computeCount, 0);
+	CU_ASSERT_PTR_EQUAL(computeIfPresentHashMapEntry(map, "key1", computeValue, &values[2]), &values[2]);
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(map, "key1"), &values[2]);
+	CU_ASSERT_PTR_NULL(computeIfPresentHashMapEntry(map, "key2", computeValue, NULL));
+	CU_ASSERT_FALSE(containsHashMapKey(map, "key2"));
+	CU_ASSERT_EQUAL(computeCount, 2);
+
+	// entry reference for new and existing keys
+	bool isNew;
+	MapEntry* entry = getOrPutHashMapEntry(map, "key4", &isNew);
+	CU_ASSERT_TRUE(isNew);
+	CU_ASSERT_PTR_NULL(entry->value);
+	entry->value = &values[0];
+	entry = getOrPutHashMapEntry(map, "key4", &isNew);
+	CU_ASSERT_FALSE(isNew);
+	CU_ASSERT_PTR_EQUAL(entry->value, &values[0]);
+	CU_ASSERT_EQUAL(getHashMapSize(map), 2);
+
+	deleteHashMap(map);
+}
+
+/**
+ * Test of HashMap batched lookups
+ */
+static void testHashMapBatch(void) {
+	static char keys[100][16];
+	static MapValue values[100];
+	MapKey lookupKeys[150];
+	MapValue* lookupValues[150];
+	HashMap* map = createHashMap();
+
+	for (int i = 0; i < 100; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		putHashMapEntry(map, keys[i], &values[i]);
+	}
+
+	// every other key is missing
+	for (int i = 0; i < 150; i++) {
+		lookupKeys[i] = (i % 2 == 0) ? keys[i/2] : "unknownKey";
+	}
+	CU_ASSERT_EQUAL(getHashMapValuesBatch(map, lookupKeys, 150, lookupValues), 75);
+	for (int i = 0; i < 150; i++) {
+		CU_ASSERT_PTR_EQUAL(lookupValues[i], (i % 2 == 0) ? &values[i/2] : NULL);
+	}
+	CU_ASSERT_EQUAL(getHashMapValuesBatch(map, lookupKeys, 0, lookupValues), 0);
+
+	deleteHashMap(map);
+}
+
+/**
+ * For-each callback that counts entries, and stops after a limit.
+ *
+ * @param entry the entry
+ * @param data pointer to an array of {count, limit}
+ * @return true to continue unless the limit is reached
+ */
+static bool countEntry(MapEntry* entry, HashMapForEachData data) {
+	int* countLimit = (int*)data;
+	return ++countLimit[0] < countLimit[1];
+}
+
+/**
+ * Test of HashMap for-each traversal and stack iterators
+ */
+static void testHashMapForEach(void) {
+	static char keys[100][16];
+	static MapValue value = { "value" };
+	HashMap* map = createHashMap();
+
+	// an empty map visits nothing
+	int countLimit[2] = { 0, 1000 };
+	CU_ASSERT_TRUE(forEachHashMapEntry(map, countEntry, countLimit));
+	CU_ASSERT_EQUAL(countLimit[0], 0);
+
+	for (int i = 0; i < 100; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		putHashMapEntry(map, keys[i], &value);
+	}
+
+	// visits every entry, including any not yet rehashed
+	countLimit[0] = 0;
+	CU_ASSERT_TRUE(forEachHashMapEntry(map, countEntry, countLimit));
+	CU_ASSERT_EQUAL(countLimit[0], 100);
+
+	// callback can stop the traversal early
+	countLimit[0] = 0;
+	countLimit[1] = 10;
+	CU_ASSERT_FALSE(forEachHashMapEntry(map, countEntry, countLimit));
+	CU_ASSERT_EQUAL(countLimit[0], 10);
+
+	// iterator on the stack visits each key once
+	HashSet* seenKeys = createHashSet();
+	HashMapIterator itr;
+	initHashMapIterator(&itr, map);
+	while (hasNextHashMapEntry(&itr)) {
+		CU_ASSERT_TRUE(addHashSetKey(seenKeys, getNextHashMapEntry(&itr)->key));
+	}
+	finishHashMapIterator(&itr);
+	CU_ASSERT_EQUAL(getHashSetSize(seenKeys), 100);
+	deleteHashSet(seenKeys);
+
+	deleteHashMap(map);
+}
+
+/**
+ * Test of HashMap capacity reservation, bulk loading and shrinking
+ */
+static void testHashMapCapacity(void) {
+	static char keys[1000][16];
+	static MapValue values[1000];
+	MapKey loadKeys[1000];
+	MapValue* loadValues[1000];
+	for (int i = 0; i < 1000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		loadKeys[i] = keys[i];
+		loadValues[i] = &values[i];
+	}
+
+	// map created with capacity is not resized while filling it
+	HashMap* map = createHashMapWithCapacity(1000);
+	size_t capacity = map->capacity;
+	for (int i = 0; i < 1000; i++) {
+		putHashMapEntry(map, keys[i], &values[i]);
+	}
+	CU_ASSERT_EQUAL(map->capacity, capacity);
+	CU_ASSERT_FALSE(isHashMapRehashing(map));
+
+	// shrink after deleting most entries
+	for (int i = 10; i < 1000; i++) {
+		deleteHashMapEntryForKey(map, keys[i]);
+	}
+	shrinkHashMap(map);
+	CU_ASSERT_TRUE(map->capacity < capacity);
+	CU_ASSERT_EQUAL(getHashMapSize(map), 10);
+	for (int i = 0; i < 1000; i++) {
+		CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[i]), (i < 10) ? &values[i] : NULL);
+	}
+
+	// bulk load only counts new keys, and sizes the table once
+	CU_ASSERT_EQUAL(loadHashMapEntries(map, loadKeys, loadValues, 1000), 990);
+	CU_ASSERT_EQUAL(getHashMapSize(map), 1000);
+	capacity = map->capacity;
+	reserveHashMap(map, 1000);
+	CU_ASSERT_EQUAL(map->capacity, capacity);
+
+	// putAll sizes an empty map for all the other map's entries
+	HashMap* copy = createHashMap();
+	CU_ASSERT_TRUE(putAllHashMapEntries(copy, map));
+	CU_ASSERT_EQUAL(copy->capacity, capacity);
+	CU_ASSERT_EQUAL(getHashMapSize(copy), 1000);
+	for (int i = 0; i < 1000; i++) {
+		CU_ASSERT_PTR_EQUAL(getHashMapValue(copy, keys[i]), &values[i]);
+	}
+
+	// shrinking an empty map
+	clearHashMap(copy);
+	shrinkHashMap(copy);
+	CU_ASSERT_TRUE(isHashMapEmpty(copy));
+	CU_ASSERT_PTR_NULL(putHashMapEntry(copy, keys[0], &values[0]));
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(copy, keys[0]), &values[0]);
+
+	deleteHashMap(copy);
+	deleteHashMap(map);
+}
+
+/**
+ * Test of HashMap iteration order. The chained map iterates entries in
+ * the order they were added; the open-addressed map has no order.
+ */
+static void testHashMapOrder(void) {
+	static char keys[1000][16];
+	static MapValue value = { "value" };
+	HashMap* map = createHashMap();
+
+	for (int i = 0; i < 1000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		putHashMapEntry(map, keys[i], &value);
+	}
+
+	// delete all but every tenth key, then add back the first half
+	for (int i = 0; i < 1000; i++) {
+		if (i % 10 != 0) {
+			deleteHashMapEntryForKey(map, keys[i]);
+		}
+	}
+	for (int i = 0; i < 500; i++) {
+		putHashMapEntry(map, keys[i], &value);
+	}
+	CU_ASSERT_EQUAL(getHashMapSize(map), 550);
+
+	// expected order: every tenth key, then the re-added keys
+	int order[550];
+	int n = 0;
+	for (int i = 0; i < 1000; i += 10) {
+		order[n++] = i;
+	}
+	for (int i = 0; i < 500; i++) {
+		if (i % 10 != 0) {
+			order[n++] = i;
+		}
+	}
+
+	HashMapIterator itr;
+	initHashMapIterator(&itr, map);
+	for (int i = 0; i < n; i++) {
+		MapEntry* entry = getNextHashMapEntry(&itr);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+#ifdef HASH_MAP_OPEN_ADDRESSING
+		CU_ASSERT_TRUE(containsHashMapKey(map, keys[order[i]]));
+#else
+		CU_ASSERT_STRING_EQUAL(entry->key, keys[order[i]]);
+#endif
+	}
+	CU_ASSERT_FALSE(hasNextHashMapEntry(&itr));
+	for (int i = n-1; i >= 0; i--) {
+		MapEntry* entry = getPrevHashMapEntry(&itr);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+#ifdef HASH_MAP_OPEN_ADDRESSING
+		CU_ASSERT_TRUE(containsHashMapKey(map, keys[order[i]]));
+#else
+		CU_ASSERT_STRING_EQUAL(entry->key, keys[order[i]]);
+#endif
+	}
+	CU_ASSERT_FALSE(hasPrevHashMapEntry(&itr));
+	finishHashMapIterator(&itr);
+
+	// order is kept by shrinking
+	shrinkHashMap(map);
+	initHashMapIterator(&itr, map);
+	for (int i = 0; i < n; i++) {
+		MapEntry* entry = getNextHashMapEntry(&itr);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+#ifdef HASH_MAP_OPEN_ADDRESSING
+		CU_ASSERT_TRUE(containsHashMapKey(map, keys[order[i]]));
+#else
+		CU_ASSERT_STRING_EQUAL(entry->key, keys[order[i]]);
+#endif
+	}
+	finishHashMapIterator(&itr);
+
+	deleteHashMap(map);
+}
+
+/** Number of threads used by testConcurrentHashMap */
+#define N_TEST_THREADS 4
+
+/** Number of keys put by each thread of testConcurrentHashMap */
+#define N_THREAD_KEYS 1000
+
+/** Keys for testConcurrentHashMap, a row for each thread */
+static char concurrentKeys[N_TEST_THREADS][N_THREAD_KEYS][24];
+
+/** Map used by the threads of testConcurrentHashMap */
+static ConcurrentHashMap* concurrentMap;
+
+/**
+ * Thread that puts its own keys into concurrentMap, looks them up,
+ * and deletes every other one. CUnit assertions are not thread-safe,
+ * so errors are counted and checked by the main thread.
+ *
+ * @param data pointer to the thread's row of concurrentKeys
+ * @return the number of errors
+ */
+static void* putConcurrentKeys(void* data) {
+	static MapValue value = { "value" };
+	char (*keys)[24] = (char (*)[24])data;
+	intptr_t nErrors = 0;
+	for (int i = 0; i < N_THREAD_KEYS; i++) {
+		nErrors += (putConcurrentHashMapEntry(concurrentMap, keys[i], &value) != NULL);
+	}
+	for (int i = 0; i < N_THREAD_KEYS; i++) {
+		nErrors += (getConcurrentHashMapValue(concurrentMap, keys[i]) != &value);
+	}
+	for (int i = 0; i < N_THREAD_KEYS; i += 2) {
+		nErrors += (deleteConcurrentHashMapEntryForKey(concurrentMap, keys[i]) != &value);
+	}
+	return (void*)nErrors;
+}
+
+/**
+ * Test of HashMap with a handful of entries
+ */
+static void testHashMapSmall(void) {
+	static char keys[20][16];
+	static MapValue values[20];
+	HashMap* map = createHashMap();
+
+	for (int i = 0; i < 20; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		CU_ASSERT_PTR_NULL(putHashMapEntry(map, keys[i], &values[i]));
+#ifndef HASH_MAP_OPEN_ADDRESSING
+		// the table and entries are kept in the map until it is full
+		bool isSmall = (i < SMALL_MAP_ENTRIES);
+		CU_ASSERT_EQUAL(map->hashTable == map->smallTable, isSmall);
+		CU_ASSERT_EQUAL(map->entries == map->smallEntries, isSmall);
+#endif
+		for (int j = 0; j <= i; j++) {
+			CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[j]), &values[j]);
+		}
+		CU_ASSERT_FALSE(containsHashMapKey(map, "unknownKey"));
+	}
+
+	// shrinking a map with few entries makes it small again
+	for (int i = 3; i < 20; i++) {
+		CU_ASSERT_PTR_EQUAL(deleteHashMapEntryForKey(map, keys[i]), &values[i]);
+	}
+	shrinkHashMap(map);
+#ifndef HASH_MAP_OPEN_ADDRESSING
+	CU_ASSERT_PTR_EQUAL(map->hashTable, map->smallTable);
+	CU_ASSERT_PTR_EQUAL(map->entries, map->smallEntries);
+#endif
+	CU_ASSERT_EQUAL(getHashMapSize(map), 3);
+	for (int i = 0; i < 20; i++) {
+		CU_ASSERT_EQUAL(containsHashMapKey(map, keys[i]), i < 3);
+	}
+
+	// deleting from a small map
+	CU_ASSERT_PTR_EQUAL(deleteHashMapEntryForKey(map, keys[1]), &values[1]);
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[0]), &values[0]);
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[2]), &values[2]);
+	CU_ASSERT_FALSE(containsHashMapKey(map, keys[1]));
+
+	clearHashMap(map);
+	CU_ASSERT_EQUAL(getHashMapSize(map), 0);
+	CU_ASSERT_PTR_NULL(putHashMapEntry(map, keys[0], &values[0]));
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[0]), &values[0]);
+	deleteHashMap(map);
+}
+
+/**
+ * Test of HashMap that owns its keys
+ */
+static void testHashMapOwnedKeys(void) {
+	static MapValue values[1000];
+	char key[16];
+	HashMap* map = createHashMapWithOwnedKeys(0);
+
+	// the key buffer is reused for every put
+	for (int i = 0; i < 1000; i++) {
+		snprintf(key, sizeof key, "key%d", i);
+		CU_ASSERT_PTR_NULL(putHashMapEntry(map, key, &values[i]));
+	}
+	strcpy(key, "overwritten");
+	CU_ASSERT_EQUAL(getHashMapSize(map), 1000);
+	for (int i = 0; i < 1000; i++) {
+		snprintf(key, sizeof key, "key%d", i);
+		MapEntry* entry = getHashMapEntry(map, key);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+		CU_ASSERT_PTR_NOT_EQUAL(entry->key, key);
+		CU_ASSERT_STRING_EQUAL(entry->key, key);
+		CU_ASSERT_PTR_EQUAL(entry->value, &values[i]);
+	}
+
+	// keys that are prefixes of other keys are distinct
+	CU_ASSERT_FALSE(containsHashMapKey(map, "key"));
+	CU_ASSERT_FALSE(containsHashMapKey(map, "key1000"));
+	CU_ASSERT_FALSE(containsHashMapKey(map, ""));
+	CU_ASSERT_PTR_NULL(putHashMapEntry(map, "", &values[0]));
+	CU_ASSERT_TRUE(containsHashMapKey(map, ""));
+
+	// keys are kept by shrinking after deletes
+	for (int i = 0; i < 1000; i += 2) {
+		snprintf(key, sizeof key, "key%d", i);
+		CU_ASSERT_PTR_EQUAL(deleteHashMapEntryForKey(map, key), &values[i]);
+	}
+	shrinkHashMap(map);
+	CU_ASSERT_EQUAL(getHashMapSize(map), 501);
+	for (int i = 0; i < 1000; i++) {
+		snprintf(key, sizeof key, "key%d", i);
+		CU_ASSERT_EQUAL(containsHashMapKey(map, key), i % 2 != 0);
+	}
+
+	clearHashMap(map);
+	CU_ASSERT_EQUAL(getHashMapSize(map), 0);
+	CU_ASSERT_PTR_NULL(putHashMapEntry(map, "key1", &values[1]));
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(map, "key1"), &values[1]);
+	deleteHashMap(map);
+}
+
+/**
+ * Test of HashMap snapshots
+ */
+static void testHashMapSnapshot(void) {
+	static char keys[1000][16];
+	static char valueStrs[1000][16];
+	static MapValue values[1000];
+	char path[] = "/tmp/hash_map_snapshot_XXXXXX";
+	int fd = mkstemp(path);
+	CU_ASSERT_TRUE_FATAL(fd >= 0);
+	close(fd);
+
+	HashMap* map = createHashMap();
+	for (int i = 0; i < 1000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		snprintf(valueStrs[i], sizeof valueStrs[i], "value%d", i);
+		values[i].valuestr = valueStrs[i];
+		putHashMapEntry(map, keys[i], &values[i]);
+	}
+	putHashMapEntry(map, "nullValue", NULL);
+	CU_ASSERT_TRUE(saveHashMapSnapshot(map, path));
+	deleteHashMap(map);
+
+	// lookups read the mapped file
+	HashMapSnapshot* snapshot = openHashMapSnapshot(path);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(snapshot);
+	CU_ASSERT_EQUAL(getHashMapSnapshotSize(snapshot), 1001);
+	MapValue value;
+	for (int i = 0; i < 1000; i++) {
+		CU_ASSERT_PTR_EQUAL(getHashMapSnapshotValue(snapshot, keys[i], &value), &value);
+		CU_ASSERT_STRING_EQUAL(value.valuestr, valueStrs[i]);
+	}
+	CU_ASSERT_TRUE(containsHashMapSnapshotKey(snapshot, "nullValue"));
+	CU_ASSERT_PTR_NULL(getHashMapSnapshotValue(snapshot, "nullValue", &value));
+	CU_ASSERT_FALSE(containsHashMapSnapshotKey(snapshot, "unknownKey"));
+	closeHashMapSnapshot(snapshot);
+
+	// an empty map, and a file that is not a snapshot
+	map = createHashMap();
+	CU_ASSERT_TRUE(saveHashMapSnapshot(map, path));
+	deleteHashMap(map);
+	snapshot = openHashMapSnapshot(path);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(snapshot);
+	CU_ASSERT_EQUAL(getHashMapSnapshotSize(snapshot), 0);
+	CU_ASSERT_FALSE(containsHashMapSnapshotKey(snapshot, "key1"));
+	closeHashMapSnapshot(snapshot);
+	FILE* file = fopen(path, "w");
+	fputs("not a snapshot, but long enough to hold a header", file);
+	fclose(file);
+	CU_ASSERT_PTR_NULL(openHashMapSnapshot(path));
+	unlink(path);
+	CU_ASSERT_PTR_NULL(openHashMapSnapshot(path));
+}
+
+/**
+ * Counts the entries of a FrozenHashMap whose value is the one for
+ * their key.
+ *
+ * @param entry the entry
+ * @param data the count
+ * @return true to continue
+ */
+static bool countFrozenEntry(MapEntry* entry, HashMapForEachData data) {
+	if (entry->value != NULL && strcmp(entry->key + 3, entry->value->valuestr + 5) == 0) {
+		(*(size_t*)data)++;
+	}
+	return true;
+}
+
+/**
+ * Test of FrozenHashMap
+ */
+static void testFrozenHashMap(void) {
+	static char keys[5000][16];
+	static char valueStrs[5000][16];
+	static MapValue values[5000];
+
+	// an empty map, a map of one entry, and a larger map
+	HashMap* map = createHashMap();
+	FrozenHashMap* frozenMap = freezeHashMap(map);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(frozenMap);
+	CU_ASSERT_EQUAL(getFrozenHashMapSize(frozenMap), 0);
+	CU_ASSERT_FALSE(containsFrozenHashMapKey(frozenMap, "key0"));
+	deleteFrozenHashMap(frozenMap);
+
+	for (int i = 0; i < 5000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		snprintf(valueStrs[i], sizeof valueStrs[i], "value%d", i);
+		values[i].valuestr = valueStrs[i];
+	}
+	for (int nKeys = 1; nKeys <= 5000; nKeys *= 70) {
+		clearHashMap(map);
+		for (int i = 0; i < nKeys; i++) {
+			putHashMapEntry(map, keys[i], &values[i]);
+		}
+		frozenMap = freezeHashMap(map);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(frozenMap);
+		CU_ASSERT_EQUAL(getFrozenHashMapSize(frozenMap), nKeys);
+		for (int i = 0; i < nKeys; i++) {
+			CU_ASSERT_PTR_EQUAL(getFrozenHashMapValue(frozenMap, keys[i]), &values[i]);
+		}
+		for (int i = nKeys; i < 5000; i += 7) {
+			CU_ASSERT_FALSE(containsFrozenHashMapKey(frozenMap, keys[i]));
+		}
+		size_t count = 0;
+		CU_ASSERT_TRUE(forEachFrozenHashMapEntry(frozenMap, countFrozenEntry, &count));
+		CU_ASSERT_EQUAL(count, nKeys);
+		deleteFrozenHashMap(frozenMap);
+	}
+
+	deleteHashMap(map);
+
+	// a map that owns its keys is frozen with its own copies of them
+	char key[16] = "temporary";
+	map = createHashMapWithOwnedKeys(0);
+	for (int i = 0; i < 4900; i++) {
+		putHashMapEntry(map, keys[i], &values[i]);
+	}
+	putHashMapEntry(map, key, NULL);
+	frozenMap = freezeHashMap(map);
+	deleteHashMap(map);
+	strcpy(key, "overwritten");
+	CU_ASSERT_TRUE(containsFrozenHashMapKey(frozenMap, "temporary"));
+	CU_ASSERT_PTR_NULL(getFrozenHashMapValue(frozenMap, "temporary"));
+	CU_ASSERT_FALSE(containsFrozenHashMapKey(frozenMap, "overwritten"));
+	CU_ASSERT_PTR_EQUAL(getFrozenHashMapValue(frozenMap, keys[4899]), &values[4899]);
+	deleteFrozenHashMap(frozenMap);
+}
+
+/**
+ * Eviction callback that records the evicted keys.
+ *
+ * @param entry the evicted entry
+ * @param data the buffer that the key is appended to
+ */
+static void recordEvictedEntry(MapEntry* entry, LRUCacheEvictData data) {
+	strcat((char*)data, entry->key);
+	strcat((char*)data, " ");
+}
+
+/**
+ * Test of LRUCache
+ */
+static void testLRUCache(void) {
+	static char keys[1000][16];
+	static MapValue values[1000];
+	char evicted[256] = "";
+	CU_ASSERT_PTR_NULL(createLRUCache(0, 0, NULL, NULL));
+
+	// an entry budget evicts the least recently used entry
+	LRUCache* cache = createLRUCache(3, 0, recordEvictedEntry, evicted);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(cache);
+	putLRUCacheEntry(cache, "a", &values[0]);
+	putLRUCacheEntry(cache, "b", &values[1]);
+	putLRUCacheEntry(cache, "c", &values[2]);
+	CU_ASSERT_PTR_EQUAL(getLRUCacheValue(cache, "a"), &values[0]);
+	putLRUCacheEntry(cache, "d", &values[3]);	// evicts b
+	CU_ASSERT_STRING_EQUAL(evicted, "b ");
+	CU_ASSERT_PTR_NULL(getLRUCacheValue(cache, "b"));
+	CU_ASSERT_PTR_EQUAL(putLRUCacheEntry(cache, "c", &values[4]), &values[2]);
+	CU_ASSERT_TRUE(containsLRUCacheKey(cache, "a"));	// does not touch a
+	putLRUCacheEntry(cache, "e", &values[5]);	// evicts a
+	CU_ASSERT_STRING_EQUAL(evicted, "b a ");
+	CU_ASSERT_EQUAL(getLRUCacheSize(cache), 3);
+	CU_ASSERT_PTR_EQUAL(deleteLRUCacheEntryForKey(cache, "d"), &values[3]);
+	CU_ASSERT_PTR_NULL(deleteLRUCacheEntryForKey(cache, "d"));
+	putLRUCacheEntry(cache, "f", &values[6]);	// reuses d's slot
+	CU_ASSERT_STRING_EQUAL(evicted, "b a ");
+	CU_ASSERT_PTR_EQUAL(getLRUCacheValue(cache, "c"), &values[4]);
+	CU_ASSERT_PTR_EQUAL(getLRUCacheValue(cache, "e"), &values[5]);
+	CU_ASSERT_PTR_EQUAL(getLRUCacheValue(cache, "f"), &values[6]);
+	CU_ASSERT_EQUAL(getLRUCacheHitCount(cache), 4);
+	CU_ASSERT_EQUAL(getLRUCacheMissCount(cache), 1);
+	CU_ASSERT_EQUAL(getLRUCacheEvictionCount(cache), 2);
+	clearLRUCache(cache);
+	CU_ASSERT_EQUAL(getLRUCacheSize(cache), 0);
+	CU_ASSERT_FALSE(containsLRUCacheKey(cache, "c"));
+	deleteLRUCache(cache);
+
+	// a byte budget is charged for keys and value strings
+	evicted[0] = '\0';
+	MapValue longValue = { "0123456789abcde" };
+	cache = createLRUCache(0, 16, recordEvictedEntry, evicted);
+	putLRUCacheEntry(cache, "a", NULL);			// 2 bytes
+	putLRUCacheEntry(cache, "b", NULL);			// 4 bytes
+	putLRUCacheEntry(cache, "c", &longValue);	// 18 bytes, evicts a and b
+	CU_ASSERT_STRING_EQUAL(evicted, "a b ");
+	CU_ASSERT_EQUAL(getLRUCacheSize(cache), 1);	// c is kept though over budget
+	putLRUCacheEntry(cache, "d", NULL);			// evicts c
+	CU_ASSERT_STRING_EQUAL(evicted, "a b c ");
+	CU_ASSERT_TRUE(containsLRUCacheKey(cache, "d"));
+	deleteLRUCache(cache);
+
+	// a cache that grows to many entries
+	cache = createLRUCache(500, 0, NULL, NULL);
+	for (int i = 0; i < 1000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		putLRUCacheEntry(cache, keys[i], &values[i]);
+	}
+	CU_ASSERT_EQUAL(getLRUCacheSize(cache), 500);
+	for (int i = 0; i < 1000; i++) {
+		CU_ASSERT_EQUAL(containsLRUCacheKey(cache, keys[i]), i >= 500);
+	}
+	deleteLRUCache(cache);
+	cache = createLRUCache(0, 100000, NULL, NULL);
+	for (int i = 0; i < 1000; i++) {
+		putLRUCacheEntry(cache, keys[i], &values[i]);
+	}
+	CU_ASSERT_EQUAL(getLRUCacheSize(cache), 1000);
+	for (int i = 0; i < 1000; i++) {
+		CU_ASSERT_PTR_EQUAL(getLRUCacheValue(cache, keys[i]), &values[i]);
+	}
+	deleteLRUCache(cache);
+}
+
+/**
+ * Test of HashMap and HashSet Bloom filters
+ */
+static void testHashMapBloomFilter(void) {
+	static char keys[2000][16];
+	static MapValue values[2000];
+	for (int i = 0; i < 2000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+	}
+
+	// the filter follows puts, resizes and deletes
+	HashMap* map = createHashMap();
+	putHashMapEntry(map, keys[0], &values[0]);
+	enableHashMapBloomFilter(map);
+	CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[0]), &values[0]);
+	for (int i = 1; i < 1000; i++) {
+		putHashMapEntry(map, keys[i], &values[i]);
+	}
+	for (int i = 0; i < 2000; i++) {
+		CU_ASSERT_PTR_EQUAL(getHashMapValue(map, keys[i]), (i < 1000) ? &values[i] : NULL);
+		CU_ASSERT_PTR_EQUAL(peekHashMapValue(map, keys[i]), (i < 1000) ? &values[i] : NULL);
+	}
+	for (int i = 0; i < 1000; i += 2) {
+		CU_ASSERT_PTR_EQUAL(deleteHashMapEntryForKey(map, keys[i]), &values[i]);
+	}
+	rebuildHashMapBloomFilter(map);
+	for (int i = 0; i < 2000; i++) {
+		CU_ASSERT_EQUAL(containsHashMapKey(map, keys[i]), i < 1000 && i % 2 == 1);
+	}
+	bool isNew;
+	CU_ASSERT_PTR_EQUAL(getOrPutHashMapEntry(map, keys[0], &isNew)->key, keys[0]);
+	CU_ASSERT_TRUE(isNew);
+	CU_ASSERT_TRUE(containsHashMapKey(map, keys[0]));
+	shrinkHashMap(map);
+	CU_ASSERT_TRUE(containsHashMapKey(map, keys[999]));
+	CU_ASSERT_FALSE(containsHashMapKey(map, keys[998]));
+
+	// few keys that were never added pass the filter
+	BloomFilter* filter = map->bloomFilter;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(filter);
+	int nPassed = 0;
+	for (int i = 1000; i < 2000; i++) {
+		nPassed += mayContainBloomFilterHashCode(
+			filter, getMapEntryKeyHashCode(keys[i], map->seed));
+	}
+	CU_ASSERT_TRUE(nPassed < 50);
+	clearHashMap(map);
+	CU_ASSERT_FALSE(containsHashMapKey(map, keys[999]));
+	disableHashMapBloomFilter(map);
+	CU_ASSERT_PTR_NULL(map->bloomFilter);
+	deleteHashMap(map);
+
+	// a set with a filter
+	HashSet* set = createHashSet();
+	enableHashSetBloomFilter(set);
+	for (int i = 0; i < 1000; i++) {
+		CU_ASSERT_TRUE(addHashSetKey(set, keys[i]));
+	}
+	for (int i = 0; i < 2000; i++) {
+		CU_ASSERT_EQUAL(containsHashSetKey(set, keys[i]), i < 1000);
+	}
+	CU_ASSERT_FALSE(addHashSetKey(set, keys[1]));
+	CU_ASSERT_TRUE(deleteHashSetKey(set, keys[1]));
+	rebuildHashSetBloomFilter(set);
+	CU_ASSERT_FALSE(containsHashSetKey(set, keys[1]));
+
+	// the filter holds the full hash codes, not the 32 bits the entries keep
+	nPassed = 0;
+	for (int i = 0; i < 2000; i++) {
+		bool isPassed = mayContainBloomFilterHashCode(
+			set->bloomFilter, getMapEntryKeyHashCode(keys[i], set->seed));
+		if (i < 1000 && i != 1) {
+			CU_ASSERT_TRUE(isPassed);
+		} else {
+			nPassed += isPassed;
+		}
+	}
+	CU_ASSERT_TRUE(nPassed < 50);
+	deleteHashSet(set);
+}
+
+/**
+ * Test of DiskHashMap with a page cache much smaller than its entries
+ */
+static void testDiskHashMap(void) {
+	static char keys[5000][16];
+	static char valueStrs[5000][16];
+	char path[] = "/tmp/disk_hash_map_XXXXXX";
+	int fd = mkstemp(path);
+	CU_ASSERT_TRUE_FATAL(fd >= 0);
+	close(fd);
+
+	DiskHashMap* map = createDiskHashMap(path, DISK_HASH_MAP_MIN_CACHE_PAGES);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(map);
+	MapValue value;
+	for (int i = 0; i < 5000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		snprintf(valueStrs[i], sizeof valueStrs[i], "value%d", i);
+		value.valuestr = valueStrs[i];
+		CU_ASSERT_TRUE(putDiskHashMapEntry(map, keys[i], &value));
+	}
+	CU_ASSERT_TRUE(putDiskHashMapEntry(map, "nullValue", NULL));
+	CU_ASSERT_EQUAL(getDiskHashMapSize(map), 5001);
+	CU_ASSERT_TRUE(map->nBuckets > 1);
+	CU_ASSERT_TRUE(map->pageWrites > 0);	// pages were spilled to the file
+
+	int nFound = 0;
+	for (int i = 0; i < 5000; i++) {
+		MapValue* found = getDiskHashMapValue(map, keys[i], &value);
+		nFound += (found == &value && strcmp(value.valuestr, valueStrs[i]) == 0);
+	}
+	CU_ASSERT_EQUAL(nFound, 5000);
+	CU_ASSERT_TRUE(containsDiskHashMapKey(map, "nullValue"));
+	CU_ASSERT_PTR_NULL(getDiskHashMapValue(map, "nullValue", &value));
+	CU_ASSERT_FALSE(containsDiskHashMapKey(map, "unknownKey"));
+
+	// replace a value, and delete every other key
+	value.valuestr = "a longer replacement value";
+	CU_ASSERT_TRUE(putDiskHashMapEntry(map, keys[1], &value));
+	CU_ASSERT_EQUAL(getDiskHashMapSize(map), 5001);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(getDiskHashMapValue(map, keys[1], &value));
+	CU_ASSERT_STRING_EQUAL(value.valuestr, "a longer replacement value");
+	for (int i = 0; i < 5000; i += 2) {
+		CU_ASSERT_TRUE(deleteDiskHashMapEntryForKey(map, keys[i]));
+	}
+	CU_ASSERT_FALSE(deleteDiskHashMapEntryForKey(map, keys[0]));
+	CU_ASSERT_EQUAL(getDiskHashMapSize(map), 2501);
+	CU_ASSERT_FALSE(containsDiskHashMapKey(map, keys[2]));
+	CU_ASSERT_TRUE(containsDiskHashMapKey(map, keys[3]));
+
+	// the iterator returns each remaining entry once
+	DiskHashMapIterator itr;
+	initDiskHashMapIterator(&itr, map);
+	int nEntries = 0, nMatched = 0;
+	while (hasNextDiskHashMapEntry(&itr)) {
+		MapEntry* entry = getNextDiskHashMapEntry(&itr);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+		nEntries++;
+		nMatched += (entry->value != NULL
+					 && strncmp(entry->key, "key", 3) == 0
+					 && strcmp(entry->key + 3, entry->value->valuestr + 5) == 0);
+	}
+	CU_ASSERT_PTR_NULL(getNextDiskHashMapEntry(&itr));
+	CU_ASSERT_EQUAL(nEntries, 2501);
+	CU_ASSERT_EQUAL(nMatched, 2499);		// not nullValue or the replaced key
+
+	// an entry that does not fit in a page is refused
+	char* longKey = (char*)malloc(DISK_HASH_MAP_PAGE_SIZE + 1);
+	memset(longKey, 'k', DISK_HASH_MAP_PAGE_SIZE);
+	longKey[DISK_HASH_MAP_PAGE_SIZE] = '\0';
+	CU_ASSERT_FALSE(putDiskHashMapEntry(map, longKey, NULL));
+	free(longKey);
+	CU_ASSERT_FALSE(hasDiskHashMapFailed(map));
+
+	deleteDiskHashMap(map);
+	CU_ASSERT_NOT_EQUAL(access(path, F_OK), 0);	// the file was removed
+	CU_ASSERT_PTR_NULL(createDiskHashMap("/nonexistent/disk_hash_map", 16));
+}
+
+/**
+ * Test of HashMap statistics
+ */
+static void testHashMapStats(void) {
+	static char keys[2000][16];
+	static MapValue value;
+	HashMap* map = createHashMap();
+	for (int i = 0; i < 1000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		putHashMapEntry(map, keys[i], &value);
+	}
+	completeHashMapRehash(map);
+	resetHashMapStats(map);
+	for (int i = 0; i < 2000; i++) {
+		snprintf(keys[i], sizeof keys[i], "key%d", i);
+		getHashMapValue(map, keys[i]);
+	}
+
+	HashMapStats stats;
+	getHashMapStats(map, &stats);
+	CU_ASSERT_EQUAL(stats.size, 1000);
+	CU_ASSERT_EQUAL(stats.capacity, map->capacity);
+	size_t nChains = 0, nChainEntries = 0;
+	for (int length = 0; length < HASH_MAP_STATS_CHAIN_LENGTHS; length++) {
+		nChains += stats.chainLengths[length];
+		nChainEntries += length * stats.chainLengths[length];
+	}
+#ifdef HASH_MAP_OPEN_ADDRESSING
+	CU_ASSERT_EQUAL(nChains, 1000);			// each entry is counted
+	CU_ASSERT_EQUAL(stats.chainLengths[0], 0);
+	CU_ASSERT_TRUE(nChainEntries >= 1000);
+#else
+	CU_ASSERT_EQUAL(nChains, stats.capacity);	// each chain is counted
+	CU_ASSERT_EQUAL(nChainEntries, 1000);
+#endif
+	CU_ASSERT_TRUE(stats.maxChainLength >= 1 && stats.maxChainLength < 16);
+	CU_ASSERT_TRUE(stats.tableBytes > 0);
+	CU_ASSERT_TRUE(stats.entryBytes >= 1000 * sizeof(MapEntry));
+	CU_ASSERT_EQUAL(stats.filterBytes, 0);
+	enableHashMapBloomFilter(map);
+	getHashMapStats(map, &stats);
+	CU_ASSERT_TRUE(stats.filterBytes > 0);
+#ifdef HASH_MAP_STATS
+	CU_ASSERT_EQUAL(stats.hitCount, 1000);
+	CU_ASSERT_EQUAL(stats.missCount, 1000);
+	CU_ASSERT_TRUE(stats.probesPerHit >= 1.0);
+	CU_ASSERT_EQUAL(stats.resizeCount, 0);
+
+	// peek may run on several threads at once, so it is not counted
+	for (int i = 0; i < 2000; i++) {
+		CU_ASSERT_EQUAL(peekHashMapValue(map, keys[i]) != NULL, i < 1000);
+	}
+	getHashMapStats(map, &stats);
+	CU_ASSERT_EQUAL(stats.hitCount, 1000);
+	CU_ASSERT_EQUAL(stats.missCount, 1000);
+	reserveHashMap(map, 4000);
+	getHashMapStats(map, &stats);
+	CU_ASSERT_EQUAL(stats.resizeCount, 1);
+	CU_ASSERT_TRUE(stats.resizeMillis > 0);
+	resetHashMapStats(map);
+	getHashMapStats(map, &stats);
+	CU_ASSERT_EQUAL(stats.hitCount + stats.missCount + stats.resizeCount, 0);
+#else
+	CU_ASSERT_EQUAL(stats.hitCount + stats.missCount + stats.resizeCount, 0);
+#endif
+	deleteHashMap(map);
+}
+
+/**
+ * Test of ConcurrentHashMap used by several threads
+ */
+static void testConcurrentHashMap(void) {
+	static MapValue value = { "value" };
+	static MapValue otherValue = { "otherValue" };
+	concurrentMap = createConcurrentHashMap(8);
+	CU_ASSERT_EQUAL(concurrentMap->nStripes, 8);
+
+	// single-threaded use behaves like a HashMap
+	CU_ASSERT_PTR_NULL(putConcurrentHashMapEntry(concurrentMap, "key", &value));
+	CU_ASSERT_PTR_EQUAL(
+		putIfAbsentConcurrentHashMapEntry(concurrentMap, "key", &otherValue), &value);
+	CU_ASSERT_PTR_EQUAL(computeIfAbsentConcurrentHashMapEntry(
+		concurrentMap, "key", computeValue, &otherValue), &value);
+	CU_ASSERT_TRUE(containsConcurrentHashMapKey(concurrentMap, "key"));
+	CU_ASSERT_FALSE(containsConcurrentHashMapKey(concurrentMap, "unknownKey"));
+	CU_ASSERT_PTR_EQUAL(deleteConcurrentHashMapEntryForKey(concurrentMap, "key"), &value);
+	CU_ASSERT_EQUAL(getConcurrentHashMapSize(concurrentMap), 0);
+
+	// threads put, get and delete keys at the same time
+	pthread_t threads[N_TEST_THREADS];
+	for (int t = 0; t < N_TEST_THREADS; t++) {
+		for (int i = 0; i < N_THREAD_KEYS; i++) {
+			snprintf(concurrentKeys[t][i], sizeof concurrentKeys[t][i], "key%d.%d", t, i);
+		}
+		pthread_create(&threads[t], NULL, putConcurrentKeys, concurrentKeys[t]);
+	}
+	for (int t = 0; t < N_TEST_THREADS; t++) {
+		void* nErrors;
+		pthread_join(threads[t], &nErrors);
+		CU_ASSERT_EQUAL((intptr_t)nErrors, 0);
+	}
+	CU_ASSERT_EQUAL(getConcurrentHashMapSize(concurrentMap), N_TEST_THREADS*N_THREAD_KEYS/2);
+	for (int t = 0; t < N_TEST_THREADS; t++) {
+		for (int i = 0; i < N_THREAD_KEYS; i++) {
+			CU_ASSERT_EQUAL(
+				containsConcurrentHashMapKey(concurrentMap, concurrentKeys[t][i]), i % 2 != 0);
+		}
+	}
+
+	// for-each visits the entries of every stripe
+	int countLimit[2] = { 0, N_TEST_THREADS*N_THREAD_KEYS };
+	CU_ASSERT_TRUE(forEachConcurrentHashMapEntry(concurrentMap, countEntry, countLimit));
+	CU_ASSERT_EQUAL(countLimit[0], N_TEST_THREADS*N_THREAD_KEYS/2);
+
+	clearConcurrentHashMap(concurrentMap);
+	CU_ASSERT_EQUAL(getConcurrentHashMapSize(concurrentMap), 0);
+	deleteConcurrentHashMap(concurrentMap);
+	concurrentMap = (ConcurrentHashMap*)NULL;
+}
+
+/** Map used by the threads of testEpochHashMap */
+static EpochHashMap* epochMap;
+
+/** Set when the readers of testEpochHashMap should stop */
+static atomic_bool stopEpochReaders;
+
+/**
+ * Thread that looks up the first row of concurrentKeys in epochMap,
+ * which is never changed, while the main thread changes other keys.
+ *
+ * @param data unused
+ * @return the number of errors
+ */
+static void* readEpochKeys(void* data) {
+	EpochHashMapReader* reader = registerEpochHashMapReader(epochMap);
+	intptr_t nErrors = 0;
+	int nPasses = 0;
+	while (!stopEpochReaders || nPasses == 0) {
+		for (int i = 0; i < N_THREAD_KEYS; i++) {
+			nErrors += !containsEpochHashMapKey(reader, concurrentKeys[0][i]);
+		}
+		nPasses++;
+	}
+	unregisterEpochHashMapReader(reader);
+	return (void*)nErrors;
+}
+
+/**
+ * Test of EpochHashMap lookups while a writer changes the map
+ */
+static void testEpochHashMap(void) {
+	static MapValue value = { "value" };
+	static MapValue otherValue = { "otherValue" };
+	epochMap = createEpochHashMap();
+	EpochHashMapReader* reader = registerEpochHashMapReader(epochMap);
+
+	// single-threaded use behaves like a HashMap
+	CU_ASSERT_PTR_NULL(putEpochHashMapEntry(epochMap, "key", &value));
+	CU_ASSERT_PTR_EQUAL(getEpochHashMapValue(reader, "key"), &value);
+	CU_ASSERT_PTR_EQUAL(putEpochHashMapEntry(epochMap, "key", &otherValue), &value);
+	CU_ASSERT_PTR_EQUAL(getEpochHashMapValue(reader, "key"), &otherValue);
+	CU_ASSERT_FALSE(containsEpochHashMapKey(reader, "unknownKey"));
+	CU_ASSERT_PTR_EQUAL(deleteEpochHashMapEntryForKey(epochMap, "key"), &otherValue);
+	CU_ASSERT_PTR_NULL(deleteEpochHashMapEntryForKey(epochMap, "key"));
+	CU_ASSERT_EQUAL(getEpochHashMapSize(epochMap), 0);
+	unregisterEpochHashMapReader(reader);
+
+	for (int t = 0; t < N_TEST_THREADS; t++) {
+		for (int i = 0; i < N_THREAD_KEYS; i++) {
+			snprintf(concurrentKeys[t][i], sizeof concurrentKeys[t][i], "key%d.%d", t, i);
+		}
+	}
+	for (int i = 0; i < N_THREAD_KEYS; i++) {
+		putEpochHashMapEntry(epochMap, concurrentKeys[0][i], &value);
+	}
+
+	// readers always find the unchanged keys while other keys are
+	// added, replaced and deleted, and the table is resized
+	stopEpochReaders = false;
+	pthread_t threads[N_TEST_THREADS-1];
+	for (int t = 0; t < N_TEST_THREADS-1; t++) {
+		pthread_create(&threads[t], NULL, readEpochKeys, NULL);
+	}
+	for (int t = 1; t < N_TEST_THREADS; t++) {
+		for (int i = 0; i < N_THREAD_KEYS; i++) {
+			putEpochHashMapEntry(epochMap, concurrentKeys[t][i], &value);
+			putEpochHashMapEntry(epochMap, concurrentKeys[t][i], &otherValue);
+		}
+		for (int i = 0; i < N_THREAD_KEYS; i += 2) {
+			deleteEpochHashMapEntryForKey(epochMap, concurrentKeys[t][i]);
+		}
+	}
+	stopEpochReaders = true;
+	for (int t = 0; t < N_TEST_THREADS-1; t++) {
+		void* nErrors;
+		pthread_join(threads[t], &nErrors);
+		CU_ASSERT_EQUAL((intptr_t)nErrors, 0);
+	}
+	CU_ASSERT_EQUAL(getEpochHashMapSize(epochMap),
+		N_THREAD_KEYS + (N_TEST_THREADS-1)*N_THREAD_KEYS/2);
+
+	// for-each visits every entry
+	reader = registerEpochHashMapReader(epochMap);
+	int countLimit[2] = { 0, N_TEST_THREADS*N_THREAD_KEYS };
+	CU_ASSERT_TRUE(forEachEpochHashMapEntry(reader, countEntry, countLimit));
+	CU_ASSERT_EQUAL(countLimit[0], getEpochHashMapSize(epochMap));
+	unregisterEpochHashMapReader(reader);
+
+	// with no readers, every retired item is freed
+	reclaimEpochHashMap(epochMap);
+	CU_ASSERT_PTR_NULL(epochMap->retired);
+
+	deleteEpochHashMap(epochMap);
+	epochMap = (EpochHashMap*)NULL;
+}
+
+/**
+ * For-each callback that counts UInt64HashMap entries.
+ *
+ * @param entry the entry
+ * @param data pointer to the count
+ * @return true to continue
+ */
+static bool countUInt64Entry(UInt64HashMapEntry* entry, void* data) {
+	(*(int*)data)++;
+	return true;
+}
+
+/**
+ * Test of HashMaps with integer keys
+ */
+static void testIntHashMap(void) {
+	static MapValue values[2] = { { "value0" }, { "value1" } };
+	UInt64HashMap* map = createUInt64HashMap();
+
+	// keys that differ only in their high bits are distinct
+	for (uint64_t i = 0; i < 10000; i++) {
+		CU_ASSERT_PTR_NULL(putUInt64HashMapEntry(map, i << 32, &values[0]));
+	}
+	CU_ASSERT_EQUAL(getUInt64HashMapSize(map), 10000);
+	CU_ASSERT_PTR_EQUAL(putUInt64HashMapEntry(map, 5ULL << 32, &values[1]), &values[0]);
+	CU_ASSERT_PTR_EQUAL(getUInt64HashMapValue(map, 5ULL << 32), &values[1]);
+	CU_ASSERT_FALSE(containsUInt64HashMapKey(map, 5));
+
+	// delete the odd keys, and add them back after the entries are compacted
+	for (uint64_t i = 1; i < 10000; i += 2) {
+		CU_ASSERT_PTR_NOT_NULL(deleteUInt64HashMapEntryForKey(map, i << 32));
+	}
+	CU_ASSERT_PTR_NULL(deleteUInt64HashMapEntryForKey(map, 1ULL << 32));
+	CU_ASSERT_EQUAL(getUInt64HashMapSize(map), 5000);
+	for (uint64_t i = 0; i < 10000; i++) {
+		CU_ASSERT_EQUAL(containsUInt64HashMapKey(map, i << 32), i % 2 == 0);
+	}
+	for (uint64_t i = 1; i < 10000; i += 2) {
+		putUInt64HashMapEntry(map, i << 32, &values[0]);
+	}
+	int count = 0;
+	CU_ASSERT_TRUE(forEachUInt64HashMapEntry(map, countUInt64Entry, &count));
+	CU_ASSERT_EQUAL(count, 10000);
+
+	clearUInt64HashMap(map);
+	CU_ASSERT_EQUAL(getUInt64HashMapSize(map), 0);
+	CU_ASSERT_FALSE(containsUInt64HashMapKey(map, 0));
+	deleteUInt64HashMap(map);
+
+	UInt32HashMap* map32 = createUInt32HashMap();
+	reserveUInt32HashMap(map32, 1000);
+	for (uint32_t i = 0; i < 1000; i++) {
+		putUInt32HashMapEntry(map32, i * 2654435761U, &values[i % 2]);
+	}
+	for (uint32_t i = 0; i < 1000; i++) {
+		CU_ASSERT_PTR_EQUAL(getUInt32HashMapValue(map32, i * 2654435761U), &values[i % 2]);
+	}
+	CU_ASSERT_EQUAL(getUInt32HashMapSize(map32), 1000);
+	deleteUInt32HashMap(map32);
+}
+
 /**
  * Test all the functions for this application.
  *
@@ -116,6 +1743,29 @@ static int test_all(void) {
 
 	// add the tests to the suite
 	CU_add_test(pSuite, "testHashSet", testHashSet);
+	CU_add_test(pSuite, "testHashSetAlgebra", testHashSetAlgebra);
+	CU_add_test(pSuite, "testHashSetStorage", testHashSetStorage);
+	CU_add_test(pSuite, "testHashSetFromKeys", testHashSetFromKeys);
+	CU_add_test(pSuite, "testHyperLogLog", testHyperLogLog);
+	CU_add_test(pSuite, "testSortedKeys", testSortedKeys);
+	CU_add_test(pSuite, "testHashMap", testHashMap);
+	CU_add_test(pSuite, "testHashMapRehash", testHashMapRehash);
+	CU_add_test(pSuite, "testHashMapCompute", testHashMapCompute);
+	CU_add_test(pSuite, "testHashMapBatch", testHashMapBatch);
+	CU_add_test(pSuite, "testHashMapForEach", testHashMapForEach);
+	CU_add_test(pSuite, "testHashMapCapacity", testHashMapCapacity);
+	CU_add_test(pSuite, "testHashMapOrder", testHashMapOrder);
+	CU_add_test(pSuite, "testHashMapSmall", testHashMapSmall);
+	CU_add_test(pSuite, "testHashMapOwnedKeys", testHashMapOwnedKeys);
+	CU_add_test(pSuite, "testHashMapSnapshot", testHashMapSnapshot);
+	CU_add_test(pSuite, "testFrozenHashMap", testFrozenHashMap);
+	CU_add_test(pSuite, "testLRUCache", testLRUCache);
+	CU_add_test(pSuite, "testHashMapBloomFilter", testHashMapBloomFilter);
+	CU_add_test(pSuite, "testHashMapStats", testHashMapStats);
+	CU_add_test(pSuite, "testDiskHashMap", testDiskHashMap);
+	CU_add_test(pSuite, "testConcurrentHashMap", testConcurrentHashMap);
+	CU_add_test(pSuite, "testEpochHashMap", testEpochHashMap);
+	CU_add_test(pSuite, "testIntHashMap", testIntHashMap);
 
 	// run all test suites using the basic interface
 	CU_basic_set_mode(CU_BRM_VERBOSE);
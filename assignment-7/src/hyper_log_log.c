@@ -0,0 +1,220 @@
+/*
+ * hyper_log_log.c
+ *
+ * This file provides the implementation of a HyperLogLog estimate of
+ * the number of distinct keys.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "hyper_log_log.h"
+
+/** Identifies the sketch file format and hash function version */
+static const char HYPER_LOG_LOG_MAGIC[8] = "HLLOG01";
+
+/**
+ * The header at the start of a sketch file.
+ */
+typedef struct {
+	char magic[8];						// HYPER_LOG_LOG_MAGIC
+	uint64_t seed;						// hash seed of the keys
+	uint32_t precision;					// precision of the sketch
+	uint32_t reserved;					// zero
+} HyperLogLogHeader;
+
+/**
+ * Create new empty HyperLogLog.
+ *
+ * @param precision the number of hash code bits that choose a register,
+ *   from HYPER_LOG_LOG_MIN_PRECISION to HYPER_LOG_LOG_MAX_PRECISION
+ * @return new HyperLogLog, or NULL if the precision is out of range
+ */
+HyperLogLog* createHyperLogLog(unsigned precision) {
+	if (   precision < HYPER_LOG_LOG_MIN_PRECISION
+		|| precision > HYPER_LOG_LOG_MAX_PRECISION) {
+		return (HyperLogLog*)NULL;
+	}
+	HyperLogLog* hll = (HyperLogLog*)malloc(sizeof(HyperLogLog));
+	hll->precision = precision;
+	hll->nRegisters = (size_t)1 << precision;
+	hll->registers = (uint8_t*)calloc(hll->nRegisters, sizeof(uint8_t));
+	return hll;
+}
+
+/**
+ * Frees a HyperLogLog.
+ *
+ * @param hll the HyperLogLog to free
+ */
+void deleteHyperLogLog(HyperLogLog* hll) {
+	free(hll->registers);
+	free(hll);
+}
+
+/**
+ * Removes all keys from a HyperLogLog.
+ *
+ * @param hll the HyperLogLog
+ */
+void clearHyperLogLog(HyperLogLog* hll) {
+	memset(hll->registers, 0, hll->nRegisters);
+}
+
+/**
+ * Adds the keys of another HyperLogLog to a HyperLogLog, so that it
+ * estimates the number of distinct keys added to either one.
+ *
+ * @param hll the HyperLogLog
+ * @param otherHll the other HyperLogLog
+ * @return true if the keys were added, false if the sketches do not
+ *   have the same precision
+ */
+bool mergeHyperLogLog(HyperLogLog* hll, HyperLogLog* otherHll) {
+	if (hll->precision != otherHll->precision) {
+		return false;
+	}
+	for (size_t i = 0; i < hll->nRegisters; i++) {
+		if (otherHll->registers[i] > hll->registers[i]) {
+			hll->registers[i] = otherHll->registers[i];
+		}
+	}
+	return true;
+}
+
+/**
+ * Returns the correction for the registers that are still zero: the
+ * sum of x^(2^k) * 2^(k-1) for k >= 0, where x is their share of the
+ * registers.
+ *
+ * @param x the share of registers that are zero, less than 1
+ * @return the correction
+ */
+static double getZeroRegisterCorrection(double x) {
+	double y = 1.0;
+	double z = x;
+	double lastZ;
+	do {
+		x *= x;
+		lastZ = z;
+		z += x * y;
+		y += y;
+	} while (z != lastZ);
+	return z;
+}
+
+/**
+ * Returns the correction for the registers that hold the largest rank,
+ * whose runs of zeros were cut off by the end of the hash code.
+ *
+ * @param x 1 minus the share of registers that hold the largest rank
+ * @return the correction
+ */
+static double getFullRegisterCorrection(double x) {
+	if (x == 0.0 || x == 1.0) {
+		return 0.0;
+	}
+	double y = 1.0;
+	double z = 1.0 - x;
+	double lastZ;
+	do {
+		x = sqrt(x);
+		lastZ = z;
+		y *= 0.5;
+		z -= (1.0 - x) * (1.0 - x) * y;
+	} while (z != lastZ);
+	return z / 3.0;
+}
+
+/**
+ * Returns the estimated number of distinct keys added to a HyperLogLog.
+ *
+ * @param hll the HyperLogLog
+ * @return the estimated number of distinct keys
+ */
+double getHyperLogLogEstimate(HyperLogLog* hll) {
+	// count the registers of each rank; ranks run from 0 to q+1
+	unsigned q = 64 - hll->precision;
+	size_t counts[64 + 2] = { 0 };
+	for (size_t i = 0; i < hll->nRegisters; i++) {
+		counts[hll->registers[i]]++;
+	}
+	double m = (double)hll->nRegisters;
+	if (counts[0] == hll->nRegisters) {
+		return 0.0;
+	}
+
+	// Ertl's improved estimator: the harmonic sum of the registers,
+	// corrected for registers that are empty or at the largest rank
+	double z = m * getFullRegisterCorrection(1.0 - counts[q+1] / m);
+	for (unsigned k = q; k >= 1; k--) {
+		z = 0.5 * (z + counts[k]);
+	}
+	z += m * getZeroRegisterCorrection(counts[0] / m);
+	return (0.5 / log(2.0)) * m * m / z;
+}
+
+/**
+ * Saves a HyperLogLog to a file.
+ *
+ * @param hll the HyperLogLog
+ * @param path the path of the file, which is replaced if it exists
+ * @return true if the sketch was saved, false if the file could not be
+ *   written
+ */
+bool saveHyperLogLog(HyperLogLog* hll, const char* path) {
+	HyperLogLogHeader header;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, HYPER_LOG_LOG_MAGIC, sizeof header.magic);
+	header.seed = HYPER_LOG_LOG_SEED;
+	header.precision = hll->precision;
+
+	FILE* file = fopen(path, "wb");
+	bool ok = (file != (FILE*)NULL);
+	if (ok) {
+		ok = fwrite(&header, sizeof header, 1, file) == 1
+			&& fwrite(hll->registers, 1, hll->nRegisters, file) == hll->nRegisters;
+		ok = (fclose(file) == 0) && ok;
+	}
+	return ok;
+}
+
+/**
+ * Create new HyperLogLog from a file written by saveHyperLogLog().
+ *
+ * @param path the path of the file
+ * @return new HyperLogLog, or NULL if the file could not be read or
+ *   does not hold a sketch
+ */
+HyperLogLog* openHyperLogLog(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == (FILE*)NULL) {
+		return (HyperLogLog*)NULL;
+	}
+	HyperLogLogHeader header;
+	HyperLogLog* hll = (HyperLogLog*)NULL;
+	if (   fread(&header, sizeof header, 1, file) == 1
+		&& memcmp(header.magic, HYPER_LOG_LOG_MAGIC, sizeof header.magic) == 0
+		&& header.seed == HYPER_LOG_LOG_SEED) {
+		hll = createHyperLogLog(header.precision);
+	}
+
+	// every register must be present, and no rank can exceed q+1
+	if (hll != (HyperLogLog*)NULL) {
+		bool ok = fread(hll->registers, 1, hll->nRegisters, file) == hll->nRegisters
+			&& fgetc(file) == EOF;
+		for (size_t i = 0; ok && i < hll->nRegisters; i++) {
+			ok = hll->registers[i] <= 64 - hll->precision + 1;
+		}
+		if (!ok) {
+			deleteHyperLogLog(hll);
+			hll = (HyperLogLog*)NULL;
+		}
+	}
+	fclose(file);
+	return hll;
+}
@@ -0,0 +1,137 @@
+/*
+ * hyper_log_log.h
+ *
+ * This file provides the structures and function declarations of a
+ * HyperLogLog, which estimates the number of distinct keys added to it
+ * without storing the keys. The high bits of a key's hash code choose
+ * one of 2^precision registers, and the register keeps the longest run
+ * of leading zeros seen in the remaining bits. The relative standard
+ * error of the estimate is about 1.04/sqrt(2^precision): 0.8% for the
+ * default precision of 14, which takes 16 kilobytes.
+ *
+ * Keys are hashed with getMapEntryKeyHashCode() and a fixed seed, so
+ * sketches built by different threads or processes can be merged, and
+ * a sketch saved to a file can be merged with one built later. The
+ * estimate uses Ertl's improved estimator, which needs no bias tables
+ * and is accurate from a few keys up to far more than fit in memory.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef HYPER_LOG_LOG_H_
+#define HYPER_LOG_LOG_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "map_entry.h"
+
+/** Fewest and most bits of a hash code that choose the register */
+#define HYPER_LOG_LOG_MIN_PRECISION 4
+#define HYPER_LOG_LOG_MAX_PRECISION 18
+
+/** Precision that estimates within about 1% */
+#define HYPER_LOG_LOG_DEFAULT_PRECISION 14
+
+/** Hash seed of the keys of every HyperLogLog */
+#define HYPER_LOG_LOG_SEED 0x6c62272e07bb0142ULL
+
+/**
+ * The sketch.
+ */
+typedef struct {
+	unsigned precision;					// bits of hash code for register
+	size_t nRegisters;					// number of registers
+	uint8_t* registers;					// longest zero run + 1, per register
+} HyperLogLog;
+
+/**
+ * Create new empty HyperLogLog.
+ *
+ * @param precision the number of hash code bits that choose a register,
+ *   from HYPER_LOG_LOG_MIN_PRECISION to HYPER_LOG_LOG_MAX_PRECISION
+ * @return new HyperLogLog, or NULL if the precision is out of range
+ */
+HyperLogLog* createHyperLogLog(unsigned precision);
+
+/**
+ * Frees a HyperLogLog.
+ *
+ * @param hll the HyperLogLog to free
+ */
+void deleteHyperLogLog(HyperLogLog* hll);
+
+/**
+ * Removes all keys from a HyperLogLog.
+ *
+ * @param hll the HyperLogLog
+ */
+void clearHyperLogLog(HyperLogLog* hll);
+
+/**
+ * Adds a key hash code to a HyperLogLog. The hash code must come from
+ * getMapEntryKeyHashCode() with HYPER_LOG_LOG_SEED.
+ *
+ * @param hll the HyperLogLog
+ * @param hashCode the hash code
+ */
+static inline void addHyperLogLogHashCode(HyperLogLog* hll, uint64_t hashCode) {
+	size_t index = hashCode >> (64 - hll->precision);
+	// the marker bit stops the count at the last bit of the hash code
+	uint64_t bits = (hashCode << hll->precision) | ((uint64_t)1 << (hll->precision - 1));
+	uint8_t rank = (uint8_t)__builtin_clzll(bits) + 1;
+	if (rank > hll->registers[index]) {
+		hll->registers[index] = rank;
+	}
+}
+
+/**
+ * Adds a key to a HyperLogLog.
+ *
+ * @param hll the HyperLogLog
+ * @param key the key
+ */
+static inline void addHyperLogLogKey(HyperLogLog* hll, MapKey key) {
+	addHyperLogLogHashCode(hll, getMapEntryKeyHashCode(key, HYPER_LOG_LOG_SEED));
+}
+
+/**
+ * Adds the keys of another HyperLogLog to a HyperLogLog, so that it
+ * estimates the number of distinct keys added to either one.
+ *
+ * @param hll the HyperLogLog
+ * @param otherHll the other HyperLogLog
+ * @return true if the keys were added, false if the sketches do not
+ *   have the same precision
+ */
+bool mergeHyperLogLog(HyperLogLog* hll, HyperLogLog* otherHll);
+
+/**
+ * Returns the estimated number of distinct keys added to a HyperLogLog.
+ *
+ * @param hll the HyperLogLog
+ * @return the estimated number of distinct keys
+ */
+double getHyperLogLogEstimate(HyperLogLog* hll);
+
+/**
+ * Saves a HyperLogLog to a file.
+ *
+ * @param hll the HyperLogLog
+ * @param path the path of the file, which is replaced if it exists
+ * @return true if the sketch was saved, false if the file could not be
+ *   written
+ */
+bool saveHyperLogLog(HyperLogLog* hll, const char* path);
+
+/**
+ * Create new HyperLogLog from a file written by saveHyperLogLog().
+ *
+ * @param path the path of the file
+ * @return new HyperLogLog, or NULL if the file could not be read or
+ *   does not hold a sketch
+ */
+HyperLogLog* openHyperLogLog(const char* path);
+
+#endif /* HYPER_LOG_LOG_H_ */
@@ -0,0 +1,47 @@
+/*
+ * int_hash_map.c
+ *
+ * This file provides the implementation of HashMaps with integer keys,
+ * generated from hash_map_template.h.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include "int_hash_map.h"
+
+/**
+ * Compute the hash code for an integer key. The key is mixed with the
+ * seed, multiplied into a 128-bit product, and the halves are folded
+ * together so that all key bits reach the low bits that index the table.
+ *
+ * @param key the key
+ * @param seed the hash seed of the map
+ * @return the 64-bit hash code
+ */
+static inline uint64_t hashIntKey(uint64_t key, uint64_t seed) {
+	uint64_t a = key ^ seed;
+	uint64_t b = 0xe7037ed1a0b428dbULL;
+#ifdef __SIZEOF_INT128__
+	__uint128_t product = (__uint128_t)a * b;
+	return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+	a *= b;
+	return a ^ (a >> 32);
+#endif
+}
+
+/**
+ * Returns true if two integer keys are equal.
+ *
+ * @param key1 the first key
+ * @param key2 the second key
+ * @return true if the keys are equal
+ */
+static inline bool isEqualIntKey(uint64_t key1, uint64_t key2) {
+	return key1 == key2;
+}
+
+DEFINE_HASH_MAP(UInt32HashMap, uint32_t, hashIntKey, isEqualIntKey)
+
+DEFINE_HASH_MAP(UInt64HashMap, uint64_t, hashIntKey, isEqualIntKey)
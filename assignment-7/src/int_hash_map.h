@@ -0,0 +1,23 @@
+/*
+ * int_hash_map.h
+ *
+ * This file provides the structures and function declarations of
+ * HashMaps with integer keys, generated from hash_map_template.h.
+ * UInt32HashMap has uint32_t keys and UInt64HashMap has uint64_t keys.
+ * Keys are stored in the entries and hashed with a multiply, so integer
+ * IDs need not be formatted as strings.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef INT_HASH_MAP_H_
+#define INT_HASH_MAP_H_
+
+#include "hash_map_template.h"
+
+DECLARE_HASH_MAP(UInt32HashMap, uint32_t)
+
+DECLARE_HASH_MAP(UInt64HashMap, uint64_t)
+
+#endif /* INT_HASH_MAP_H_ */
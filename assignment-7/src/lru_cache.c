@@ -0,0 +1,404 @@
+/*
+ * lru_cache.c
+ *
+ * This file provides the implementation of an LRUCache, which is a
+ * HashMap that evicts its least recently used entries to stay within
+ * a budget of entries or bytes.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "lru_cache.h"
+
+/** Index that marks the end of a hash chain or of the recency list */
+#define LRU_NO_ENTRY ((LRUCacheIndex)-1)
+
+/** Default capacity of a cache without an entry budget */
+#define LRU_DEFAULT_CAPACITY 16
+
+/**
+ * Allocates a hash table whose chains are all empty.
+ *
+ * @param capacity the size of the table
+ * @return the table
+ */
+static LRUCacheIndex* allocLRUCacheTable(size_t capacity) {
+	LRUCacheIndex* table = (LRUCacheIndex*)malloc(capacity * sizeof(LRUCacheIndex));
+	for (size_t i = 0; i < capacity; i++) {
+		table[i] = LRU_NO_ENTRY;
+	}
+	return table;
+}
+
+/**
+ * Returns the bytes charged for an entry against the byte budget.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key
+ * @param value the entry value
+ * @return the cost of the entry, or 0 if there is no byte budget
+ */
+static size_t getLRUCacheEntryCost(LRUCache* cache, MapKey key, MapValue* value) {
+	if (cache->maxBytes == 0) {
+		return 0;
+	}
+	size_t cost = strlen(key) + 1;
+	if (value != (MapValue*)NULL && value->valuestr != (char*)NULL) {
+		cost += strlen(value->valuestr) + 1;
+	}
+	return cost;
+}
+
+/**
+ * Finds the link to the entry for the key, or to the end of its chain
+ * if the key is not cached.
+ *
+ * @param cache the LRUCache
+ * @param key the key
+ * @param hashCode the hash code of the key
+ * @return the link
+ */
+static inline LRUCacheIndex* findLRUCacheLink(
+	LRUCache* cache, MapKey key, uint64_t hashCode) {
+	LRUCacheIndex* link = &cache->hashTable[hashCode & (cache->capacity-1)];
+	for ( ; *link != LRU_NO_ENTRY; link = &cache->entries[*link].nextEntry) {
+		LRUCacheEntry* cacheEntry = &cache->entries[*link];
+		if (cacheEntry->hashCode == hashCode
+			&& compareMapKey(key, cacheEntry->entry.key) == 0) {
+			break;
+		}
+	}
+	return link;
+}
+
+/**
+ * Removes an entry from the recency list.
+ *
+ * @param cache the LRUCache
+ * @param index the index of the entry
+ */
+static inline void unlinkLRUCacheRecency(LRUCache* cache, LRUCacheIndex index) {
+	LRUCacheEntry* cacheEntry = &cache->entries[index];
+	if (cacheEntry->newer == LRU_NO_ENTRY) {
+		cache->newest = cacheEntry->older;
+	} else {
+		cache->entries[cacheEntry->newer].older = cacheEntry->older;
+	}
+	if (cacheEntry->older == LRU_NO_ENTRY) {
+		cache->oldest = cacheEntry->newer;
+	} else {
+		cache->entries[cacheEntry->older].newer = cacheEntry->newer;
+	}
+}
+
+/**
+ * Adds an entry to the front of the recency list.
+ *
+ * @param cache the LRUCache
+ * @param index the index of the entry
+ */
+static inline void pushLRUCacheRecency(LRUCache* cache, LRUCacheIndex index) {
+	LRUCacheEntry* cacheEntry = &cache->entries[index];
+	cacheEntry->newer = LRU_NO_ENTRY;
+	cacheEntry->older = cache->newest;
+	if (cache->newest == LRU_NO_ENTRY) {
+		cache->oldest = index;
+	} else {
+		cache->entries[cache->newest].newer = index;
+	}
+	cache->newest = index;
+}
+
+/**
+ * Removes the entry at a chain link from the cache, and adds its slot
+ * to the free entries.
+ *
+ * @param cache the LRUCache
+ * @param link the link to the entry
+ */
+static void removeLRUCacheEntry(LRUCache* cache, LRUCacheIndex* link) {
+	LRUCacheIndex index = *link;
+	LRUCacheEntry* cacheEntry = &cache->entries[index];
+	*link = cacheEntry->nextEntry;
+	unlinkLRUCacheRecency(cache, index);
+	cache->bytes -= cacheEntry->cost;
+	cache->size--;
+	cacheEntry->entry.key = (MapKey)NULL;
+	cacheEntry->entry.value = (MapValue*)NULL;
+	cacheEntry->nextEntry = cache->freeEntries;
+	cache->freeEntries = index;
+}
+
+/**
+ * Evicts the least recently used entry.
+ *
+ * @param cache the LRUCache
+ */
+static void evictLRUCacheEntry(LRUCache* cache) {
+	LRUCacheIndex index = cache->oldest;
+	LRUCacheEntry* cacheEntry = &cache->entries[index];
+	LRUCacheIndex* link = &cache->hashTable[cacheEntry->hashCode & (cache->capacity-1)];
+	while (*link != index) {
+		link = &cache->entries[*link].nextEntry;
+	}
+	if (cache->evictCallback != (LRUCacheEvictCallback)NULL) {
+		cache->evictCallback(&cacheEntry->entry, cache->evictData);
+	}
+	removeLRUCacheEntry(cache, link);
+	cache->evictionCount++;
+}
+
+/**
+ * Doubles the size of the hash table, and links the entries into it.
+ *
+ * @param cache the LRUCache
+ */
+static void growLRUCacheTable(LRUCache* cache) {
+	free(cache->hashTable);
+	cache->capacity *= 2;
+	cache->hashTable = allocLRUCacheTable(cache->capacity);
+	for (LRUCacheIndex i = cache->newest; i != LRU_NO_ENTRY; i = cache->entries[i].older) {
+		LRUCacheIndex* chain =
+			&cache->hashTable[cache->entries[i].hashCode & (cache->capacity-1)];
+		cache->entries[i].nextEntry = *chain;
+		*chain = i;
+	}
+}
+
+/**
+ * Create new empty LRUCache. Each entry is charged the length of its
+ * key and value strings, with their terminators, against the byte
+ * budget. At least one budget must be given.
+ *
+ * @param maxEntries the most entries to keep, or 0 for no entry budget
+ * @param maxBytes the most bytes to keep, or 0 for no byte budget
+ * @param evictCallback called with each evicted entry, or NULL
+ * @param evictData data passed to each call of evictCallback
+ * @return new LRUCache, or NULL if neither budget was given
+ */
+LRUCache* createLRUCache(size_t maxEntries, size_t maxBytes,
+	LRUCacheEvictCallback evictCallback, LRUCacheEvictData evictData) {
+	if ((maxEntries == 0 && maxBytes == 0) || maxEntries >= LRU_NO_ENTRY) {
+		return (LRUCache*)NULL;
+	}
+	LRUCache* cache = (LRUCache*)malloc(sizeof(LRUCache));
+
+	// with an entry budget, the table and entry array never grow
+	cache->capacity = LRU_DEFAULT_CAPACITY;
+	while (maxEntries > cache->capacity/4*3) {
+		cache->capacity *= 2;
+	}
+	cache->hashTable = allocLRUCacheTable(cache->capacity);
+	cache->entryCapacity = (maxEntries > 0) ? maxEntries : LRU_DEFAULT_CAPACITY;
+	cache->entries = (LRUCacheEntry*)malloc(cache->entryCapacity * sizeof(LRUCacheEntry));
+	cache->entryCount = 0;
+	cache->freeEntries = LRU_NO_ENTRY;
+	cache->newest = LRU_NO_ENTRY;
+	cache->oldest = LRU_NO_ENTRY;
+	cache->size = 0;
+	cache->seed = createMapEntryKeyHashSeed();
+	cache->maxEntries = maxEntries;
+	cache->maxBytes = maxBytes;
+	cache->bytes = 0;
+	cache->evictCallback = evictCallback;
+	cache->evictData = evictData;
+	cache->hitCount = 0;
+	cache->missCount = 0;
+	cache->evictionCount = 0;
+	return cache;
+}
+
+/**
+ * Frees an LRUCache. The eviction callback is not called.
+ *
+ * @param cache the LRUCache to free
+ */
+void deleteLRUCache(LRUCache* cache) {
+	free(cache->hashTable);
+	free(cache->entries);
+	free(cache);
+}
+
+/**
+ * Removes all of the entries from this cache. The eviction callback
+ * is not called, and the counters are not reset.
+ *
+ * @param cache the LRUCache
+ */
+void clearLRUCache(LRUCache* cache) {
+	for (size_t i = 0; i < cache->capacity; i++) {
+		cache->hashTable[i] = LRU_NO_ENTRY;
+	}
+	cache->entryCount = 0;
+	cache->freeEntries = LRU_NO_ENTRY;
+	cache->newest = LRU_NO_ENTRY;
+	cache->oldest = LRU_NO_ENTRY;
+	cache->size = 0;
+	cache->bytes = 0;
+}
+
+/**
+ * Returns true if this cache contains an entry for the specified key.
+ * The entry is not made the most recently used, and the hit and miss
+ * counters are not changed.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key to check
+ * @return true if the cache contains the key, false otherwise
+ */
+bool containsLRUCacheKey(LRUCache* cache, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, cache->seed);
+	return *findLRUCacheLink(cache, key, hashCode) != LRU_NO_ENTRY;
+}
+
+/**
+ * Returns the value to which the specified key is mapped, and makes its
+ * entry the most recently used. Counts a hit or a miss.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key for the value to get
+ * @return the value for the given key, or NULL if the key is not cached
+ */
+MapValue* getLRUCacheValue(LRUCache* cache, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, cache->seed);
+	LRUCacheIndex index = *findLRUCacheLink(cache, key, hashCode);
+	if (index == LRU_NO_ENTRY) {
+		cache->missCount++;
+		return (MapValue*)NULL;
+	}
+	cache->hitCount++;
+	if (index != cache->newest) {
+		unlinkLRUCacheRecency(cache, index);
+		pushLRUCacheRecency(cache, index);
+	}
+	return cache->entries[index].entry.value;
+}
+
+/**
+ * Associates the specified value with the specified key, and makes its
+ * entry the most recently used. The least recently used entries are
+ * then evicted until the cache is within its budget; the new entry is
+ * kept even if it alone is over the byte budget.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key
+ * @param value the entry value
+ * @return the previous value for the key, or NULL if not cached
+ */
+MapValue* putLRUCacheEntry(LRUCache* cache, MapKey key, MapValue* value) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, cache->seed);
+	LRUCacheIndex* link = findLRUCacheLink(cache, key, hashCode);
+	size_t cost = getLRUCacheEntryCost(cache, key, value);
+	MapValue* oldValue = (MapValue*)NULL;
+	LRUCacheIndex index = *link;
+
+	if (index != LRU_NO_ENTRY) {
+		// replace the value of the cached entry
+		LRUCacheEntry* cacheEntry = &cache->entries[index];
+		oldValue = cacheEntry->entry.value;
+		cacheEntry->entry.value = value;
+		cache->bytes += cost - cacheEntry->cost;
+		cacheEntry->cost = cost;
+		unlinkLRUCacheRecency(cache, index);
+	} else {
+		// make room for the entry within the entry budget
+		if (cache->maxEntries != 0 && cache->size == cache->maxEntries) {
+			evictLRUCacheEntry(cache);
+		}
+		if (cache->freeEntries != LRU_NO_ENTRY) {
+			index = cache->freeEntries;
+			cache->freeEntries = cache->entries[index].nextEntry;
+		} else {
+			if (cache->entryCount == cache->entryCapacity) {
+				cache->entryCapacity *= 2;
+				cache->entries = (LRUCacheEntry*)realloc(
+					cache->entries, cache->entryCapacity * sizeof(LRUCacheEntry));
+			}
+			index = cache->entryCount++;
+		}
+		if (++cache->size > cache->capacity/4*3) {
+			growLRUCacheTable(cache);
+		}
+
+		// splice entry to head of its chain
+		LRUCacheIndex* chain = &cache->hashTable[hashCode & (cache->capacity-1)];
+		LRUCacheEntry* cacheEntry = &cache->entries[index];
+		cacheEntry->entry.key = key;
+		cacheEntry->entry.value = value;
+		cacheEntry->hashCode = hashCode;
+		cacheEntry->cost = cost;
+		cacheEntry->nextEntry = *chain;
+		*chain = index;
+		cache->bytes += cost;
+	}
+	pushLRUCacheRecency(cache, index);
+
+	// evict for the byte budget, keeping the new entry
+	while (cache->maxBytes != 0 && cache->bytes > cache->maxBytes
+		   && cache->oldest != index) {
+		evictLRUCacheEntry(cache);
+	}
+	return oldValue;
+}
+
+/**
+ * Removes the entry for the specified key. The eviction callback is
+ * not called.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key
+ * @return the value for the key, or NULL if the key is not cached
+ */
+MapValue* deleteLRUCacheEntryForKey(LRUCache* cache, MapKey key) {
+	uint64_t hashCode = getMapEntryKeyHashCode(key, cache->seed);
+	LRUCacheIndex* link = findLRUCacheLink(cache, key, hashCode);
+	if (*link == LRU_NO_ENTRY) {
+		return (MapValue*)NULL;
+	}
+	MapValue* value = cache->entries[*link].entry.value;
+	removeLRUCacheEntry(cache, link);
+	return value;
+}
+
+/**
+ * Returns the number of entries in this cache.
+ *
+ * @param cache the LRUCache
+ * @return the number of entries in the cache
+ */
+size_t getLRUCacheSize(LRUCache* cache) {
+	return cache->size;
+}
+
+/**
+ * Returns the number of gets that found their key.
+ *
+ * @param cache the LRUCache
+ * @return the number of hits
+ */
+size_t getLRUCacheHitCount(LRUCache* cache) {
+	return cache->hitCount;
+}
+
+/**
+ * Returns the number of gets that did not find their key.
+ *
+ * @param cache the LRUCache
+ * @return the number of misses
+ */
+size_t getLRUCacheMissCount(LRUCache* cache) {
+	return cache->missCount;
+}
+
+/**
+ * Returns the number of entries evicted to stay within the budget.
+ *
+ * @param cache the LRUCache
+ * @return the number of evictions
+ */
+size_t getLRUCacheEvictionCount(LRUCache* cache) {
+	return cache->evictionCount;
+}
@@ -0,0 +1,186 @@
+/*
+ * lru_cache.h
+ *
+ * This file provides the structures and function declarations of an
+ * LRUCache, which is a HashMap with a budget of entries or bytes that
+ * evicts its least recently used entries to stay within the budget.
+ *
+ * The cache has the layout of the chained HashMap: entries are kept in
+ * an array and linked into hash chains by index. Each entry is also
+ * linked by index into a recency list from the most to the least
+ * recently used entry, so a get moves its entry to the front of the
+ * list and an eviction removes the entry at the back, both in constant
+ * time. The slots of evicted and deleted entries are reused, so entries
+ * never move while they are cached.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef LRU_CACHE_H_
+#define LRU_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "map_entry.h"
+
+/**
+ * Index of an entry in the entry array of an LRUCache
+ */
+typedef uint32_t LRUCacheIndex;
+
+/**
+ * Entry in the entry array, linked into a hash chain and into the
+ * recency list by entry array indexes.
+ */
+typedef struct {
+	MapEntry entry;						// entry key/value pair
+	uint64_t hashCode;					// hash code for the entry key
+	size_t cost;						// bytes charged to the budget
+	LRUCacheIndex nextEntry;			// index of next entry in chain, or
+										// of next free entry
+	LRUCacheIndex newer;				// index of more recently used entry
+	LRUCacheIndex older;				// index of less recently used entry
+} LRUCacheEntry;
+
+/**
+ * Definition covers void* eviction callback data
+ */
+typedef void* LRUCacheEvictData;
+
+/**
+ * Definition of callback that is called with each entry that the
+ * cache evicts to stay within its budget, before it is removed.
+ */
+typedef void (*LRUCacheEvictCallback)(MapEntry*, LRUCacheEvictData);
+
+/**
+ * The cache.
+ */
+typedef struct {
+	LRUCacheIndex* hashTable;			// first entry of each chain
+	size_t capacity;					// the size of the hash table
+	size_t size;						// number of entries in the cache
+	uint64_t seed;						// hash seed for keys of this cache
+	LRUCacheEntry* entries;				// the entry array
+	size_t entryCount;					// entries used, including free
+	size_t entryCapacity;				// size of the entry array
+	LRUCacheIndex freeEntries;			// first free entry
+	LRUCacheIndex newest;				// most recently used entry
+	LRUCacheIndex oldest;				// least recently used entry
+	size_t maxEntries;					// entry budget, or 0 for none
+	size_t maxBytes;					// byte budget, or 0 for none
+	size_t bytes;						// bytes charged for all entries
+	LRUCacheEvictCallback evictCallback;	// called for evictions, or NULL
+	LRUCacheEvictData evictData;		// data for the eviction callback
+	size_t hitCount;					// gets that found their key
+	size_t missCount;					// gets that did not
+	size_t evictionCount;				// entries evicted for the budget
+} LRUCache;
+
+/**
+ * Create new empty LRUCache. Each entry is charged the length of its
+ * key and value strings, with their terminators, against the byte
+ * budget. At least one budget must be given.
+ *
+ * @param maxEntries the most entries to keep, or 0 for no entry budget
+ * @param maxBytes the most bytes to keep, or 0 for no byte budget
+ * @param evictCallback called with each evicted entry, or NULL
+ * @param evictData data passed to each call of evictCallback
+ * @return new LRUCache, or NULL if neither budget was given
+ */
+LRUCache* createLRUCache(size_t maxEntries, size_t maxBytes,
+	LRUCacheEvictCallback evictCallback, LRUCacheEvictData evictData);
+
+/**
+ * Frees an LRUCache. The eviction callback is not called.
+ *
+ * @param cache the LRUCache to free
+ */
+void deleteLRUCache(LRUCache* cache);
+
+/**
+ * Removes all of the entries from this cache. The eviction callback
+ * is not called, and the counters are not reset.
+ *
+ * @param cache the LRUCache
+ */
+void clearLRUCache(LRUCache* cache);
+
+/**
+ * Returns true if this cache contains an entry for the specified key.
+ * The entry is not made the most recently used, and the hit and miss
+ * counters are not changed.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key to check
+ * @return true if the cache contains the key, false otherwise
+ */
+bool containsLRUCacheKey(LRUCache* cache, MapKey key);
+
+/**
+ * Returns the value to which the specified key is mapped, and makes its
+ * entry the most recently used. Counts a hit or a miss.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key for the value to get
+ * @return the value for the given key, or NULL if the key is not cached
+ */
+MapValue* getLRUCacheValue(LRUCache* cache, MapKey key);
+
+/**
+ * Associates the specified value with the specified key, and makes its
+ * entry the most recently used. The least recently used entries are
+ * then evicted until the cache is within its budget; the new entry is
+ * kept even if it alone is over the byte budget.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key
+ * @param value the entry value
+ * @return the previous value for the key, or NULL if not cached
+ */
+MapValue* putLRUCacheEntry(LRUCache* cache, MapKey key, MapValue* value);
+
+/**
+ * Removes the entry for the specified key. The eviction callback is
+ * not called.
+ *
+ * @param cache the LRUCache
+ * @param key the entry key
+ * @return the value for the key, or NULL if the key is not cached
+ */
+MapValue* deleteLRUCacheEntryForKey(LRUCache* cache, MapKey key);
+
+/**
+ * Returns the number of entries in this cache.
+ *
+ * @param cache the LRUCache
+ * @return the number of entries in the cache
+ */
+size_t getLRUCacheSize(LRUCache* cache);
+
+/**
+ * Returns the number of gets that found their key.
+ *
+ * @param cache the LRUCache
+ * @return the number of hits
+ */
+size_t getLRUCacheHitCount(LRUCache* cache);
+
+/**
+ * Returns the number of gets that did not find their key.
+ *
+ * @param cache the LRUCache
+ * @return the number of misses
+ */
+size_t getLRUCacheMissCount(LRUCache* cache);
+
+/**
+ * Returns the number of entries evicted to stay within the budget.
+ *
+ * @param cache the LRUCache
+ * @return the number of evictions
+ */
+size_t getLRUCacheEvictionCount(LRUCache* cache);
+
+#endif /* LRU_CACHE_H_ */
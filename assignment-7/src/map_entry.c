@@ -10,6 +10,7 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include "map_entry.h"
 
@@ -46,28 +47,129 @@ int compareMapValue(MapValue* val1, MapValue* val2) {
 	return strcmp(val1->valuestr, val2->valuestr);
 }
 
+/** Secret constants of the hash function; odd with balanced bits */
+static const uint64_t HASH_SECRET[4] = {
+	0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+	0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+/**
+ * Multiply two 64-bit values into a 128-bit product.
+ *
+ * @param a the first value; set to the low half of the product
+ * @param b the second value; set to the high half of the product
+ */
+static inline void multiplyHashWords(uint64_t* a, uint64_t* b) {
+#ifdef __SIZEOF_INT128__
+	__uint128_t product = (__uint128_t)*a * *b;
+	*a = (uint64_t)product;
+	*b = (uint64_t)(product >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32), carry = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	carry += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+/**
+ * Multiply two 64-bit values and fold the 128-bit product to 64 bits
+ * by xor-ing its high and low halves.
+ *
+ * @param a the first value
+ * @param b the second value
+ * @return the folded product
+ */
+static inline uint64_t mixHashWords(uint64_t a, uint64_t b) {
+	multiplyHashWords(&a, &b);
+	return a ^ b;
+}
+
+/**
+ * Read 8 bytes of a key as a little-endian 64-bit word.
+ *
+ * @param p pointer to the bytes
+ * @return the word
+ */
+static inline uint64_t readHashWord(const unsigned char* p) {
+	uint64_t word;
+	memcpy(&word, p, sizeof word);  // no alignment required
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+	return word;
+}
+
+/**
+ * Read 4 bytes of a key as a little-endian 32-bit word.
+ *
+ * @param p pointer to the bytes
+ * @return the word
+ */
+static inline uint64_t readHashHalfWord(const unsigned char* p) {
+	uint32_t word;
+	memcpy(&word, p, sizeof word);  // no alignment required
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap32(word);
+#endif
+	return word;
+}
+
 /**
  * Compute the hash code for the map entry key.
  *
  * @param key the key
+ * @param seed the hash seed of the map
+ * @return the 64-bit hash code
  */
-int getMapEntryKeyHashCode(MapKey key) {
-	 // Compute the hash code for the map entry key character string.
-	 // The hash code for a string is:
-	 //
-	 // s[0]*31^(n-1) + s[1]*31^(n-2) + ... + s[n-1]
-	 //
-	 // using integer arithmetic, where s[i] is the i-th character of the
-	 // string, n is the length of the string, and '^' is exponentiation.
-	 // The hash value of the empty string is zero.
-	int hashCode = 0;
-	for (int i = 0; key[i] != '\0'; i++) {
-		// special handling of char required because a char
-		// may be signed or unsigned in different compilers;
-		// cast "reinterprets" bits of char as unsigned to
-		// avoid sign-extension when adding it as an int.
-		hashCode = 31 * hashCode + *(unsigned char*)&key[i];
+uint64_t getMapEntryKeyHashCode(MapKey key, uint64_t seed) {
+	// The key is hashed 16 bytes at a time by multiplying two 64-bit
+	// words into a 128-bit product and folding it (the design of wyhash).
+	// Each round mixes every input bit into every output bit, so keys
+	// that differ in one character hash to unrelated values.
+	const unsigned char* p = (const unsigned char*)key;
+	size_t len = strlen(key);
+	uint64_t a, b;
+
+	seed ^= mixHashWords(seed ^ HASH_SECRET[0], HASH_SECRET[1]);
+	if (len <= 16) {
+		if (len >= 4) {
+			// two overlapping pairs of 4-byte reads cover 4..16 bytes
+			size_t mid = (len >> 3) << 2;
+			a = (readHashHalfWord(p) << 32) | readHashHalfWord(p + mid);
+			b = (readHashHalfWord(p + len - 4) << 32) | readHashHalfWord(p + len - 4 - mid);
+		} else if (len > 0) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		for ( ; i > 16; i -= 16, p += 16) {
+			seed = mixHashWords(readHashWord(p) ^ HASH_SECRET[1], readHashWord(p + 8) ^ seed);
+		}
+		// last 16 bytes, overlapping bytes already mixed
+		a = readHashWord(p + i - 16);
+		b = readHashWord(p + i - 8);
 	}
-	return hashCode;
+	a ^= HASH_SECRET[1];
+	b ^= seed;
+	multiplyHashWords(&a, &b);
+	return mixHashWords(a ^ HASH_SECRET[0] ^ len, b ^ HASH_SECRET[1]);
 }
 
+/**
+ * Create a seed for hashing map entry keys. Each call returns a
+ * different seed so that maps do not share a key order.
+ *
+ * @return a new hash seed
+ */
+uint64_t createMapEntryKeyHashSeed(void) {
+	static uint64_t seedCount = 0;
+	uint64_t count = __atomic_add_fetch(&seedCount, 1, __ATOMIC_RELAXED);
+	return mixHashWords(count ^ HASH_SECRET[2], HASH_SECRET[3]);
+}
@@ -11,6 +11,7 @@
 #define MAP_ENTRY_H_
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 /**
@@ -65,7 +66,17 @@ int compareMapValue(MapValue* val1, MapValue* val2);
  * Compute the hash code for the map entry key.
  *
  * @param key the key
+ * @param seed the hash seed of the map
+ * @return the 64-bit hash code
  */
-int getMapEntryKeyHashCode(MapKey key);
+uint64_t getMapEntryKeyHashCode(MapKey key, uint64_t seed);
+
+/**
+ * Create a seed for hashing map entry keys. Each call returns a
+ * different seed so that maps do not share a key order.
+ *
+ * @return a new hash seed
+ */
+uint64_t createMapEntryKeyHashSeed(void);
 
 #endif /* TREE_MAP_ENTRY_H */
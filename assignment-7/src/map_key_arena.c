@@ -0,0 +1,98 @@
+/*
+ * map_key_arena.c
+ *
+ * This file provides the implementation of a MapKeyArena, which holds
+ * copies of map keys.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "map_key_arena.h"
+
+#ifndef MIN_ARENA_BLOCK_SIZE
+#define MIN_ARENA_BLOCK_SIZE 4096			// size of the first block
+#endif
+
+#ifndef MAX_ARENA_BLOCK_SIZE
+#define MAX_ARENA_BLOCK_SIZE (1024*1024)	// largest block, unless a key needs more
+#endif
+
+/**
+ * Create a new empty MapKeyArena.
+ *
+ * @return the new arena
+ */
+MapKeyArena* createMapKeyArena(void) {
+	MapKeyArena* arena = (MapKeyArena*)malloc(sizeof(MapKeyArena));
+	arena->blocks = (MapKeyArenaBlock*)NULL;
+	arena->used = 0;
+	return arena;
+}
+
+/**
+ * Frees a MapKeyArena and all the keys in it.
+ *
+ * @param arena the arena
+ */
+void deleteMapKeyArena(MapKeyArena* arena) {
+	clearMapKeyArena(arena);
+	free(arena);
+}
+
+/**
+ * Frees all the keys in a MapKeyArena.
+ *
+ * @param arena the arena
+ */
+void clearMapKeyArena(MapKeyArena* arena) {
+	while (arena->blocks != (MapKeyArenaBlock*)NULL) {
+		MapKeyArenaBlock* block = arena->blocks;
+		arena->blocks = block->next;
+		free(block);
+	}
+	arena->used = 0;
+}
+
+/**
+ * Copies a key into the arena. The copy is null-terminated, and
+ * its length can be found with getArenaMapKeyLength().
+ *
+ * @param arena the arena
+ * @param key the key
+ * @param length the length of the key
+ * @return the copy of the key
+ */
+MapKey copyMapKeyToArena(MapKeyArena* arena, MapKey key, size_t length) {
+	// length prefix, key and terminator, rounded up to keep prefixes aligned
+	size_t size = (sizeof(uint32_t) + length + 1 + sizeof(uint32_t)-1)
+		& ~(sizeof(uint32_t)-1);
+	if (arena->blocks == (MapKeyArenaBlock*)NULL
+		|| arena->used + size > arena->blocks->size) {
+		// each block is twice the size of the last, up to a limit
+		size_t blockSize = (arena->blocks == (MapKeyArenaBlock*)NULL)
+			? MIN_ARENA_BLOCK_SIZE : 2*arena->blocks->size;
+		if (blockSize > MAX_ARENA_BLOCK_SIZE) {
+			blockSize = MAX_ARENA_BLOCK_SIZE;
+		}
+		if (blockSize < size) {
+			blockSize = size;
+		}
+		MapKeyArenaBlock* block =
+			(MapKeyArenaBlock*)malloc(sizeof(MapKeyArenaBlock) + blockSize);
+		block->next = arena->blocks;
+		block->size = blockSize;
+		arena->blocks = block;
+		arena->used = 0;
+	}
+
+	char* copy = &arena->blocks->data[arena->used];
+	uint32_t keyLength = (uint32_t)length;
+	memcpy(copy, &keyLength, sizeof(uint32_t));
+	memcpy(copy + sizeof(uint32_t), key, length);
+	copy[sizeof(uint32_t) + length] = '\0';
+	arena->used += size;
+	return copy + sizeof(uint32_t);
+}
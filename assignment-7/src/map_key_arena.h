@@ -0,0 +1,108 @@
+/*
+ * map_key_arena.h
+ *
+ * This file provides the structures and function declarations of a
+ * MapKeyArena, which holds copies of map keys. Keys are copied one
+ * after another into large blocks, each preceded by its length, and
+ * are only freed all at once.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef MAP_KEY_ARENA_H_
+#define MAP_KEY_ARENA_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "map_entry.h"
+
+/**
+ * A block of the arena.
+ */
+typedef struct MapKeyArenaBlock {
+	struct MapKeyArenaBlock* next;		// the previous block
+	size_t size;						// size of data in bytes
+	char data[];						// the key copies
+} MapKeyArenaBlock;
+
+/**
+ * The arena.
+ */
+typedef struct {
+	MapKeyArenaBlock* blocks;			// the newest block, or NULL
+	size_t used;						// bytes used in the newest block
+} MapKeyArena;
+
+/**
+ * Create a new empty MapKeyArena.
+ *
+ * @return the new arena
+ */
+MapKeyArena* createMapKeyArena(void);
+
+/**
+ * Frees a MapKeyArena and all the keys in it.
+ *
+ * @param arena the arena
+ */
+void deleteMapKeyArena(MapKeyArena* arena);
+
+/**
+ * Frees all the keys in a MapKeyArena.
+ *
+ * @param arena the arena
+ */
+void clearMapKeyArena(MapKeyArena* arena);
+
+/**
+ * Copies a key into the arena. The copy is null-terminated, and
+ * its length can be found with getArenaMapKeyLength().
+ *
+ * @param arena the arena
+ * @param key the key
+ * @param length the length of the key
+ * @return the copy of the key
+ */
+MapKey copyMapKeyToArena(MapKeyArena* arena, MapKey key, size_t length);
+
+/**
+ * Returns the length of a key that was copied into an arena.
+ *
+ * @param key the copy of the key
+ * @return the length of the key
+ */
+static inline size_t getArenaMapKeyLength(MapKey key) {
+	uint32_t length;
+	memcpy(&length, key - sizeof(uint32_t), sizeof(uint32_t));
+	return length;
+}
+
+/**
+ * Returns true if a key equals the key of a map entry whose hash code
+ * matches. If the map owns its keys, the entry key is a copy in the
+ * arena, and the keys are compared by length and then by memcmp;
+ * otherwise by strcmp.
+ *
+ * @param arena the arena of the map, or NULL if the map does not
+ *   own its keys
+ * @param key the key
+ * @param keyLength the length of the key, or SIZE_MAX if not yet
+ *   known; set to the length the first time it is needed
+ * @param entryKey the key of the map entry
+ * @return true if the keys are equal
+ */
+static inline bool isEqualMapEntryKey(
+	MapKeyArena* arena, MapKey key, size_t* keyLength, MapKey entryKey) {
+	if (arena == (MapKeyArena*)NULL) {
+		return compareMapKey(key, entryKey) == 0;
+	}
+	if (*keyLength == SIZE_MAX) {
+		*keyLength = strlen(key);
+	}
+	return getArenaMapKeyLength(entryKey) == *keyLength
+		&& memcmp(key, entryKey, *keyLength) == 0;
+}
+
+#endif /* MAP_KEY_ARENA_H_ */
@@ -0,0 +1,260 @@
+/*
+ * sorted_key_view.c
+ *
+ * This file provides the implementation of a SortedKeyView of the keys
+ * of a HashSet or HashMap.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "sorted_key_view.h"
+
+/** Changes that are merged even into a view of fewer keys */
+#define MIN_MERGED_CHANGES 16
+
+/** Marks an unused slot of the table of changed keys */
+#define NO_CHANGE ((size_t)-1)
+
+/**
+ * Create new SortedKeyView that must be sorted before it is used.
+ *
+ * @return new SortedKeyView
+ */
+SortedKeyView* createSortedKeyView(void) {
+	SortedKeyView* view = (SortedKeyView*)malloc(sizeof(SortedKeyView));
+	view->keys = (MapKey*)NULL;
+	view->size = 0;
+	view->capacity = 0;
+	view->changes = (SortedKeyChange*)NULL;
+	view->nChanges = 0;
+	view->changeCapacity = 0;
+	view->isStale = true;
+	return view;
+}
+
+/**
+ * Frees a SortedKeyView.
+ *
+ * @param view the SortedKeyView to free
+ */
+void deleteSortedKeyView(SortedKeyView* view) {
+	free(view->changes);
+	free(view->keys);
+	free(view);
+}
+
+/**
+ * Records a key that was added to or deleted from the set or map.
+ *
+ * @param view the SortedKeyView
+ * @param key the key
+ * @param isAdded true if the key was added, false if deleted
+ */
+void addSortedKeyViewChange(SortedKeyView* view, MapKey key, bool isAdded) {
+	if (view->isStale) {
+		return;
+	}
+	if (view->nChanges >= view->size + MIN_MERGED_CHANGES) {
+		// sorting every key is now no more work than merging
+		invalidateSortedKeyView(view);
+		return;
+	}
+	if (view->nChanges == view->changeCapacity) {
+		view->changeCapacity = (view->changeCapacity < 8) ? 8 : 2*view->changeCapacity;
+		view->changes = (SortedKeyChange*)realloc(view->changes,
+			view->changeCapacity * sizeof(SortedKeyChange));
+	}
+	view->changes[view->nChanges++] = (SortedKeyChange){ key, isAdded };
+}
+
+/**
+ * Removes all keys and changes from a SortedKeyView, for a set or map
+ * that was cleared.
+ *
+ * @param view the SortedKeyView
+ */
+void clearSortedKeyView(SortedKeyView* view) {
+	view->size = 0;
+	view->nChanges = 0;
+	view->isStale = false;
+}
+
+/**
+ * Marks a SortedKeyView to be sorted again, for a set or map whose
+ * keys moved to other addresses.
+ *
+ * @param view the SortedKeyView
+ */
+void invalidateSortedKeyView(SortedKeyView* view) {
+	view->nChanges = 0;
+	view->isStale = true;
+}
+
+/**
+ * Makes room in a SortedKeyView for the specified number of keys.
+ *
+ * @param view the SortedKeyView
+ * @param nKeys the number of keys
+ */
+static void reserveSortedKeyView(SortedKeyView* view, size_t nKeys) {
+	if (nKeys > view->capacity) {
+		view->capacity = (nKeys < 2*view->capacity) ? 2*view->capacity : nKeys;
+		view->keys = (MapKey*)realloc(view->keys, view->capacity * sizeof(MapKey));
+	}
+}
+
+/**
+ * Empties a SortedKeyView and returns room for the specified number of
+ * keys. The caller stores the keys of the set or map there, in any
+ * order, then calls sortSortedKeyView().
+ *
+ * @param view the SortedKeyView
+ * @param nKeys the number of keys
+ * @return the array to store the keys in
+ */
+MapKey* prepareSortedKeyView(SortedKeyView* view, size_t nKeys) {
+	reserveSortedKeyView(view, nKeys);
+	view->size = nKeys;
+	return view->keys;
+}
+
+/**
+ * Compares two keys for qsort().
+ *
+ * @param key1 pointer to the first key
+ * @param key2 pointer to the second key
+ * @return <0, 0 or >0 as the first key is less than, equal to or greater
+ *   than the second
+ */
+static int compareSortedKeys(const void* key1, const void* key2) {
+	return strcmp(*(const MapKey*)key1, *(const MapKey*)key2);
+}
+
+/**
+ * Sorts the keys stored after prepareSortedKeyView().
+ *
+ * @param view the SortedKeyView
+ */
+void sortSortedKeyView(SortedKeyView* view) {
+	if (view->size > 1) {
+		qsort(view->keys, view->size, sizeof(MapKey), compareSortedKeys);
+	}
+	view->nChanges = 0;
+	view->isStale = false;
+}
+
+/**
+ * Finds the slot of a key in a table of changed keys by its address,
+ * or the empty slot where it belongs.
+ *
+ * @param view the SortedKeyView
+ * @param lastChanges the index of the last change of each key in the table
+ * @param tableBits the log2 of the size of the table
+ * @param key the key
+ * @return the slot of the key
+ */
+static size_t findChangedKeySlot(SortedKeyView* view, size_t* lastChanges,
+	unsigned tableBits, MapKey key) {
+	size_t mask = ((size_t)1 << tableBits) - 1;
+	size_t slot = (size_t)(((uint64_t)(uintptr_t)key * 0x9e3779b97f4a7c15ULL) >> (64 - tableBits));
+	while (   lastChanges[slot] != NO_CHANGE
+		   && view->changes[lastChanges[slot]].key != key) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/**
+ * Merges the changes recorded since the view was sorted into its keys.
+ * The view must not be stale.
+ *
+ * @param view the SortedKeyView
+ */
+void updateSortedKeyView(SortedKeyView* view) {
+	if (view->nChanges == 0) {
+		return;
+	}
+
+	// find the last change of each changed key; a key may have been
+	// deleted and added again, or freed and its address reused
+	unsigned tableBits = 1;
+	while (((size_t)1 << tableBits) < 2*view->nChanges) {
+		tableBits++;
+	}
+	size_t* lastChanges = (size_t*)malloc(sizeof(size_t) << tableBits);
+	memset(lastChanges, 0xff, sizeof(size_t) << tableBits);	// all NO_CHANGE
+	for (size_t i = 0; i < view->nChanges; i++) {
+		lastChanges[findChangedKeySlot(view, lastChanges, tableBits, view->changes[i].key)] = i;
+	}
+
+	// sort the keys whose last change added them
+	MapKey* added = (MapKey*)malloc(view->nChanges * sizeof(MapKey));
+	size_t nAdded = 0;
+	for (size_t slot = 0; slot < ((size_t)1 << tableBits); slot++) {
+		if (lastChanges[slot] != NO_CHANGE && view->changes[lastChanges[slot]].isAdded) {
+			added[nAdded++] = view->changes[lastChanges[slot]].key;
+		}
+	}
+	qsort(added, nAdded, sizeof(MapKey), compareSortedKeys);
+
+	// drop every changed key from the sorted keys, without reading it
+	size_t count = 0;
+	for (size_t i = 0; i < view->size; i++) {
+		MapKey key = view->keys[i];
+		if (lastChanges[findChangedKeySlot(view, lastChanges, tableBits, key)] == NO_CHANGE) {
+			view->keys[count++] = key;
+		}
+	}
+
+	// merge the added keys in from the end, finding the place of each
+	// by binary search and moving the keys after it up as a block
+	view->size = count + nAdded;
+	reserveSortedKeyView(view, view->size);
+	while (nAdded > 0) {
+		MapKey key = added[--nAdded];
+		size_t low = 0;
+		size_t high = count;
+		while (low < high) {
+			size_t mid = low + (high - low) / 2;
+			if (strcmp(view->keys[mid], key) < 0) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		memmove(&view->keys[low + nAdded + 1], &view->keys[low],
+				(count - low) * sizeof(MapKey));
+		view->keys[low + nAdded] = key;
+		count = low;
+	}
+	free(added);
+	free(lastChanges);
+	view->nChanges = 0;
+}
+
+/**
+ * Returns the index of the first key of an up-to-date SortedKeyView
+ * that is not less than the specified key.
+ *
+ * @param view the SortedKeyView
+ * @param key the key
+ * @return the index of the key, or the size of the view if all keys
+ *   are less than the key
+ */
+size_t findSortedKeyViewLowerBound(SortedKeyView* view, MapKey key) {
+	size_t low = 0;
+	size_t high = view->size;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (strcmp(view->keys[mid], key) < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
@@ -0,0 +1,129 @@
+/*
+ * sorted_key_view.h
+ *
+ * This file provides the structures and function declarations of a
+ * SortedKeyView, which keeps the keys of a HashSet or HashMap in
+ * increasing order for ordered iteration and lower-bound lookups.
+ *
+ * The set or map creates its view on the first request for sorted
+ * keys, and from then on records each key it adds or deletes. The next
+ * request sorts only the keys that changed and merges them into the
+ * sorted keys by binary search, so k changes cost O(k log n) key
+ * comparisons rather than a sort of every key. The merge still scans
+ * and moves every key pointer, so each refresh is O(n). Once more keys
+ * have changed than are in the view, the view is sorted again from
+ * scratch instead.
+ *
+ * Changes are recorded by key address, and the key of a deleted entry
+ * is never read, so keys may be freed once they are deleted.
+ *
+ * @since 2017-03-22
+ * @author philip gust
+ */
+
+#ifndef SORTED_KEY_VIEW_H_
+#define SORTED_KEY_VIEW_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "map_entry.h"
+
+/**
+ * A key that was added or deleted since the view was sorted.
+ */
+typedef struct {
+	MapKey key;							// the key
+	bool isAdded;						// true if added, false if deleted
+} SortedKeyChange;
+
+/**
+ * The view.
+ */
+typedef struct {
+	MapKey* keys;						// the keys in increasing order
+	size_t size;						// number of sorted keys
+	size_t capacity;					// size of the key array
+	SortedKeyChange* changes;			// changes in the order made
+	size_t nChanges;					// number of changes
+	size_t changeCapacity;				// size of the change array
+	bool isStale;						// true if the keys must be sorted
+										// again from the set or map
+} SortedKeyView;
+
+/**
+ * Create new SortedKeyView that must be sorted before it is used.
+ *
+ * @return new SortedKeyView
+ */
+SortedKeyView* createSortedKeyView(void);
+
+/**
+ * Frees a SortedKeyView.
+ *
+ * @param view the SortedKeyView to free
+ */
+void deleteSortedKeyView(SortedKeyView* view);
+
+/**
+ * Records a key that was added to or deleted from the set or map.
+ *
+ * @param view the SortedKeyView
+ * @param key the key
+ * @param isAdded true if the key was added, false if deleted
+ */
+void addSortedKeyViewChange(SortedKeyView* view, MapKey key, bool isAdded);
+
+/**
+ * Removes all keys and changes from a SortedKeyView, for a set or map
+ * that was cleared.
+ *
+ * @param view the SortedKeyView
+ */
+void clearSortedKeyView(SortedKeyView* view);
+
+/**
+ * Marks a SortedKeyView to be sorted again, for a set or map whose
+ * keys moved to other addresses.
+ *
+ * @param view the SortedKeyView
+ */
+void invalidateSortedKeyView(SortedKeyView* view);
+
+/**
+ * Empties a SortedKeyView and returns room for the specified number of
+ * keys. The caller stores the keys of the set or map there, in any
+ * order, then calls sortSortedKeyView().
+ *
+ * @param view the SortedKeyView
+ * @param nKeys the number of keys
+ * @return the array to store the keys in
+ */
+MapKey* prepareSortedKeyView(SortedKeyView* view, size_t nKeys);
+
+/**
+ * Sorts the keys stored after prepareSortedKeyView().
+ *
+ * @param view the SortedKeyView
+ */
+void sortSortedKeyView(SortedKeyView* view);
+
+/**
+ * Merges the changes recorded since the view was sorted into its keys.
+ * The view must not be stale.
+ *
+ * @param view the SortedKeyView
+ */
+void updateSortedKeyView(SortedKeyView* view);
+
+/**
+ * Returns the index of the first key of an up-to-date SortedKeyView
+ * that is not less than the specified key.
+ *
+ * @param view the SortedKeyView
+ * @param key the key
+ * @return the index of the key, or the size of the view if all keys
+ *   are less than the key
+ */
+size_t findSortedKeyViewLowerBound(SortedKeyView* view, MapKey key);
+
+#endif /* SORTED_KEY_VIEW_H_ */